@@ -0,0 +1,322 @@
+#include "rv_assembler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <typeinfo>
+#include <vector>
+
+#define CTRE_ENABLE_LITERALS
+#include <ctre.hpp>
+
+/*
+rv::assemble (tokenizer + perfect-hash dispatch, parallel pass 2) vs the CTRE assembler it
+replaced. Both assemble the same generated source: every mnemonic, labels, comments and
+blank lines, several MB of it. Prints lines/s for the old assembler, the new one on one
+thread and on all threads, and assemble_file on an mmapped copy. The words must be
+identical, and a set of broken sources must fail the same way in both. Also checks that
+a compile-time image (assemble_static) matches the runtime one. Exits nonzero otherwise.
+*/
+
+using namespace std::chrono;
+
+/* the regex-per-shape assembler rv::assemble used to be, unchanged apart from the namespace */
+namespace legacy {
+
+using namespace rv;
+
+struct AluOp { std::string_view name, imm_name; std::uint8_t f3, f7; };
+constexpr std::array alu_ops{
+    AluOp{"add",  "addi",  0b000, 0b0000000}, AluOp{"sub", "",     0b000, 0b0100000},
+    AluOp{"sll",  "slli",  0b001, 0b0000000}, AluOp{"slt", "slti", 0b010, 0b0000000},
+    AluOp{"sltu", "sltiu", 0b011, 0b0000000}, AluOp{"xor", "xori", 0b100, 0b0000000},
+    AluOp{"srl",  "srli",  0b101, 0b0000000}, AluOp{"sra", "srai", 0b101, 0b0100000},
+    AluOp{"or",   "ori",   0b110, 0b0000000}, AluOp{"and", "andi", 0b111, 0b0000000},
+};
+
+constexpr AluOp alu_op(std::string_view s)
+{
+    auto it = std::find_if(alu_ops.begin(), alu_ops.end(),
+                           [&](const AluOp& o){ return o.name == s || o.imm_name == s; });
+    if (s.empty() || it == alu_ops.end())
+        throw std::invalid_argument(std::format("bad op '{}'", s));
+    return *it;
+}
+
+constexpr std::uint8_t branch_f3(std::string_view s)
+{
+    constexpr std::array names{ "beq", "bne", "", "", "blt", "bge", "bltu", "bgeu" };
+    auto it = std::find(names.begin(), names.end(), s);
+    if (it == names.end() || s.empty())
+        throw std::invalid_argument(std::format("bad branch '{}'", s));
+    return static_cast<std::uint8_t>(it - names.begin());
+}
+
+constexpr std::uint8_t regnum(std::string_view s)
+{
+    auto it = std::find(reg_names.begin(), reg_names.end(), s);
+    if (it == reg_names.end())
+        throw std::invalid_argument(std::format("bad reg '{}'", s));
+    return static_cast<std::uint8_t>(it - reg_names.begin());
+}
+
+inline std::optional<std::uint32_t>
+assemble_line(std::string_view ln, std::size_t pc, const std::unordered_map<std::string,std::size_t>& labels)
+{
+    if (auto m = ctre::match<"(add|sub|sll|sltu|slt|xor|srl|sra|or|and)\\s+(\\w+),\\s*(\\w+),\\s*(\\w+)">(ln)) {
+        const auto op = alu_op(m.get<1>());
+        return R({ regnum(m.get<2>()), regnum(m.get<3>()), regnum(m.get<4>()), op.f3, op.f7 }, Opcode::OP);
+    }
+    if (auto m = ctre::match<"(addi|sltiu|slti|xori|ori|andi)\\s+(\\w+),\\s*(\\w+),\\s*(-?\\d+)">(ln))
+        return I({ regnum(m.get<2>()), regnum(m.get<3>()), alu_op(m.get<1>()).f3,
+                   std::stoi(std::string{m.get<4>()}) }, Opcode::OP_IMM);
+    if (auto m = ctre::match<"(slli|srli|srai)\\s+(\\w+),\\s*(\\w+),\\s*(\\d+)">(ln)) {
+        const auto op = alu_op(m.get<1>());
+        return I({ regnum(m.get<2>()), regnum(m.get<3>()), op.f3,
+                   (std::stoi(std::string{m.get<4>()}) & 31) | (op.f7 << 5) }, Opcode::OP_IMM);
+    }
+    if (auto m = ctre::match<"jalr\\s+(\\w+),\\s*(\\w+),\\s*(-?\\d+)">(ln))
+        return I({ regnum(m.get<1>()), regnum(m.get<2>()), 0b000, std::stoi(std::string{m.get<3>()}) }, Opcode::JALR);
+    if (auto m = ctre::match<"lw\\s+(\\w+),\\s*(-?\\d+)\\(\\s*(\\w+)\\s*\\)">(ln))
+        return I({ regnum(m.get<1>()), regnum(m.get<3>()), 0b010, std::stoi(std::string{m.get<2>()}) }, Opcode::LOAD);
+    if (auto m = ctre::match<"jalr\\s+(\\w+),\\s*(-?\\d+)\\(\\s*(\\w+)\\s*\\)">(ln))
+        return I({ regnum(m.get<1>()), regnum(m.get<3>()), 0b000, std::stoi(std::string{m.get<2>()}) }, Opcode::JALR);
+    if (ctre::match<"fence">(ln))
+        return I({ 0, 0, 0b000, 0x0FF }, Opcode::MISC_MEM);
+    if (auto m = ctre::match<"sw\\s+(\\w+),\\s*(-?\\d+)\\(\\s*(\\w+)\\s*\\)">(ln))
+        return S({ regnum(m.get<1>()), regnum(m.get<3>()), 0b010, std::stoi(std::string{m.get<2>()}) }, Opcode::STORE);
+    if (auto m = ctre::match<"sb\\s+(\\w+),\\s*(-?\\d+)\\(\\s*(\\w+)\\s*\\)">(ln))
+        return S({ regnum(m.get<1>()), regnum(m.get<3>()), 0b000, std::stoi(std::string{m.get<2>()}) }, Opcode::STORE);
+    if (auto m = ctre::match<"lui\\s+(\\w+),\\s*(\\d+)">(ln))
+        return U({ regnum(m.get<1>()), std::stoi(std::string{m.get<2>()}) & 0xFFFFF }, Opcode::LUI);
+    if (auto m = ctre::match<"(beq|bne|bltu|bgeu|blt|bge)\\s+(\\w+),\\s*(\\w+),\\s*(\\w+)">(ln)) {
+        auto tgt = labels.at(std::string{m.get<4>()});
+        std::int32_t off = static_cast<std::int32_t>(tgt) - static_cast<std::int32_t>(pc);
+        return B({ regnum(m.get<3>()), regnum(m.get<2>()), branch_f3(m.get<1>()), off }, Opcode::BRANCH);
+    }
+    if (auto m = ctre::match<"jal\\s+(\\w+),\\s*(\\w+)">(ln)) {
+        auto tgt = labels.at(std::string{m.get<2>()});
+        std::int32_t off = static_cast<std::int32_t>(tgt) - static_cast<std::int32_t>(pc);
+        return J({ regnum(m.get<1>()), off }, Opcode::JAL);
+    }
+    return std::nullopt;
+}
+
+inline std::vector<std::uint32_t> assemble(std::string_view src)
+{
+    std::vector<std::string_view> lines;
+    for (std::size_t b = 0, e; b < src.size(); b = e + 1) {
+        e = src.find_first_of("\r\n", b);
+        if (e == std::string_view::npos) e = src.size();
+        auto ln = src.substr(b, e - b);
+        if (auto c = ln.find('#'); c != std::string_view::npos) ln = ln.substr(0, c);
+        auto first = ln.find_first_not_of(" \t");
+        if (first == std::string_view::npos) { lines.emplace_back(); continue; }
+        auto last = ln.find_last_not_of(" \t");
+        lines.push_back(ln.substr(first, last - first + 1));
+    }
+
+    std::unordered_map<std::string,std::size_t> labels;
+    std::size_t pc = 0;
+    for (auto& ln : lines) {
+        if (ln.empty()) continue;
+        if (auto m = ctre::match<R"(^(\w+):)">(ln)) {
+            labels.emplace(std::string{m.get<1>()}, pc);
+            ln.remove_prefix(m.get<0>().to_view().size());
+            if (auto pos = ln.find_first_not_of(" \t"); pos != std::string_view::npos)
+                ln.remove_prefix(pos);
+            else
+                ln = {};
+        }
+        if (!ln.empty()) pc += 4;
+    }
+
+    std::vector<std::uint32_t> words;
+    words.reserve(pc / 4);
+    pc = 0;
+    for (auto const& ln : lines) {
+        if (ln.empty()) continue;
+        auto word = assemble_line(ln, pc, labels);
+        if (!word)
+            throw std::runtime_error(std::format("syntax error: '{}'", ln));
+        words.push_back(*word);
+        pc += 4;
+    }
+    return words;
+}
+
+} // namespace legacy
+
+static constexpr std::size_t block_instrs = 48;     // instructions between labels
+static constexpr std::size_t blocks       = 1 << 13; // ~400K instructions, ~9 MB of source
+
+/* blocks of random instructions under a label each; branches and jumps target nearby blocks */
+static std::string make_source(std::size_t n_blocks)
+{
+    std::mt19937 rng{ 43 };
+    const auto pick = [&](int lo, int hi) { return std::uniform_int_distribution<int>{ lo, hi }(rng); };
+    const auto reg  = [&] { return std::format("x{}", pick(0, 31)); };
+    const auto near = [&](std::size_t b) {
+        const auto lo = b >= 8 ? b - 8 : 0, hi = std::min(n_blocks - 1, b + 8);
+        return std::format("block_{}", lo + static_cast<std::size_t>(pick(0, static_cast<int>(hi - lo))));
+    };
+    constexpr std::array rrr{ "add", "sub", "sll", "slt", "sltu", "xor", "srl", "sra", "or", "and" };
+    constexpr std::array rri{ "addi", "slti", "sltiu", "xori", "ori", "andi" };
+    constexpr std::array sh { "slli", "srli", "srai" };
+    constexpr std::array br { "beq", "bne", "blt", "bge", "bltu", "bgeu" };
+
+    std::string s;
+    s.reserve(n_blocks * block_instrs * 28);
+    for (std::size_t b = 0; b < n_blocks; ++b) {
+        s += std::format("# ---- block {} ----\nblock_{}:\n", b, b);
+        for (std::size_t i = 0; i < block_instrs; ++i) {
+            std::string ln;
+            switch (pick(0, 11)) {
+              case 0: case 1: case 2:
+                ln = std::format("{} {}, {}, {}", rrr[static_cast<std::size_t>(pick(0, 9))], reg(), reg(), reg()); break;
+              case 3: case 4:
+                ln = std::format("{} {}, {}, {}", rri[static_cast<std::size_t>(pick(0, 5))], reg(), reg(), pick(-2048, 2047)); break;
+              case 5:
+                ln = std::format("{} {}, {}, {}", sh[static_cast<std::size_t>(pick(0, 2))], reg(), reg(), pick(0, 31)); break;
+              case 6:
+                ln = std::format("lw {}, {}({})", reg(), pick(-512, 512) * 4, reg()); break;
+              case 7:
+                ln = pick(0, 1) ? std::format("sw {}, {}( {} )", reg(), pick(-512, 512) * 4, reg())
+                                : std::format("sb {}, {}({})", reg(), pick(-2048, 2047), reg()); break;
+              case 8:
+                ln = std::format("lui {}, {}", reg(), pick(0, 0xFFFFF)); break;
+              case 9:
+                ln = std::format("{} {}, {}, {}", br[static_cast<std::size_t>(pick(0, 5))], reg(), reg(), near(b)); break;
+              case 10:
+                ln = pick(0, 1) ? std::format("jal {}, {}", reg(), near(b))
+                                : std::format("jalr {}, {}({})", reg(), pick(-64, 64), reg()); break;
+              default:
+                ln = pick(0, 3) ? std::format("jalr {}, {}, {}", reg(), reg(), pick(-64, 64)) : std::string{ "fence" }; break;
+            }
+            s += pick(0, 1) ? "    " : "\t";
+            s += ln;
+            if (pick(0, 7) == 0) s += "   # comment";
+            s += '\n';
+            if (pick(0, 15) == 0) s += '\n';
+        }
+    }
+    return s;
+}
+
+/* one line of every shape, assembled at compile time as well as at run time */
+static constexpr rv::AsmText every_form{ R"(
+top:
+    add x1, x2, x3
+    sub x4, x5, x6
+    sra x7, x8, x9
+    sltu x10, x11, x12
+    addi x1, x2, -2048
+    sltiu x3, x4, 2047
+    andi x5, x6, -1
+    slli x1, x2, 31
+    srai x3, x4, 7
+    lw x5, -4(x6)
+    sw x7, 8( x8 )
+    sb x9, -1(x10)
+    lui x11, 1048575
+    jalr x1, x2, 12
+    jalr x0, 0(x1)
+bottom:
+    beq x1, x2, top
+    bgeu x3, x4, bottom
+    blt x5, x6, end
+    jal x1, top
+    fence
+end:
+    jal x0, end
+)" };
+
+template <class F>
+static double best_seconds(int reps, F&& body)
+{
+    double best = 1e30;
+    for (int r = 0; r < reps; ++r) {
+        auto t0 = steady_clock::now();
+        body();
+        best = std::min(best, duration<double>(steady_clock::now() - t0).count());
+    }
+    return best;
+}
+
+/* the type and text of what `f` throws, or "ok" */
+template <class F>
+static std::string outcome(F&& f)
+{
+    try { f(); return "ok"; }
+    catch (const std::exception& e) { return std::format("{}: {}", typeid(e).name(), e.what()); }
+}
+
+int main(int argc, char** argv)
+{
+    const std::size_t n_blocks = argc > 1 ? std::stoul(argv[1]) : blocks;
+    const int         reps     = argc > 2 ? std::stoi(argv[2]) : 3;
+
+    const std::string src   = make_source(n_blocks);
+    const auto        lines = static_cast<double>(std::count(src.begin(), src.end(), '\n'));
+    const auto path = std::filesystem::temp_directory_path() / "asm_bench.s";
+    std::ofstream{ path, std::ios::binary } << src;
+
+    std::cout << std::format("source: {:.0f} lines, {:.1f} MB, {} instructions\n\n",
+                             lines, static_cast<double>(src.size()) / 1e6, n_blocks * block_instrs);
+
+    bool ok = true;
+    std::vector<std::uint32_t> ref, got;
+    const unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+
+    struct Row { std::string name; double s; };
+    std::vector<Row> rows;
+    rows.push_back({ "ctre (old)",                  best_seconds(reps, [&] { ref = legacy::assemble(src); }) });
+    rows.push_back({ "tokenizer, 1 thread",         best_seconds(reps, [&] { got = rv::assemble(src, 1); }) });
+    ok &= got == ref;
+    rows.push_back({ std::format("tokenizer, {} thread(s)", hw), best_seconds(reps, [&] { got = rv::assemble(src, hw); }) });
+    ok &= got == ref;
+    rows.push_back({ "assemble_file (mmap)",        best_seconds(reps, [&] { got = rv::assemble_file(path.string()); }) });
+    ok &= got == ref;
+    std::filesystem::remove(path);
+
+    std::cout << std::format("{:<24}{:>10}{:>14}{:>10}\n", "assembler", "ms", "Mlines/s", "speedup");
+    for (const auto& r : rows)
+        std::cout << std::format("{:<24}{:>10.1f}{:>14.2f}{:>9.1f}x\n",
+                                 r.name, r.s * 1e3, lines / r.s / 1e6, rows.front().s / r.s);
+    std::cout << std::format("\nwords: {}\n", got == ref ? "identical" : "MISMATCH");
+
+    /* broken sources fail with the same exception in both; unknown labels and overflowing immediates only by type (their messages are new) */
+    constexpr std::array bad{
+        "addi x1, x2, 1\nadd x1, x2",             "loop: addi x1, x1, 1",       "addi x1, x99, 1",
+        "lw x1, 4(x32)",                          "lui x1, -1",
+        "slli x1, x2, -1",                        "fence x1",                   "add x1 , x2, x3",
+        "mul x1, x2, x3",                         "addi x01, x2, 1",            "sw x1, 4 (x2)",
+    };
+    constexpr std::array type_only{ "beq x1, x2, nowhere", "start:\njal x1, nowhere", "addi x1, x2, 99999999999" };
+    for (std::string_view s : bad) {
+        const auto a = outcome([&] { (void)legacy::assemble(s); });
+        const auto b = outcome([&] { (void)rv::assemble(s); });
+        if (a != b) { ok = false; std::cout << std::format("error mismatch on '{}':\n  old: {}\n  new: {}\n", s, a, b); }
+    }
+    for (std::string_view s : type_only) {
+        const auto a = outcome([&] { (void)legacy::assemble(s); });
+        const auto b = outcome([&] { (void)rv::assemble(s); });
+        if (a.substr(0, a.find(':')) != b.substr(0, b.find(':'))) {
+            ok = false; std::cout << std::format("error mismatch on '{}':\n  old: {}\n  new: {}\n", s, a, b);
+        }
+    }
+    std::cout << std::format("errors: {}\n", ok ? "match" : "MISMATCH");
+
+    static constexpr auto image = rv::assemble_static<every_form>();
+    const auto runtime = rv::assemble(every_form.view());
+    const bool same = std::ranges::equal(image, runtime);
+    ok &= same;
+    std::cout << std::format("_rvasm literal: {}\n", same ? "identical" : "MISMATCH");
+    return ok ? 0 : 1;
+}
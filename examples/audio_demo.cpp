@@ -0,0 +1,142 @@
+#include "cache.hpp"
+#include "hash_table.hpp"
+#include "mmio_window.hpp"
+#include "pcm_audio_device.hpp"
+#include "riscv.hpp"
+#include "rv_assembler.hpp"
+#include "guest_programs.hpp"
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/*
+Streaming PCM through the lock-free audio FIFO.
+A guest square-wave generator feeds PcmAudioDevice while a host thread plays the part of
+the SDL audio callback, draining 512 samples every 23 ms. The paced guest refills only
+when STATUS.low is set and should never underrun or overrun; the unpaced one ignores
+STATUS and shows up in the overrun counter.
+*/
+
+using namespace std::chrono;
+
+// ~220 Hz square wave, topped up 1024 samples at a time whenever the FIFO is at most half full
+static constexpr std::string_view paced_src = R"(
+start:
+    lui  x1, 131076       # 0x2000'4000 PCM
+    lui  x10, 128002
+    addi x10, x10, -192   # 0x1F40'1F40: two samples of +8000
+    lui  x11, 920590
+    addi x11, x11, 192    # 0xE0C0'E0C0: two samples of -8000
+    xor  x12, x10, x11    # flips one level into the other
+    addi x13, x0, 25      # words (50 samples) per half period
+    add  x14, x13, x0
+refill:
+    lw   x4, 16(x1)       # STATUS
+    andi x4, x4, 1        # low water?
+    beq  x4, x0, refill
+    addi x5, x0, 512      # 1024 samples
+burst:
+    sw   x10, 0(x1)       # DATA
+    addi x14, x14, -1
+    bne  x14, x0, same
+    xor  x10, x10, x12
+    add  x14, x13, x0
+same:
+    addi x5, x5, -1
+    bne  x5, x0, burst
+    jal  x0, refill
+)";
+
+// the same wave, written as fast as the CPU goes
+static constexpr std::string_view unpaced_src = R"(
+start:
+    lui  x1, 131076
+    lui  x10, 128002
+    addi x10, x10, -192
+    lui  x11, 920590
+    addi x11, x11, 192
+    xor  x12, x10, x11
+    addi x13, x0, 25
+    add  x14, x13, x0
+loop:
+    sw   x10, 0(x1)
+    addi x14, x14, -1
+    bne  x14, x0, loop
+    xor  x10, x10, x12
+    add  x14, x13, x0
+    jal  x0, loop
+)";
+
+struct Result
+{
+    std::uint64_t instructions = 0;
+    std::uint64_t callbacks    = 0;
+    double        avg_level_ms = 0;   // FIFO depth seen by the callback, i.e. output latency
+    std::uint32_t underruns    = 0;
+    std::uint32_t overruns     = 0;
+};
+
+static Result run(std::string_view src, duration<double> length)
+{
+    const auto program = rv::assemble(src);
+    auto dram = std::make_unique<rv::HashTable<std::uint32_t,std::uint32_t>>(1 << 12);
+    guest::load_program(*dram, program);
+
+    auto window = std::make_unique<rv::MmioWindow>(std::move(dram));
+    auto& pcm = static_cast<rv::PcmAudioDevice&>(window->map("pcm", rv::PcmAudioDevice::default_base,
+                                                             rv::PcmAudioDevice::window_size,
+                                                             std::make_unique<rv::PcmAudioDevice>()));
+    rv::Cache l1{ 64, 2, std::move(window) };
+    l1.set_attribute(rv::PcmAudioDevice::default_base, rv::PcmAudioDevice::window_size, rv::MemAttr::uncached);
+    rv::RiscV cpu{ l1 };
+
+    Result res;
+    double level_sum = 0;
+    {
+        // the "audio callback": fixed-size pulls at the device's sample rate
+        std::jthread audio{ [&](std::stop_token stop) {
+            constexpr std::size_t chunk = 512;
+            const auto period = duration_cast<steady_clock::duration>(duration<double>(double(chunk) / rv::PcmAudioDevice::sample_rate));
+            std::array<std::int16_t, chunk> buf{};
+            auto next = steady_clock::now();
+            while (!stop.stop_requested()) {
+                next += period;
+                std::this_thread::sleep_until(next);
+                level_sum += static_cast<double>(pcm.queued());
+                pcm.drain(buf);
+                ++res.callbacks;
+            }
+        } };
+
+        const auto end = steady_clock::now() + length;
+        while (steady_clock::now() < end)
+            for (int i = 0; i < 4096; ++i) cpu.step();
+    }
+    res.instructions = cpu.instret();
+    res.avg_level_ms = res.callbacks ? level_sum / double(res.callbacks) * 1e3 / rv::PcmAudioDevice::sample_rate : 0.0;
+    res.underruns    = pcm.underrun_count();
+    res.overruns     = pcm.overrun_count();
+    return res;
+}
+
+int main()
+{
+    const Result paced   = run(paced_src, seconds{ 2 });
+    const Result unpaced = run(unpaced_src, seconds{ 1 });
+
+    std::cout << std::format("{:<10} {:>14} {:>10} {:>13} {:>10} {:>10}\n",
+                             "guest", "instructions", "callbacks", "latency ms", "underruns", "overruns");
+    for (const auto& [name, r] : { std::pair{ "paced", paced }, std::pair{ "unpaced", unpaced } })
+        std::cout << std::format("{:<10} {:>14} {:>10} {:>13.1f} {:>10} {:>10}\n",
+                                 name, r.instructions, r.callbacks, r.avg_level_ms, r.underruns, r.overruns);
+
+    const bool ok = paced.callbacks > 0 && paced.underruns == 0 && paced.overruns == 0 && unpaced.overruns > 0;
+    std::cout << (ok ? "paced guest streamed without gaps or drops\n" : "UNEXPECTED underrun/overrun counts\n");
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
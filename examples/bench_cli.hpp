@@ -0,0 +1,101 @@
+#pragma once
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+/*
+Command-line and report plumbing shared by the benchmark examples (cpu_bench, ds_bench):
+`--flag value` pairs with comma-separated lists and numbers, and a JSON report of one
+object per result, written to a file or, with `--json -`, to stdout.
+*/
+namespace cli {
+
+/* "a,b,,c" -> {a, b, c} */
+inline std::vector<std::string_view> split(std::string_view s)
+{
+    std::vector<std::string_view> out;
+    for (std::size_t p = 0; p <= s.size();) {
+        const std::size_t q = std::min(s.find(',', p), s.size());
+        if (q > p) out.push_back(s.substr(p, q - p));
+        p = q + 1;
+    }
+    return out;
+}
+
+/* the whole of `s` as a T, or invalid_argument */
+template <class T>
+T number(std::string_view s)
+{
+    T v{};
+    auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), v);
+    if (ec != std::errc{} || end != s.data() + s.size())
+        throw std::invalid_argument(std::format("bad number '{}'", s));
+    return v;
+}
+
+/* walks `--flag value` pairs; `on_flag(flag, value)` returns false for a flag it doesn't know */
+template <class F>
+void for_each_flag(std::span<char*> args, F&& on_flag)
+{
+    for (std::size_t i = 0; i < args.size(); i += 2) {
+        const std::string_view flag = args[i];
+        if (i + 1 >= args.size()) throw std::invalid_argument(std::format("{} needs a value", flag));
+        if (!on_flag(flag, std::string_view{ args[i + 1] }))
+            throw std::invalid_argument(std::format("unknown option '{}'", flag));
+    }
+}
+
+/* parse(argv[1..]); a bad command line is reported as "<prog>: <what>" and gives nullopt */
+template <class Parse>
+auto parse_args(std::string_view prog, int argc, char** argv, Parse&& parse)
+    -> std::optional<decltype(parse(std::span<char*>{}))>
+{
+    try {
+        return parse(std::span<char*>{ argv + 1, static_cast<std::size_t>(argc - 1) });
+    } catch (const std::exception& e) {
+        std::cerr << std::format("{}: {}\n", prog, e.what());
+        return std::nullopt;
+    }
+}
+
+/* {"benchmark": ..., <fields>, "results": [<rows>]}; field values and rows are already JSON */
+inline std::string json_report(std::string_view benchmark,
+                               const std::vector<std::pair<std::string_view, std::string>>& fields,
+                               const std::vector<std::string>& rows)
+{
+    std::string out = std::format("{{\n  \"benchmark\": \"{}\",\n", benchmark);
+    for (const auto& [key, value] : fields) out += std::format("  \"{}\": {},\n", key, value);
+    out += "  \"results\": [\n";
+    for (std::size_t i = 0; i < rows.size(); ++i)
+        out += std::format("    {}{}\n", rows[i], i + 1 < rows.size() ? "," : "");
+    return out + "  ]\n}\n";
+}
+
+/* `--json` target: "-" prints the report, a path writes it there; false if the file can't be written */
+inline bool write_json(std::string_view prog, const std::string& target, const std::string& report, std::size_t n_results)
+{
+    if (target == "-") {
+        std::cout << report;
+        return true;
+    }
+    std::ofstream f{ target };
+    if (!(f << report)) {
+        std::cerr << std::format("{}: cannot write '{}'\n", prog, target);
+        return false;
+    }
+    std::cout << std::format("\n{} results written to {}\n", n_results, target);
+    return true;
+}
+
+} // namespace cli
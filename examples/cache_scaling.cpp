@@ -0,0 +1,100 @@
+#include "concurrent_cache.hpp"
+#include "concurrent_hash_table.hpp"
+#include "cache_stats_formatter.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+/*
+Stress / scaling benchmark for ConcurrentCache.
+T threads share one cache; each mixes loads over the whole working set with stores
+to the words it owns (word i belongs to thread i % T, so threads share every line).
+Afterwards the cache is flushed and every owned word is checked in the cache and in
+DRAM: a lost or torn write fails the run.
+*/
+
+using namespace std::chrono;
+using Dram = rv::ConcurrentHashTable<std::uint32_t,std::uint32_t>;
+
+constexpr std::size_t sets        = 256;
+constexpr std::size_t ways        = 4;     // 16 KiB
+constexpr std::uint32_t ws_words  = 6144;  // 24 KiB working set
+constexpr std::size_t ops_per_t   = 1'000'000;
+constexpr unsigned    store_pct   = 20;
+
+struct RunResult { double mops; bool ok; };
+
+static RunResult run(unsigned n_threads)
+{
+    auto dram = std::make_unique<Dram>(1 << 14);
+    Dram* dram_raw = dram.get();
+    rv::ConcurrentCache l1(sets, ways, std::move(dram));
+
+    // expected[i] = last value stored to word i by its owner
+    std::vector<std::uint32_t> expected(ws_words, 0);
+
+    auto worker = [&](unsigned t) {
+        std::mt19937 rng(t * 7919u + 1);
+        std::uniform_int_distribution<std::uint32_t> word(0, ws_words - 1);
+        std::uniform_int_distribution<unsigned>      pct(0, 99);
+        const std::uint32_t owned = (ws_words - t + n_threads - 1) / n_threads; // words t, t+T, ...
+
+        for (std::size_t i = 0; i < ops_per_t; ++i) {
+            if (pct(rng) < store_pct && owned) {
+                const std::uint32_t w = t + (word(rng) % owned) * n_threads;
+                const auto v = static_cast<std::uint32_t>((t << 24) | (i & 0xFFFFFF)) | 1u;
+                l1.store_word(w * 4, v);
+                expected[w] = v;        // only the owner writes this slot
+            } else {
+                (void)l1.load_word(word(rng) * 4);
+            }
+        }
+    };
+
+    auto t0 = steady_clock::now();
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < n_threads; ++t) pool.emplace_back(worker, t);
+    for (auto& th : pool) th.join();
+    const double secs = duration<double>(steady_clock::now() - t0).count();
+
+    bool ok = true;
+    l1.flush();
+    for (std::uint32_t w = 0; w < ws_words; ++w) {
+        if (!expected[w]) continue;
+        const auto in_cache = l1.load_word(w * 4).value_or(0);
+        const auto in_dram  = dram_raw->get(w * 4).value_or(0);
+        if (in_cache != expected[w] || in_dram != expected[w]) {
+            std::cerr << std::format("lost write: word {} expected {:#x} cache {:#x} dram {:#x}\n",
+                                     w, expected[w], in_cache, in_dram);
+            ok = false;
+            break;
+        }
+    }
+
+    std::cout << std::format("  {}\n", l1.stats());
+    return { static_cast<double>(n_threads * ops_per_t) / secs / 1e6, ok };
+}
+
+int main(int argc, char** argv)
+{
+    // optional argument: highest thread count to try (default: hardware threads)
+    const unsigned hw = argc > 1 ? static_cast<unsigned>(std::atoi(argv[1]))
+                                 : std::max(1u, std::thread::hardware_concurrency());
+
+    std::cout << std::format("ConcurrentCache {}x{}, {} ops/thread, {}% stores\n", sets, ways, ops_per_t, store_pct);
+    double base = 0.0;
+    bool all_ok = true;
+    for (unsigned n = 1; n <= hw; n *= 2) {
+        std::cout << std::format("threads {:3}\n", n);
+        auto r = run(n);
+        if (n == 1) base = r.mops;
+        all_ok &= r.ok;
+        std::cout << std::format("  {:8.2f} Mops/s   speedup {:5.2f}x   efficiency {:5.1f} %   {}\n",
+                                 r.mops, r.mops / base, r.mops / base / n * 100.0, r.ok ? "no lost writes" : "LOST WRITES");
+    }
+    return all_ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,19 +1,79 @@
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <iostream>
 #include <format>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "cache.hpp"
+#include "hash_table.hpp"
 #include "cache_stats.hpp"
 #include "cache_stats_formatter.hpp"
 
 int main()
 {
+    using Event = rv::CacheStats::Event;
+
     rv::CacheStats stats;
-    stats.n_cpu_accesses = 1234;
-    stats.n_hits         = 1010;
-    stats.n_misses       = 224;
-    stats.n_evictions    = 77;
+    stats.record(Event::cpu_access, 1234);
+    stats.record(Event::hit,        1010);
+    stats.record(Event::miss,       224);
+    stats.record(Event::eviction,   77);
 
     std::cout << std::format("Single-line summary:\n{}\n\n", stats);
 
     std::cout << std::format("Full block:\n{:full}", stats);
 
-    return 0;
+    // live cache: strided sweep over a working set 2x the cache size, with profiling on
+    rv::Cache l1(64, 2, std::make_unique<rv::HashTable<std::uint32_t,std::uint32_t>>());
+    l1.enable_profiling();
+    for (int pass = 0; pass < 4; ++pass)
+        for (std::uint32_t a = 0; a < 64 * 2 * 16 * 2; a += 4)
+            (void)l1.load_word(a);
+
+    std::cout << std::format("\nProfiled cache:\n{:full}\n{:3c}\n{:sets}\n{:reuse}",
+                             l1.stats(), l1.stats(), l1.stats(), l1.stats());
+
+    // cost of recording one access on a single thread: the old shared fetch_add counters
+    // (cpu_access, hit/miss, per-set: three locked RMWs) against the per-thread shard
+    constexpr std::uint64_t n = 20'000'000;
+    constexpr std::size_t   sets = 64;
+    using clock = std::chrono::steady_clock;
+    const auto ns_per = [](clock::duration d) { return std::chrono::duration<double, std::nano>(d).count() / double(n); };
+
+    std::array<std::atomic<std::uint64_t>, 2 + 2 * sets> shared{};
+    auto t0 = clock::now();
+    for (std::uint64_t i = 0; i < n; ++i) {
+        const bool hit = (i & 7) != 0;
+        shared[0].fetch_add(1, std::memory_order_relaxed);
+        shared[hit ? 1 : 2].fetch_add(1, std::memory_order_relaxed);
+        shared[2 + 2 * (i % sets) + (hit ? 0 : 1)].fetch_add(1, std::memory_order_relaxed);
+    }
+    const double before = ns_per(clock::now() - t0);
+
+    rv::CacheStats sharded{ sets };
+    t0 = clock::now();
+    for (std::uint64_t i = 0; i < n; ++i)
+        sharded.record_access(i % sets, (i & 7) != 0);
+    const double after = ns_per(clock::now() - t0);
+
+    std::cout << std::format("\nrecord one access, single thread: shared fetch_add {:.2f} ns, per-thread shard {:.2f} ns ({:.1f}x)\n",
+                             before, after, before / after);
+    // thread churn, as in a thread-pool replay: 64 batches of 4 short-lived threads must reuse the
+    // shards their exited predecessors left, and keep every count
+    constexpr std::uint64_t per_thread = 1024;
+    for (int batch = 0; batch < 64; ++batch) {
+        std::vector<std::jthread> pool;
+        for (int t = 0; t < 4; ++t)
+            pool.emplace_back([&] { for (std::uint64_t i = 0; i < per_thread; ++i) sharded.record_access(i % sets, true); });
+    }
+    const bool churn_ok = sharded.shard_count() <= 1 + 4 && sharded.cpu_accesses() == n + 64 * 4 * per_thread;
+    std::cout << std::format("256 short-lived threads: {} shards, totals {}\n",
+                             sharded.shard_count(), churn_ok ? "kept" : "WRONG");
+
+    const bool ok = churn_ok && sharded.cpu_accesses() == n + 64 * 4 * per_thread && sharded.cpu_accesses() == sharded.hits() + sharded.misses() &&
+                    sharded.set_hits(1) + sharded.set_misses(1) == (n + 64 * 4 * per_thread) / sets;
+    if (!ok) std::cout << "UNEXPECTED shard totals\n";
+    return ok ? 0 : 1;
 }
@@ -0,0 +1,136 @@
+#include "cache.hpp"
+#include "hash_table.hpp"
+#include "mapped_file.hpp"
+#include "mem_trace.hpp"
+#include "riscv.hpp"
+#include "rv_assembler.hpp"
+#include "guest_programs.hpp"
+#include <tbb/parallel_for.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+Design-space sweep: replay one recorded memory trace against many cache geometries in parallel.
+
+    cache_sweep <trace>                       replay an existing trace
+    cache_sweep --record <trace> [program]    first run a built-in guest program
+                                              (sum, fb_fill, fb_sum) through a TraceRecorder
+*/
+
+using namespace std::chrono;
+
+/* backing store for replay: data doesn't matter, only traffic */
+struct NullMemory : rv::MemoryBus
+{
+    std::uint64_t reads  = 0;
+    std::uint64_t writes = 0;
+
+    std::optional<std::uint32_t> load_word(std::uint32_t) override { ++reads; return 0; }
+    bool store_word(std::uint32_t, std::uint32_t) override { ++writes; return true; }
+};
+
+struct SweepConfig
+{
+    std::size_t                 sets;
+    std::size_t                 ways;
+    rv::Cache::WritePolicy      policy;
+};
+
+struct SweepResult
+{
+    std::uint64_t accesses, misses, evictions, next_reads, next_writes;
+};
+
+static void record(const std::string& path, std::string_view program)
+{
+    auto it = std::ranges::find(guest::programs, program, &guest::Program::name);
+    if (it == guest::programs.end())
+        throw std::invalid_argument(std::format("unknown program '{}'", program));
+
+    auto words = rv::assemble(it->src);
+    auto dram  = std::make_unique<rv::HashTable<std::uint32_t,std::uint32_t>>(1 << 16);
+    guest::load_program(*dram, words);
+
+    rv::TraceRecorder rec{ std::move(dram), path };
+    rv::RiscV cpu{ rec };
+    guest::run_to_halt(cpu, words);
+    rec.close();
+
+    std::cout << std::format("recorded {} accesses of '{}' into {}\n", rec.count(), program, path);
+}
+
+static SweepResult replay(std::span<const std::byte> trace, const SweepConfig& cfg)
+{
+    auto next = std::make_unique<NullMemory>();
+    NullMemory* mem = next.get();
+    rv::Cache cache(cfg.sets, cfg.ways, std::move(next), cfg.policy);
+
+    rv::TraceReader rd{ trace };
+    while (auto r = rd.next()) {
+        if (r->kind != rv::TraceRecord::Kind::fetch) cache.set_pc(r->pc);
+        if (r->kind == rv::TraceRecord::Kind::store) cache.store_word(r->addr, 0);
+        else                                         (void)cache.load_word(r->addr);
+    }
+
+    auto const& st = cache.stats();
+    return { st.cpu_accesses(), st.misses(), st.evictions(), mem->reads, mem->writes };
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> args(argv + 1, argv + argc);
+    if (args.empty()) {
+        std::cerr << "usage: cache_sweep <trace> | cache_sweep --record <trace> [program]\n";
+        return EXIT_FAILURE;
+    }
+
+    std::string path = args[0];
+    if (args[0] == "--record") {
+        if (args.size() < 2) { std::cerr << "--record needs a trace path\n"; return EXIT_FAILURE; }
+        path = args[1];
+        record(path, args.size() > 2 ? std::string_view{args[2]} : std::string_view{"fb_sum"});
+    }
+
+    rv::MappedFile file{ path };
+    const auto trace = file.bytes();
+    std::cout << std::format("trace: {} records, {} bytes ({:.2f} B/record)\n",
+                             rv::TraceReader{trace}.count(), trace.size(),
+                             static_cast<double>(trace.size()) /
+                             static_cast<double>(std::max<std::uint64_t>(rv::TraceReader{trace}.count(), 1)));
+
+    std::vector<SweepConfig> configs;
+    for (std::size_t sets : { 16, 32, 64, 128, 256, 512 })
+        for (std::size_t ways : { 1, 2, 4, 8 })
+            for (auto wp : { rv::Cache::WritePolicy::write_back, rv::Cache::WritePolicy::write_through })
+                configs.push_back({ sets, ways, wp });
+
+    std::vector<SweepResult> results(configs.size());
+    auto t0 = steady_clock::now();
+    tbb::parallel_for(std::size_t{0}, configs.size(), [&](std::size_t i) {
+        results[i] = replay(trace, configs[i]);
+    });
+    auto ms = duration_cast<milliseconds>(steady_clock::now() - t0).count();
+
+    std::cout << std::format("{:>5} {:>5} {:>8} {:>7} {:>11} {:>10} {:>8} {:>10} {:>11} {:>11}\n",
+                             "sets", "ways", "size KiB", "policy", "accesses", "misses", "MR %",
+                             "evictions", "next reads", "next writes");
+    for (std::size_t i = 0; i < configs.size(); ++i) {
+        auto const& c = configs[i];
+        auto const& r = results[i];
+        const double mr = r.accesses ? static_cast<double>(r.misses) * 100.0 / static_cast<double>(r.accesses) : 0.0;
+        std::cout << std::format("{:>5} {:>5} {:>8.2f} {:>7} {:>11} {:>10} {:>8.3f} {:>10} {:>11} {:>11}\n",
+                                 c.sets, c.ways, static_cast<double>(c.sets * c.ways * 16) / 1024.0,
+                                 c.policy == rv::Cache::WritePolicy::write_back ? "WB" : "WT",
+                                 r.accesses, r.misses, mr, r.evictions, r.next_reads, r.next_writes);
+    }
+    std::cout << std::format("\n{} configurations replayed in {} ms\n", configs.size(), ms);
+    return 0;
+}
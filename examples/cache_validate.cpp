@@ -0,0 +1,279 @@
+#include "cache.hpp"
+#include "hash_table.hpp"
+#include "riscv.hpp"
+#include "rv_assembler.hpp"
+#include "guest_programs.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+/*
+Cache model validation: generated guest programs with analytically known results.
+
+For each geometry (sets x ways) and write policy, sweep programs are generated:
+working-set sweeps around the capacity C, power-of-two stride sweeps, same-set
+conflict rings of W-1..2W lines, and write-back storms (store and read-modify-write
+sweeps larger than the cache). The CPU runs them with instruction fetches split off
+to their own memory, so the Cache sees data accesses only.
+
+Every sweep visits its lines in the same order each pass, so each set sees a cycle of
+m lines: with LRU, m <= W misses m times in total and m > W misses on every visit.
+That gives hits, misses, evictions, write-backs and next-level traffic in closed form,
+and CacheStats plus a counting memory below the cache must match exactly. Each sweep is
+then replayed host-side, with replay_passes times as many passes, straight into a fresh
+Cache (checked again) to time the simulator itself in accesses per second. Exits nonzero on any mismatch.
+*/
+
+using namespace std::chrono;
+using Policy = rv::Cache::WritePolicy;
+
+static constexpr std::uint32_t data_base  = 0x1'0000; // aligned to every set count used here
+static constexpr std::uint32_t line_bytes = 16;
+static constexpr std::uint32_t replay_passes = 64; // host replays run long enough to time
+
+/* next level below the cache: a word store, block store and load counter over a HashTable */
+struct CountingRam : rv::MemoryBus
+{
+    rv::HashTable<std::uint32_t, std::uint32_t> mem{ 1 << 12 };
+    std::uint64_t loads = 0, stores = 0, blocks = 0;
+
+    std::optional<std::uint32_t> load_word(std::uint32_t a) override { ++loads; return mem.get(a).value_or(0); }
+    bool store_word(std::uint32_t a, std::uint32_t v) override { ++stores; return mem.store_word(a, v); }
+    bool store_block(std::uint32_t a, std::span<const std::uint32_t> w, std::uint32_t mask) override
+    {
+        ++blocks;
+        for (std::size_t i = 0; i < w.size(); ++i)
+            if (mask & (1u << i)) mem.store_word(a + static_cast<std::uint32_t>(i * 4), w[i]);
+        return true;
+    }
+};
+
+/* Harvard split: fetches (no set_pc before them) go to `imem`, loads and stores to `dmem` */
+struct SplitBus : rv::MemoryBus
+{
+    rv::MemoryBus& imem;
+    rv::MemoryBus& dmem;
+    bool           data = false;
+
+    SplitBus(rv::MemoryBus& i, rv::MemoryBus& d) : imem{i}, dmem{d} {}
+
+    std::optional<std::uint32_t> load_word(std::uint32_t a) override
+    {
+        return std::exchange(data, false) ? dmem.load_word(a) : imem.load_word(a);
+    }
+    bool store_word(std::uint32_t a, std::uint32_t v) override { data = false; return dmem.store_word(a, v); }
+    void set_pc(std::uint32_t pc) noexcept override { data = true; dmem.set_pc(pc); }
+};
+
+enum class Op { load, store, rmw };
+
+/* `count` accesses `stride` bytes apart from data_base, `passes` times over */
+struct Sweep
+{
+    std::string   name;
+    std::uint32_t stride, count, passes;
+    Op            op;
+};
+
+struct Counts
+{
+    std::uint64_t accesses = 0, hits = 0, misses = 0, evictions = 0;
+    std::uint64_t fill_loads = 0, writebacks = 0, write_through = 0; // next-level traffic
+
+    bool operator==(const Counts&) const = default;
+};
+
+/* closed-form result of `s` on a cold LRU cache */
+static Counts expected(const Sweep& s, std::size_t sets, std::size_t ways, Policy policy)
+{
+    // distinct lines per set; a sweep touches each line in one consecutive run per pass
+    std::vector<std::uint64_t> lines_in(sets);
+    std::uint32_t last_line = ~0u;
+    for (std::uint32_t i = 0; i < s.count; ++i) {
+        const std::uint32_t line = (data_base + i * s.stride) / line_bytes;
+        if (line == last_line) continue;
+        last_line = line;
+        ++lines_in[line & (sets - 1)];
+    }
+
+    Counts c;
+    const std::uint64_t per_elem = s.op == Op::rmw ? 2 : 1;
+    c.accesses = std::uint64_t{s.passes} * s.count * per_elem;
+    std::uint64_t cold_fills = 0;
+    for (std::uint64_t m : lines_in) {
+        c.misses   += m <= ways ? m : m * s.passes; // fits: compulsory only; cycle > W ways: LRU misses every visit
+        cold_fills += std::min<std::uint64_t>(m, ways);
+    }
+    c.hits       = c.accesses - c.misses;
+    c.evictions  = c.misses - cold_fills;
+    c.fill_loads = c.misses * (line_bytes / 4);
+    const bool writes = s.op != Op::load;
+    c.writebacks    = writes && policy == Policy::write_back ? c.evictions : 0; // every line is dirty by eviction time
+    c.write_through = writes && policy == Policy::write_through ? std::uint64_t{s.passes} * s.count : 0;
+    return c;
+}
+
+static Counts observed(const rv::Cache& cache, const CountingRam& ram)
+{
+    const auto& st = cache.stats();
+    return { st.cpu_accesses(), st.hits(), st.misses(), st.evictions(), ram.loads, ram.blocks, ram.stores };
+}
+
+/* lui+addi pair; addi sign-extends, so round the upper part */
+static std::string li(std::string_view rd, std::uint32_t v)
+{
+    const std::uint32_t hi = (v + 0x800) >> 12;
+    const auto lo = static_cast<std::int32_t>(v - (hi << 12));
+    return std::format("    lui  {0}, {1}\n    addi {0}, {0}, {2}\n", rd, hi & 0xFFFFF, lo);
+}
+
+static std::string program(const Sweep& s)
+{
+    std::string src = "start:\n";
+    src += li("x1", data_base);
+    src += li("x3", data_base + s.count * s.stride);
+    src += li("x6", s.stride);
+    src += std::format("    addi x5, x0, {}\npass:\n    add  x2, x1, x0\nloop:\n", s.passes);
+    switch (s.op) {
+      case Op::load:  src += "    lw   x4, 0(x2)\n"; break;
+      case Op::store: src += "    sw   x5, 0(x2)\n"; break;
+      case Op::rmw:   src += "    lw   x4, 0(x2)\n    addi x4, x4, 1\n    sw   x4, 0(x2)\n"; break;
+    }
+    src += "    add  x2, x2, x6\n"
+           "    bne  x2, x3, loop\n"
+           "    addi x5, x5, -1\n"
+           "    bne  x5, x0, pass\n"
+           "    jalr x0, x0, 0        # halt\n";
+    return src;
+}
+
+/* runs the generated program; also checks that rmw data survived the write-backs */
+static Counts run_guest(const Sweep& s, std::size_t sets, std::size_t ways, Policy policy, bool& data_ok)
+{
+    auto ram = std::make_unique<CountingRam>();
+    CountingRam& below = *ram;
+    rv::Cache l1d(sets, ways, std::move(ram), policy);
+
+    const auto words = rv::assemble(program(s));
+    rv::HashTable<std::uint32_t, std::uint32_t> imem;
+    guest::load_program(imem, words);
+
+    SplitBus bus{ imem, l1d };
+    rv::RiscV cpu{ bus };
+    guest::run_to_halt(cpu, words);
+
+    const Counts c = observed(l1d, below);
+    data_ok = true;
+    if (s.op == Op::rmw)
+        for (std::uint32_t i = 0; i < s.count; ++i)
+            data_ok &= l1d.load_word(data_base + i * s.stride) == s.passes;
+    return c;
+}
+
+/* the same access stream fed straight into a Cache; returns seconds */
+static double replay(const Sweep& s, std::size_t sets, std::size_t ways, Policy policy, Counts& out)
+{
+    auto ram = std::make_unique<CountingRam>();
+    CountingRam& below = *ram;
+    rv::Cache l1d(sets, ways, std::move(ram), policy);
+
+    const auto t0 = steady_clock::now();
+    for (std::uint32_t p = 0; p < s.passes; ++p)
+        for (std::uint32_t i = 0, a = data_base; i < s.count; ++i, a += s.stride) {
+            if (s.op != Op::store) l1d.load_word(a);
+            if (s.op != Op::load)  l1d.store_word(a, p);
+        }
+    const double secs = duration<double>(steady_clock::now() - t0).count();
+    out = observed(l1d, below);
+    return secs;
+}
+
+static std::vector<Sweep> sweeps(std::size_t sets, std::size_t ways)
+{
+    const auto C = static_cast<std::uint32_t>(sets * ways * line_bytes);
+    const auto way_span = static_cast<std::uint32_t>(sets * line_bytes); // bytes between lines of one set
+    std::vector<Sweep> v;
+
+    // working set around the capacity: the LRU cliff sits exactly at C
+    for (auto [num, den, label] : { std::tuple{1u, 2u, "C/2"}, { 1u, 1u, "C" }, { 2u, 1u, "2C" } })
+        v.push_back({ std::format("ws {}", label), 4, C * num / den / 4, 4, Op::load });
+    v.push_back({ "ws C+1 line/set", 4, (C + way_span) / 4, 4, Op::load });
+
+    // strides over a 2C region: sub-line strides hit within the line, large ones concentrate on few sets
+    for (std::uint32_t stride : { 8u, 16u, 64u, 256u })
+        if (stride < way_span) v.push_back({ std::format("stride {}", stride), stride, 2 * C / stride, 3, Op::load });
+
+    // W-1, W, W+1, 2W lines all in set 0
+    std::size_t prev = 0;
+    for (std::size_t n : { ways - 1, ways, ways + 1, 2 * ways })
+        if (std::exchange(prev, n) != n && n)
+            v.push_back({ std::format("conflict {} lines", n), way_span, static_cast<std::uint32_t>(n), 8, Op::load });
+
+    // write-back storms: every eviction is dirty
+    v.push_back({ "store C",     4, C / 4,        2, Op::store });
+    v.push_back({ "store 4C",    4, 4 * C / 4,    2, Op::store });
+    v.push_back({ "store 4C/16", line_bytes, 4 * C / line_bytes, 2, Op::store });
+    v.push_back({ "rmw 2C",      4, 2 * C / 4,    3, Op::rmw });
+    return v;
+}
+
+int main()
+{
+    struct Geometry { std::size_t sets, ways; };
+    constexpr Geometry geometries[] = { { 16, 1 }, { 64, 2 }, { 64, 4 }, { 32, 8 }, { 1, 16 } };
+
+    bool ok = true;
+    std::uint64_t failures = 0;
+    std::cout << std::format("{:<10} {:<13} {:<19} {:>9} {:>9} {:>9} {:>9} {:>9}  {}\n",
+                             "geometry", "policy", "sweep", "accesses", "misses", "evictions", "wbacks", "wthrough", "");
+    std::vector<std::string> perf;
+    for (const auto& g : geometries) {
+        for (Policy policy : { Policy::write_back, Policy::write_through }) {
+            const char* pname = policy == Policy::write_back ? "write-back" : "write-through";
+            const std::string geo = std::format("{}x{}", g.sets, g.ways);
+            std::uint64_t replayed = 0;
+            double secs = 0;
+            for (const Sweep& s : sweeps(g.sets, g.ways)) {
+                const Counts want = expected(s, g.sets, g.ways, policy);
+                bool data_ok = false;
+                const Counts got  = run_guest(s, g.sets, g.ways, policy, data_ok);
+                Sweep longer = s;
+                longer.passes *= replay_passes;
+                Counts host;
+                secs     += replay(longer, g.sets, g.ways, policy, host);
+                replayed += host.accesses;
+
+                const bool pass = got == want && host == expected(longer, g.sets, g.ways, policy) && data_ok;
+                ok &= pass;
+                failures += !pass;
+                std::cout << std::format("{:<10} {:<13} {:<19} {:>9} {:>9} {:>9} {:>9} {:>9}  {}\n",
+                                         geo, pname, s.name, got.accesses, got.misses, got.evictions,
+                                         got.writebacks, got.write_through, pass ? "ok" : "MISMATCH");
+                if (!pass)
+                    std::cout << std::format("    expected accesses {} hits {} misses {} evictions {} fills {} wbacks {} wthrough {}{}\n"
+                                             "    guest    accesses {} hits {} misses {} evictions {} fills {} wbacks {} wthrough {}\n",
+                                             want.accesses, want.hits, want.misses, want.evictions, want.fill_loads,
+                                             want.writebacks, want.write_through, data_ok ? "" : " (rmw data wrong)",
+                                             got.accesses, got.hits, got.misses, got.evictions, got.fill_loads,
+                                             got.writebacks, got.write_through);
+            }
+            perf.push_back(std::format("{:<10} {:<13} {:>10} accesses {:>8.2f} M/s",
+                                       geo, pname, replayed, static_cast<double>(replayed) / secs / 1e6));
+        }
+    }
+
+    std::cout << "\ncache simulator throughput (host-driven replay of the same sweeps):\n";
+    for (const auto& line : perf) std::cout << "  " << line << '\n';
+    std::cout << (ok ? "\nall sweeps match the analytic model\n" : std::format("\n{} sweeps MISMATCH\n", failures));
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,241 @@
+#include "cache.hpp"
+#include "concurrent_hash_table.hpp"
+#include "hash_table.hpp"
+#include "riscv.hpp"
+#include "rv_assembler.hpp"
+#include "guest_kernels.hpp"
+#include "guest_programs.hpp"
+#include "bench_cli.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CPU_BENCH_TSC 1
+#endif
+
+/*
+Interpreter throughput: guest kernels timed on the CPU, per memory backend.
+
+    cpu_bench [--kernels a,b] [--backends a,b] [--reps 3] [--warmup 1] [--scale 1.0]
+              [--json out.json | --json -]
+
+Each kernel x backend pair gets `warmup` untimed runs and `reps` timed ones, every run on
+a fresh backend loaded with the program and the kernel's input. Only the step loop is
+timed. Reports retired instructions, MIPS (median, min, max), host ns and host cycles
+(TSC ticks, x86 only) per guest instruction, and for cached backends the L1's accesses
+(fetches included), misses and evictions. Every run's result word is checked against the
+host reference; the exit status is nonzero if any differs.
+
+Kernels (examples/guest_kernels.hpp): int_loop, memcpy, bubble_sort, crc32, matmul,
+pointer_chase, branchy; ~20M instructions each at --scale 1.
+Backends: flat (a plain array: the interpreter's cost alone), hash_table,
+concurrent_hash_table (the emulator's DRAM), l1_hash_table (4 KiB 64x4 write-back Cache
+in front of a HashTable).
+*/
+
+using namespace std::chrono;
+
+struct Backend
+{
+    std::string_view name;
+    std::unique_ptr<rv::MemoryBus> (*dram)();
+    std::size_t l1_sets = 0, l1_ways = 0; // 0: the CPU talks to dram directly
+};
+
+static constexpr Backend backends[] = {
+    { "flat",                  []() -> std::unique_ptr<rv::MemoryBus> { return std::make_unique<guest::FlatRam>(); } },
+    { "hash_table",            []() -> std::unique_ptr<rv::MemoryBus> { return std::make_unique<rv::HashTable<std::uint32_t, std::uint32_t>>(); } },
+    { "concurrent_hash_table", []() -> std::unique_ptr<rv::MemoryBus> { return std::make_unique<rv::ConcurrentHashTable<std::uint32_t, std::uint32_t>>(); } },
+    { "l1_hash_table",         []() -> std::unique_ptr<rv::MemoryBus> { return std::make_unique<rv::HashTable<std::uint32_t, std::uint32_t>>(); }, 64, 4 },
+};
+
+#ifdef CPU_BENCH_TSC
+static constexpr bool have_cycles = true;
+static std::uint64_t host_cycles() noexcept { return __rdtsc(); }
+#else
+static constexpr bool have_cycles = false;
+static std::uint64_t host_cycles() noexcept { return 0; }
+#endif
+
+struct CacheCounts
+{
+    std::uint64_t accesses = 0, misses = 0, evictions = 0;
+};
+
+struct Run
+{
+    double        seconds = 0;
+    std::uint64_t instret = 0, cycles = 0;
+    bool          ok      = false;
+    std::optional<CacheCounts> l1;
+};
+
+static Run run_once(const guest::Kernel& k, const Backend& b, const std::vector<std::uint32_t>& words, std::uint32_t reps)
+{
+    auto dram = b.dram();
+    guest::load_program(*dram, words);
+    k.setup(*dram, reps); // straight into DRAM, so the L1 starts cold and its stats are the kernel's alone
+
+    std::unique_ptr<rv::Cache> l1;
+    if (b.l1_sets) l1 = std::make_unique<rv::Cache>(b.l1_sets, b.l1_ways, std::move(dram));
+    rv::MemoryBus& bus = l1 ? static_cast<rv::MemoryBus&>(*l1) : *dram;
+
+    rv::RiscV cpu{ bus };
+    const auto t0 = steady_clock::now();
+    const std::uint64_t c0 = host_cycles();
+    guest::run_to_halt(cpu, words);
+    const std::uint64_t c1 = host_cycles();
+    const auto t1 = steady_clock::now();
+
+    Run r{ duration<double>(t1 - t0).count(), cpu.instret(), c1 - c0, false, std::nullopt };
+    if (l1) r.l1 = CacheCounts{ l1->stats().cpu_accesses(), l1->stats().misses(), l1->stats().evictions() };
+    r.ok = bus.load_word(guest::result_addr) == k.expect(reps);
+    return r;
+}
+
+struct Result
+{
+    std::string_view kernel, backend;
+    std::uint32_t    reps = 0;
+    std::uint64_t    instret = 0;
+    double           mips_median = 0, mips_min = 0, mips_max = 0, ns_per_instr = 0, cycles_per_instr = 0;
+    std::optional<CacheCounts> l1{};
+    bool             ok = true;
+};
+
+static Result measure(const guest::Kernel& k, const Backend& b, std::uint32_t reps, unsigned warmup, unsigned runs)
+{
+    const auto words = rv::assemble(k.src);
+    Result res{ .kernel = k.name, .backend = b.name, .reps = reps };
+    for (unsigned i = 0; i < warmup; ++i) res.ok &= run_once(k, b, words, reps).ok;
+
+    std::vector<Run> timed;
+    for (unsigned i = 0; i < runs; ++i) timed.push_back(run_once(k, b, words, reps));
+    std::ranges::sort(timed, {}, &Run::seconds);
+
+    const Run& med = timed[timed.size() / 2];
+    const auto n = static_cast<double>(med.instret);
+    res.instret          = med.instret;
+    res.mips_median      = n / med.seconds / 1e6;
+    res.mips_min         = n / timed.back().seconds / 1e6;
+    res.mips_max         = n / timed.front().seconds / 1e6;
+    res.ns_per_instr     = med.seconds * 1e9 / n;
+    res.cycles_per_instr = static_cast<double>(med.cycles) / n;
+    res.l1               = med.l1;
+    for (const Run& r : timed) res.ok &= r.ok && r.instret == med.instret;
+    return res;
+}
+
+struct Options
+{
+    std::vector<const guest::Kernel*> kernels;
+    std::vector<const Backend*>       backends;
+    unsigned    reps   = 3;
+    unsigned    warmup = 1;
+    double      scale  = 1.0;
+    std::string json;
+};
+
+static Options parse(std::span<char*> args)
+{
+    Options o;
+    for (const auto& k : guest::bench_kernels) o.kernels.push_back(&k);
+    for (const auto& b : backends) o.backends.push_back(&b);
+
+    cli::for_each_flag(args, [&](std::string_view flag, std::string_view val) {
+        if (flag == "--kernels") {
+            o.kernels.clear();
+            for (auto n : cli::split(val)) {
+                auto it = std::ranges::find(guest::bench_kernels, n, &guest::Kernel::name);
+                if (it == guest::bench_kernels.end()) throw std::invalid_argument(std::format("unknown kernel '{}'", n));
+                o.kernels.push_back(&*it);
+            }
+        } else if (flag == "--backends") {
+            o.backends.clear();
+            for (auto n : cli::split(val)) {
+                auto it = std::ranges::find(backends, n, &Backend::name);
+                if (it == std::end(backends)) throw std::invalid_argument(std::format("unknown backend '{}'", n));
+                o.backends.push_back(&*it);
+            }
+        } else if (flag == "--reps") {
+            o.reps = std::max(cli::number<unsigned>(val), 1u);
+        } else if (flag == "--warmup") {
+            o.warmup = cli::number<unsigned>(val);
+        } else if (flag == "--scale") {
+            o.scale = std::stod(std::string{ val });
+            if (!(o.scale > 0.0)) throw std::invalid_argument(std::format("scale {} must be positive", o.scale));
+        } else if (flag == "--json") {
+            o.json = val;
+        } else {
+            return false;
+        }
+        return true;
+    });
+    return o;
+}
+
+static std::string to_json(const std::vector<Result>& results, const Options& o)
+{
+    std::vector<std::string> rows;
+    for (const auto& r : results) {
+        const std::string cycles = have_cycles ? std::format("{:.2f}", r.cycles_per_instr) : "null";
+        const std::string l1 = r.l1 ? std::format("{{\"accesses\": {}, \"misses\": {}, \"evictions\": {}, \"miss_rate\": {:.5f}}}",
+                                                  r.l1->accesses, r.l1->misses, r.l1->evictions,
+                                                  r.l1->accesses ? static_cast<double>(r.l1->misses) / static_cast<double>(r.l1->accesses) : 0.0)
+                                    : "null";
+        rows.push_back(std::format("{{\"kernel\": \"{}\", \"backend\": \"{}\", \"kernel_reps\": {}, \"instructions\": {}, "
+                                   "\"mips_median\": {:.3f}, \"mips_min\": {:.3f}, \"mips_max\": {:.3f}, \"ns_per_instr\": {:.3f}, "
+                                   "\"host_cycles_per_instr\": {}, \"l1\": {}, \"ok\": {}}}",
+                                   r.kernel, r.backend, r.reps, r.instret, r.mips_median, r.mips_min, r.mips_max, r.ns_per_instr,
+                                   cycles, l1, r.ok));
+    }
+    return cli::json_report("cpu_bench", { { "scale", std::format("{}", o.scale) }, { "warmup", std::format("{}", o.warmup) },
+                                           { "runs", std::format("{}", o.reps) } }, rows);
+}
+
+int main(int argc, char** argv)
+{
+    const auto parsed = cli::parse_args("cpu_bench", argc, argv, parse);
+    if (!parsed) return EXIT_FAILURE;
+    const Options& opt = *parsed;
+    const bool table = opt.json != "-";
+
+    if (table)
+        std::cout << std::format("{:<14} {:<22} {:>9} {:>8} {:>8} {:>8} {:>9} {:>9} {:>8}\n",
+                                 "kernel", "backend", "Minstr", "MIPS", "min", "max", "ns/instr", "cyc/instr", "L1 miss");
+
+    std::vector<Result> results;
+    bool ok = true;
+    for (const guest::Kernel* k : opt.kernels) {
+        const auto reps = std::max(static_cast<std::uint32_t>(k->reps * opt.scale + 0.5), 1u);
+        for (const Backend* b : opt.backends) {
+            Result r = measure(*k, *b, reps, opt.warmup, opt.reps);
+            ok &= r.ok;
+            if (table)
+                std::cout << std::format("{:<14} {:<22} {:>9.2f} {:>8.2f} {:>8.2f} {:>8.2f} {:>9.2f} {:>9} {:>8}{}\n",
+                                         r.kernel, r.backend, static_cast<double>(r.instret) / 1e6,
+                                         r.mips_median, r.mips_min, r.mips_max, r.ns_per_instr,
+                                         have_cycles ? std::format("{:.1f}", r.cycles_per_instr) : "-",
+                                         r.l1 ? std::format("{:.2f}%", r.l1->accesses ? static_cast<double>(r.l1->misses) * 100.0 /
+                                                                                         static_cast<double>(r.l1->accesses) : 0.0)
+                                              : "-",
+                                         r.ok ? "" : "  WRONG RESULT");
+            results.push_back(r);
+        }
+    }
+
+    if (!opt.json.empty() && !cli::write_json("cpu_bench", opt.json, to_json(results, opt), results.size()))
+        return EXIT_FAILURE;
+    if (table) std::cout << (ok ? "all results ok\n" : "MISMATCH\n");
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
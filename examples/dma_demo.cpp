@@ -0,0 +1,232 @@
+#include "cache.hpp"
+#include "dma_device.hpp"
+#include "hash_table.hpp"
+#include "mmio_window.hpp"
+#include "riscv.hpp"
+#include "rv_assembler.hpp"
+#include "guest_programs.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+/*
+Sprite drawing with and without the DMA engine.
+The same 16x16 rectangles are drawn into the framebuffer by a per-pixel `sb` loop and
+by programming the DMA controller; instruction counts, host time and the resulting
+framebuffers are compared. A packed sprite in RAM is then blitted with a 2D copy, rows
+straddling the edges of a direct-mapped range must land byte-exact on both sides, and oversized
+transfers must be refused with STATUS.error instead of running.
+*/
+
+using namespace std::chrono;
+
+// eight 16x16 rectangles of colour 0xE0, one pixel store at a time
+static constexpr std::string_view cpu_fill_src = R"(
+start:
+    lui  x1, 131072       # 0x2000'0000 framebuffer
+    addi x1, x1, 2047
+    addi x1, x1, 33       # (32, 16)
+    addi x3, x0, 224      # colour
+    addi x7, x0, 8        # sprites
+sprite:
+    addi x4, x0, 16       # rows
+    add  x8, x1, x0
+row:
+    addi x5, x0, 16       # columns
+    add  x6, x8, x0
+col:
+    sb   x3, 0(x6)
+    addi x6, x6, 1
+    addi x5, x5, -1
+    bne  x5, x0, col
+    addi x8, x8, 128
+    addi x4, x4, -1
+    bne  x4, x0, row
+    addi x1, x1, 8        # next sprite 8 px to the right
+    addi x7, x7, -1
+    bne  x7, x0, sprite
+    jalr x0, x0, 0        # halt
+)";
+
+// the same rectangles with one DMA fill each
+static constexpr std::string_view dma_fill_src = R"(
+start:
+    lui  x1, 131075       # 0x2000'3000 DMA
+    lui  x2, 131072
+    addi x2, x2, 2047
+    addi x2, x2, 33       # destination (32, 16)
+    addi x3, x0, 16
+    sw   x3, 8(x1)        # WIDTH
+    sw   x3, 12(x1)       # HEIGHT
+    addi x3, x0, 128
+    sw   x3, 20(x1)       # DST_STRIDE
+    addi x3, x0, 224
+    sw   x3, 24(x1)       # FILL
+    addi x7, x0, 8
+sprite:
+    sw   x2, 4(x1)        # DST
+    addi x3, x0, 3
+    sw   x3, 28(x1)       # CTRL = start | fill
+wait:
+    lw   x4, 32(x1)       # STATUS
+    beq  x4, x0, wait
+    sw   x4, 32(x1)       # clear done
+    addi x2, x2, 8
+    addi x7, x7, -1
+    bne  x7, x0, sprite
+    jalr x0, x0, 0        # halt
+)";
+
+// 2D copy of a packed 16x16 sprite at 0x4000 (4 pixels per word) to (64, 40)
+static constexpr std::string_view dma_blit_src = R"(
+start:
+    lui  x1, 131075       # DMA
+    lui  x2, 4            # 0x4000 sprite in RAM
+    sw   x2, 0(x1)        # SRC
+    lui  x2, 131072
+    addi x2, x2, 2047
+    addi x2, x2, 2047
+    addi x2, x2, 1090     # (64, 40) = 40*128 + 64
+    sw   x2, 4(x1)        # DST
+    addi x3, x0, 16
+    sw   x3, 8(x1)        # WIDTH
+    sw   x3, 12(x1)       # HEIGHT
+    sw   x3, 16(x1)       # SRC_STRIDE
+    addi x3, x0, 128
+    sw   x3, 20(x1)       # DST_STRIDE
+    addi x3, x0, 1
+    sw   x3, 28(x1)       # CTRL = start
+wait:
+    lw   x4, 32(x1)
+    beq  x4, x0, wait
+    jalr x0, x0, 0        # halt
+)";
+
+struct System
+{
+    std::vector<std::uint8_t>  fb = std::vector<std::uint8_t>(128 * 128);
+    rv::MmioWindow*            io  = nullptr;
+    rv::DmaDevice*             dma = nullptr;
+    std::unique_ptr<rv::Cache> l1;
+
+    explicit System(const std::vector<std::uint32_t>& program)
+    {
+        auto dram = std::make_unique<rv::HashTable<std::uint32_t,std::uint32_t>>(1 << 16);
+        guest::load_program(*dram, program);
+        // packed sprite: pixel (x, y) = x * 16 + y
+        for (std::uint32_t i = 0; i < 64; ++i) {
+            std::uint32_t w = 0;
+            for (std::uint32_t b = 0; b < 4; ++b) {
+                const std::uint32_t px = i * 4 + b;
+                w |= (((px % 16) * 16 + px / 16) & 0xFF) << (8 * b);
+            }
+            dram->store_word(0x4000 + i * 4, w);
+        }
+
+        auto window = std::make_unique<rv::MmioWindow>(std::move(dram));
+        io = window.get();
+        io->framebuffer = fb.data();
+
+        l1 = std::make_unique<rv::Cache>(64, 2, std::move(window));
+        l1->set_attribute(rv::MmioWindow::fb_base,   rv::MmioWindow::fb_size,    rv::MemAttr::write_combining);
+        l1->set_attribute(rv::MmioWindow::gpio_addr, 8,                          rv::MemAttr::uncached);
+        l1->set_attribute(rv::DmaDevice::default_base, rv::DmaDevice::window_size, rv::MemAttr::uncached);
+
+        auto engine = std::make_unique<rv::DmaDevice>(*l1);
+        dma = engine.get();
+        dma->map_direct(rv::MmioWindow::fb_base, rv::MmioWindow::fb_size, io->framebuffer);
+        io->map("dma", rv::DmaDevice::default_base, rv::DmaDevice::window_size, std::move(engine));
+    }
+};
+
+struct Run
+{
+    std::uint64_t instructions;
+    double        us;
+};
+
+static Run run(System& sys, const std::vector<std::uint32_t>& program)
+{
+    rv::RiscV cpu{ *sys.l1 };
+    auto t0 = steady_clock::now();
+    const std::uint64_t n = guest::run_to_halt(cpu, program);
+    sys.l1->fence();
+    return { n, static_cast<double>(duration_cast<nanoseconds>(steady_clock::now() - t0).count()) / 1000.0 };
+}
+
+int main()
+{
+    const auto cpu_prog  = rv::assemble(cpu_fill_src);
+    const auto dma_prog  = rv::assemble(dma_fill_src);
+    const auto blit_prog = rv::assemble(dma_blit_src);
+
+    System a{ cpu_prog }, b{ dma_prog };
+    const Run ra = run(a, cpu_prog);
+    const Run rb = run(b, dma_prog);
+
+    std::cout << std::format("{:<18} {:>12} {:>10}\n", "8 sprite fills", "instructions", "host us");
+    std::cout << std::format("{:<18} {:>12} {:>10.1f}\n", "per-pixel sb", ra.instructions, ra.us);
+    std::cout << std::format("{:<18} {:>12} {:>10.1f}\n", "DMA fill", rb.instructions, rb.us);
+    const bool same = a.fb == b.fb;
+    std::cout << std::format("framebuffers {}, DMA moved {} bytes in {} transfers\n\n",
+                             same ? "match" : "DIFFER", b.dma->bytes_moved(), b.dma->read(rv::DmaDevice::count));
+
+    System c{ blit_prog };
+    const Run rc = run(c, blit_prog);
+    bool blit_ok = true;
+    for (std::uint32_t y = 0; y < 16; ++y)
+        for (std::uint32_t x = 0; x < 16; ++x)
+            blit_ok &= c.fb[(40 + y) * 128 + 64 + x] == ((x * 16 + y) & 0xFF);
+    std::cout << std::format("2D blit of packed sprite: {} instructions, {}\n",
+                             rc.instructions, blit_ok ? "pixels ok" : "PIXELS WRONG");
+
+    // rows crossing the edges of a direct range: bytes inside it go through memcpy, the rest through the bus
+    rv::DmaDevice& dma = *c.dma;
+    const auto ram_byte = [&](std::uint32_t a) { return static_cast<std::uint8_t>(*c.l1->load_word(a & ~3u) >> (8 * (a & 3))); };
+    dma.write(rv::DmaDevice::src, 0x4000);                 // packed sprite row 0 (bytes 0, 16, 32, ...) into RAM and the framebuffer
+    dma.write(rv::DmaDevice::dst, rv::MmioWindow::fb_base - 7);
+    dma.write(rv::DmaDevice::width, 16);
+    dma.write(rv::DmaDevice::height, 1);
+    dma.write(rv::DmaDevice::ctrl, rv::DmaDevice::ctrl_start);
+    bool edge_ok = true;
+    for (std::uint32_t i = 0; i < 16; ++i)
+        edge_ok &= (i < 7 ? ram_byte(rv::MmioWindow::fb_base - 7 + i) : c.fb[i - 7]) == ((i * 16) & 0xFF);
+
+    rv::HashTable<std::uint32_t,std::uint32_t> ram(1 << 8);  // both edges of a small direct range, then a copy back out
+    std::vector<std::uint8_t> buf(32);
+    std::uint8_t* host = buf.data();
+    rv::DmaDevice edge{ ram };
+    edge.map_direct(0x1000, 32, host);
+    edge.write(rv::DmaDevice::dst, 0x0FF9);
+    edge.write(rv::DmaDevice::width, 48);
+    edge.write(rv::DmaDevice::fill, 0x5A);
+    edge.write(rv::DmaDevice::ctrl, rv::DmaDevice::ctrl_start | rv::DmaDevice::ctrl_fill);
+    edge.write(rv::DmaDevice::src, 0x0FF9);
+    edge.write(rv::DmaDevice::dst, 0x2001);
+    edge.write(rv::DmaDevice::ctrl, rv::DmaDevice::ctrl_start);
+    edge_ok &= std::ranges::all_of(buf, [](std::uint8_t b) { return b == 0x5A; });
+    for (const std::uint32_t base : { 0x0FF9u, 0x2001u })
+        for (std::uint32_t a = base; a < base + 48; ++a)
+            if (a - 0x1000 >= 32) edge_ok &= static_cast<std::uint8_t>(ram.load_word(a & ~3u).value_or(0) >> (8 * (a & 3))) == 0x5A;
+    std::cout << std::format("rows across direct-range edges: {}\n", edge_ok ? "bytes ok" : "BYTES WRONG");
+
+    // WIDTH*HEIGHT beyond max_transfer (including products that overflow 32 bits) is an error, not a copy
+    bool limit_ok = true;
+    for (const auto& [wd, ht] : { std::pair{ 0x1'0000u, 0x1'0000u }, std::pair{ 0xFFFF'FFFFu, 0xFFFF'FFFFu } }) {
+        const std::uint32_t done_before = dma.read(rv::DmaDevice::count);
+        dma.write(rv::DmaDevice::dst, rv::MmioWindow::fb_base);
+        dma.write(rv::DmaDevice::width, wd);
+        dma.write(rv::DmaDevice::height, ht);
+        dma.write(rv::DmaDevice::ctrl, rv::DmaDevice::ctrl_start | rv::DmaDevice::ctrl_fill);
+        limit_ok &= dma.read(rv::DmaDevice::status) == (rv::DmaDevice::status_done | rv::DmaDevice::status_error) &&
+                    dma.read(rv::DmaDevice::count) == done_before;
+    }
+    std::cout << std::format("oversized transfers: {}\n", limit_ok ? "rejected with STATUS.error" : "NOT REJECTED");
+
+    return same && blit_ok && edge_ok && limit_ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,362 @@
+#include "concurrent_hash_table.hpp"
+#include "hash_table.hpp"
+#include "lock_free_list.hpp"
+#include "node_pool.hpp"
+#include "bench_cli.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <latch>
+#include <mutex>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/*
+Data-structure benchmark: the read/write mixes parallel_stress only smoke-tests, measured.
+
+    ds_bench [--structures a,b] [--dist uniform,zipf,seq] [--reads 0.5,0.9] [--keys 65536]
+             [--threads 1,2,4] [--ops 200000] [--json out.json | --json -]
+
+Every combination of structure x key distribution x read ratio x key count x thread count
+gets a fresh structure prefilled with all its keys, then each thread runs `ops` gets/puts
+from a pre-generated stream. Reports Mops/s, p50/p99/p99.9 latency (every 16th op is
+timed) and scaling efficiency against the 1-thread run, as a table and optionally JSON.
+
+Structures: hash_table (single-threaded; 1-thread runs only), locked_hash_table (HashTable
+behind a mutex), concurrent_hash_table, pooled_hash_table (PoolAllocator nodes),
+lock_free_list (at most 1024 keys: every op walks the list), and bus_hash_table /
+bus_concurrent_hash_table: the same tables driven as DRAM through the MemoryBus interface
+with word addresses (at most 2^30 keys). --keys is limited to 2^31 and --ops must be at least 1.
+Distributions: uniform, zipf (YCSB Zipfian, theta 0.99, hot keys scattered), seq (each
+thread walks consecutive addresses from its own offset).
+*/
+
+using namespace std::chrono;
+
+using Map       = rv::HashTable<std::uint32_t, std::uint32_t>;
+using Table     = rv::ConcurrentHashTable<std::uint32_t, std::uint32_t>;
+using Pooled    = rv::ConcurrentHashTable<std::uint32_t, std::uint32_t, std::hash<std::uint32_t>,
+                                          std::equal_to<std::uint32_t>, rv::PoolAllocator<std::byte>>;
+using List      = rv::LockFreeList<std::uint32_t, std::uint32_t>;
+
+static constexpr std::size_t stream_len   = 1 << 16; // pre-generated ops per thread, replayed cyclically
+static constexpr std::size_t sample_every = 16;      // ops between latency samples
+static constexpr std::uint32_t write_bit    = 1u << 31; // stream ops are key | write flag, so keys stay below it
+
+/*
+adapters: one get/put face per structure
+*/
+template <class T>
+struct Direct
+{
+    T t;
+    explicit Direct(std::size_t keys) : t(keys * 2) {}
+    std::uint32_t get(std::uint32_t k) { return t.get(k).value_or(0); }
+    void put(std::uint32_t k, std::uint32_t v) { t.put(k, v); }
+};
+
+struct Locked
+{
+    Map        t;
+    std::mutex mtx;
+    explicit Locked(std::size_t keys) : t(keys * 2) {}
+    std::uint32_t get(std::uint32_t k) { std::scoped_lock lk(mtx); return t.get(k).value_or(0); }
+    void put(std::uint32_t k, std::uint32_t v) { std::scoped_lock lk(mtx); t.put(k, v); }
+};
+
+struct ListAdapter
+{
+    List t;
+    explicit ListAdapter(std::size_t) {}
+    std::uint32_t get(std::uint32_t k) { return t.find(k).value_or(0); }
+    void put(std::uint32_t k, std::uint32_t v) { t.put(k, v); }
+};
+
+/* DRAM view: keys are word indices, accesses go through the virtual MemoryBus calls */
+template <class T>
+struct Bus
+{
+    T              t;
+    rv::MemoryBus& bus = t;
+    explicit Bus(std::size_t keys) : t(keys * 2) {}
+    std::uint32_t get(std::uint32_t k) { return bus.load_word(k * 4).value_or(0); }
+    void put(std::uint32_t k, std::uint32_t v) { bus.store_word(k * 4, v); }
+};
+
+/*
+workload
+*/
+enum class Dist { uniform, zipf, seq };
+
+struct Config
+{
+    std::string_view structure;
+    Dist             dist;
+    double           reads;
+    std::size_t      keys;
+    unsigned         threads;
+    std::size_t      ops;
+};
+
+struct Result
+{
+    Config        cfg;
+    double        mops;
+    std::uint32_t p50, p99, p999;
+    double        efficiency = 1.0;
+};
+
+static std::string_view dist_name(Dist d)
+{
+    switch (d) {
+      case Dist::uniform: return "uniform";
+      case Dist::zipf:    return "zipf";
+      case Dist::seq:     return "seq";
+    }
+    return "?";
+}
+
+/* YCSB's Zipfian generator (Gray et al.): rank 0 is the hottest */
+class Zipf
+{
+  public:
+    Zipf(std::size_t n, double theta = 0.99) : n_{static_cast<double>(n)}, theta_{theta}
+    {
+        for (std::size_t i = 1; i <= n; ++i) zetan_ += 1.0 / std::pow(static_cast<double>(i), theta);
+        const double zeta2 = 1.0 + 1.0 / std::pow(2.0, theta);
+        alpha_ = 1.0 / (1.0 - theta);
+        eta_   = (1.0 - std::pow(2.0 / n_, 1.0 - theta)) / (1.0 - zeta2 / zetan_);
+    }
+
+    template <class Rng>
+    std::size_t operator()(Rng& rng) const
+    {
+        const double u  = std::uniform_real_distribution<double>{0.0, 1.0}(rng);
+        const double uz = u * zetan_;
+        if (uz < 1.0) return 0;
+        if (uz < 1.0 + std::pow(0.5, theta_)) return 1;
+        const auto r = static_cast<std::size_t>(n_ * std::pow(eta_ * u - eta_ + 1.0, alpha_));
+        return std::min(r, static_cast<std::size_t>(n_) - 1);
+    }
+
+  private:
+    double n_, theta_, zetan_ = 0, alpha_ = 0, eta_ = 0;
+};
+
+/* key | write flag in the top bit */
+static std::vector<std::uint32_t> make_stream(const Config& c, const Zipf* zipf, unsigned id)
+{
+    std::mt19937_64 rng(0x5EED + id);
+    std::bernoulli_distribution is_read(c.reads);
+    std::vector<std::uint32_t> ops(stream_len);
+    std::size_t seq = c.keys / c.threads * id;
+    for (auto& op : ops) {
+        std::size_t k;
+        switch (c.dist) {
+          case Dist::uniform: k = rng() % c.keys; break;
+          case Dist::zipf: {
+              std::uint64_t x = (*zipf)(rng); // scatter ranks so hot keys aren't neighbours
+              x ^= x >> 33; x *= 0xff51afd7ed558ccdull; x ^= x >> 33;
+              k = x % c.keys;
+              break;
+          }
+          default: k = seq; seq = (seq + 1) % c.keys;
+        }
+        op = static_cast<std::uint32_t>(k) | (is_read(rng) ? 0 : write_bit);
+    }
+    return ops;
+}
+
+template <class Adapter>
+static Result run(const Config& c, const Zipf* zipf)
+{
+    Adapter a(c.keys);
+    for (std::size_t k = 0; k < c.keys; ++k) a.put(static_cast<std::uint32_t>(k), static_cast<std::uint32_t>(k));
+
+    std::vector<std::vector<std::uint32_t>> streams, lat(c.threads);
+    for (unsigned id = 0; id < c.threads; ++id) streams.push_back(make_stream(c, zipf, id));
+
+    std::atomic<std::uint64_t> sink{0};
+    std::latch start(c.threads);
+    // wall time runs from the first thread's start to the last one's finish (main may not get a core to time it)
+    std::vector<steady_clock::time_point> begin(c.threads), end(c.threads);
+    std::vector<std::thread> pool;
+    for (unsigned id = 0; id < c.threads; ++id)
+        pool.emplace_back([&, id] {
+            const auto& ops = streams[id];
+            auto& l = lat[id];
+            l.reserve(c.ops / sample_every + 1);
+            std::uint32_t sum = 0;
+            start.arrive_and_wait();
+            begin[id] = steady_clock::now();
+            for (std::size_t i = 0; i < c.ops; ++i) {
+                const std::uint32_t op = ops[i & (stream_len - 1)], k = op & ~write_bit;
+                const bool timed = i % sample_every == 0;
+                const auto t0 = timed ? steady_clock::now() : steady_clock::time_point{};
+                if (op & write_bit) a.put(k, static_cast<std::uint32_t>(i));
+                else          sum += a.get(k);
+                if (timed) l.push_back(static_cast<std::uint32_t>(duration_cast<nanoseconds>(steady_clock::now() - t0).count()));
+            }
+            end[id] = steady_clock::now();
+            sink += sum;
+        });
+    for (auto& t : pool) t.join();
+    const double secs = duration<double>(std::ranges::max(end) - std::ranges::min(begin)).count();
+
+    std::vector<std::uint32_t> all;   // parse() rejects --ops 0, so op 0 of every thread is a sample
+    for (auto& l : lat) all.insert(all.end(), l.begin(), l.end());
+    std::ranges::sort(all);
+    auto pct = [&](double p) { return all[static_cast<std::size_t>(p * static_cast<double>(all.size() - 1))]; };
+    return { c, static_cast<double>(c.threads * c.ops) / secs / 1e6, pct(0.5), pct(0.99), pct(0.999) };
+}
+
+struct Structure
+{
+    std::string_view name;
+    bool             concurrent;
+    std::size_t      max_keys;
+    Result         (*run)(const Config&, const Zipf*);
+};
+
+static constexpr std::size_t unlimited = ~std::size_t{0};
+
+static constexpr Structure structures[]{
+    { "hash_table",                false, unlimited, &run<Direct<Map>>   },
+    { "locked_hash_table",         true,  unlimited, &run<Locked>        },
+    { "concurrent_hash_table",     true,  unlimited, &run<Direct<Table>> },
+    { "pooled_hash_table",         true,  unlimited, &run<Direct<Pooled>>},
+    { "lock_free_list",            true,  1024,      &run<ListAdapter>   },
+    { "bus_hash_table",            false, 1u << 30,  &run<Bus<Map>>      },   // word address k * 4 must fit 32 bits
+    { "bus_concurrent_hash_table", true,  1u << 30,  &run<Bus<Table>>    },
+};
+
+/*
+command line
+*/
+struct Options
+{
+    std::vector<const Structure*> structures;
+    std::vector<Dist>             dists{ Dist::uniform, Dist::zipf, Dist::seq };
+    std::vector<double>           reads{ 0.5, 0.95 };
+    std::vector<std::size_t>      keys{ 1 << 16 };
+    std::vector<unsigned>         threads;
+    std::size_t                   ops = 200'000;
+    std::string                   json;
+};
+
+static Options parse(std::span<char*> args)
+{
+    Options o;
+    for (const auto& s : structures) o.structures.push_back(&s);
+    const unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned n = 1; n < hw; n *= 2) o.threads.push_back(n);
+    o.threads.push_back(hw);
+
+    cli::for_each_flag(args, [&](std::string_view flag, std::string_view val) {
+        if (flag == "--structures") {
+            o.structures.clear();
+            for (auto n : cli::split(val)) {
+                auto it = std::ranges::find(structures, n, &Structure::name);
+                if (it == std::end(structures)) throw std::invalid_argument(std::format("unknown structure '{}'", n));
+                o.structures.push_back(&*it);
+            }
+        } else if (flag == "--dist") {
+            o.dists.clear();
+            for (auto n : cli::split(val)) {
+                if      (n == "uniform") o.dists.push_back(Dist::uniform);
+                else if (n == "zipf")    o.dists.push_back(Dist::zipf);
+                else if (n == "seq")     o.dists.push_back(Dist::seq);
+                else throw std::invalid_argument(std::format("unknown distribution '{}'", n));
+            }
+        } else if (flag == "--reads") {
+            o.reads.clear();
+            for (auto n : cli::split(val)) {
+                const double r = std::stod(std::string{n});
+                if (r < 0.0 || r > 1.0) throw std::invalid_argument(std::format("read ratio {} outside 0..1", r));
+                o.reads.push_back(r);
+            }
+        } else if (flag == "--keys") {
+            o.keys.clear();
+            for (auto n : cli::split(val)) {
+                const auto k = cli::number<std::size_t>(n);
+                if (k > write_bit) throw std::invalid_argument(std::format("--keys {} above the limit of {}", k, write_bit));
+                o.keys.push_back(std::max<std::size_t>(k, 1));
+            }
+        } else if (flag == "--threads") {
+            o.threads.clear();
+            for (auto n : cli::split(val)) o.threads.push_back(std::max(cli::number<unsigned>(n), 1u));
+        } else if (flag == "--ops") {
+            o.ops = cli::number<std::size_t>(val);
+            if (o.ops == 0) throw std::invalid_argument("--ops must be at least 1");
+        } else if (flag == "--json") {
+            o.json = val;
+        } else {
+            return false;
+        }
+        return true;
+    });
+    return o;
+}
+
+static std::string to_json(const std::vector<Result>& results, const Options& o)
+{
+    std::vector<std::string> rows;
+    for (const auto& r : results)
+        rows.push_back(std::format("{{\"structure\": \"{}\", \"distribution\": \"{}\", \"read_ratio\": {}, \"keys\": {}, "
+                                   "\"threads\": {}, \"mops\": {:.3f}, \"p50_ns\": {}, \"p99_ns\": {}, \"p999_ns\": {}, "
+                                   "\"efficiency\": {:.3f}}}",
+                                   r.cfg.structure, dist_name(r.cfg.dist), r.cfg.reads, r.cfg.keys, r.cfg.threads,
+                                   r.mops, r.p50, r.p99, r.p999, r.efficiency));
+    return cli::json_report("ds_bench", { { "hardware_concurrency", std::format("{}", std::thread::hardware_concurrency()) },
+                                          { "ops_per_thread", std::format("{}", o.ops) },
+                                          { "latency_sample_every", std::format("{}", sample_every) } }, rows);
+}
+
+int main(int argc, char** argv)
+{
+    const auto parsed = cli::parse_args("ds_bench", argc, argv, parse);
+    if (!parsed) return EXIT_FAILURE;
+    const Options& opt = *parsed;
+    const bool table = opt.json != "-";
+
+    if (table)
+        std::cout << std::format("{:<26} {:>8} {:>6} {:>8} {:>4} {:>9} {:>7} {:>7} {:>8} {:>6}\n",
+                                 "structure", "dist", "reads", "keys", "thr", "Mops/s", "p50 ns", "p99 ns", "p999 ns", "eff");
+
+    std::vector<Result> results;
+    for (std::size_t keys : opt.keys) {
+        for (Dist d : opt.dists) {
+            for (const Structure* s : opt.structures) {
+                const std::size_t n = std::min(keys, s->max_keys);
+                const Zipf zipf(d == Dist::zipf ? n : 1);
+                for (double r : opt.reads) {
+                    double base = 0;
+                    for (unsigned t : opt.threads) {
+                        if (t > 1 && !s->concurrent) continue;
+                        Result res = s->run({ s->name, d, r, n, t, opt.ops }, &zipf);
+                        if (base == 0) base = res.mops / t;
+                        res.efficiency = res.mops / (base * t);
+                        results.push_back(res);
+                        if (table)
+                            std::cout << std::format("{:<26} {:>8} {:>6.2f} {:>8} {:>4} {:>9.2f} {:>7} {:>7} {:>8} {:>6.2f}\n",
+                                                     s->name, dist_name(d), r, n, t, res.mops,
+                                                     res.p50, res.p99, res.p999, res.efficiency);
+                    }
+                }
+            }
+        }
+    }
+
+    if (!opt.json.empty() && !cli::write_json("ds_bench", opt.json, to_json(results, opt), results.size()))
+        return EXIT_FAILURE;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,450 @@
+#pragma once
+#include "memory_bus.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <string_view>
+#include <vector>
+
+/*
+Guest kernels for timing the interpreter (cpu_bench).
+
+Each kernel reads its parameters from words at param_addr, stores one result word at
+result_addr and halts on its final `jalr x0, x0, 0`. `setup` writes the parameters and
+input data for a repeat count, `expect` computes the same result on the host, so every
+timed run is also a correctness check. At `reps` each kernel retires ~20M instructions.
+*/
+namespace guest {
+
+inline constexpr std::uint32_t param_addr  = 0x700; // p0, p1, p2 (reachable with a 12-bit lw offset)
+inline constexpr std::uint32_t result_addr = 0x720;
+inline constexpr std::uint32_t data_base   = 0x1'0000;
+
+struct Kernel
+{
+    std::string_view name;
+    std::string_view src;
+    std::uint32_t    reps;
+    void          (*setup)(rv::MemoryBus&, std::uint32_t reps);
+    std::uint32_t (*expect)(std::uint32_t reps);
+};
+
+namespace kernels {
+
+inline void params(rv::MemoryBus& m, std::uint32_t p0, std::uint32_t p1 = 0, std::uint32_t p2 = 0)
+{
+    m.store_word(param_addr, p0);
+    m.store_word(param_addr + 4, p1);
+    m.store_word(param_addr + 8, p2);
+}
+
+inline std::uint32_t fill_word(std::uint32_t i) noexcept { return i * 2654435761u; }
+
+inline std::uint32_t xorshift(std::uint32_t& s) noexcept
+{
+    s ^= s << 13; s ^= s >> 17; s ^= s << 5;
+    return s;
+}
+
+/* ---- int_loop: shift/add/xor hash of a counter, no memory traffic ---- */
+inline constexpr std::string_view int_loop_src = R"(
+start:
+    lw   x1, 1792(x0)     # iterations
+    addi x2, x0, 0        # h
+    addi x3, x0, 0        # i
+loop:
+    slli x4, x2, 5
+    add  x2, x2, x4       # h *= 33
+    xor  x2, x2, x3       # h ^= i
+    srli x5, x2, 7
+    xor  x2, x2, x5       # h ^= h >> 7
+    addi x3, x3, 1
+    bne  x3, x1, loop
+    sw   x2, 1824(x0)
+    jalr x0, x0, 0        # halt
+)";
+inline constexpr std::uint32_t int_loop_iters = 1 << 16; // per rep
+
+inline void int_loop_setup(rv::MemoryBus& m, std::uint32_t reps) { params(m, reps * int_loop_iters); }
+
+inline std::uint32_t int_loop_expect(std::uint32_t reps)
+{
+    std::uint32_t h = 0;
+    for (std::uint32_t i = 0; i < reps * int_loop_iters; ++i) {
+        h += h << 5;
+        h ^= i;
+        h ^= h >> 7;
+    }
+    return h;
+}
+
+/* ---- memcpy: copy 16 KiB word by word, summing what was copied ---- */
+inline constexpr std::string_view memcpy_src = R"(
+start:
+    lw   x10, 1792(x0)    # words
+    lw   x11, 1796(x0)    # reps
+    lui  x12, 16          # src = 0x10000
+    lui  x13, 32          # dst = 0x20000
+    slli x14, x10, 2
+    add  x14, x14, x12    # src end
+    addi x7, x0, 0        # sum
+rep:
+    add  x1, x12, x0
+    add  x2, x13, x0
+copy:
+    lw   x5, 0(x1)
+    sw   x5, 0(x2)
+    add  x7, x7, x5
+    addi x1, x1, 4
+    addi x2, x2, 4
+    bne  x1, x14, copy
+    addi x11, x11, -1
+    bne  x11, x0, rep
+    sw   x7, 1824(x0)
+    jalr x0, x0, 0        # halt
+)";
+inline constexpr std::uint32_t memcpy_words = 4096;
+
+inline void memcpy_setup(rv::MemoryBus& m, std::uint32_t reps)
+{
+    params(m, memcpy_words, reps);
+    for (std::uint32_t i = 0; i < memcpy_words; ++i) m.store_word(data_base + i * 4, fill_word(i));
+}
+
+inline std::uint32_t memcpy_expect(std::uint32_t reps)
+{
+    std::uint32_t sum = 0;
+    for (std::uint32_t i = 0; i < memcpy_words; ++i) sum += fill_word(i);
+    return sum * reps;
+}
+
+/* ---- bubble_sort: xorshift-fill 256 words, sort them unsigned, fold sum(a[i] ^ i) ---- */
+inline constexpr std::string_view bubble_sort_src = R"(
+start:
+    lw   x20, 1792(x0)    # n
+    lw   x21, 1796(x0)    # reps
+    lw   x24, 1800(x0)    # xorshift state
+    lui  x22, 16          # a = 0x10000
+    addi x25, x0, 0       # checksum
+rep:
+    add  x1, x22, x0
+    slli x2, x20, 2
+    add  x2, x2, x22      # end
+fill:
+    slli x3, x24, 13
+    xor  x24, x24, x3
+    srli x3, x24, 17
+    xor  x24, x24, x3
+    slli x3, x24, 5
+    xor  x24, x24, x3
+    sw   x24, 0(x1)
+    addi x1, x1, 4
+    bne  x1, x2, fill
+    addi x2, x2, -4       # last unsorted element
+outer:
+    beq  x2, x22, sorted
+    add  x1, x22, x0
+inner:
+    lw   x3, 0(x1)
+    lw   x4, 4(x1)
+    bgeu x4, x3, ordered
+    sw   x4, 0(x1)
+    sw   x3, 4(x1)
+ordered:
+    addi x1, x1, 4
+    bne  x1, x2, inner
+    addi x2, x2, -4
+    jal  x0, outer
+sorted:
+    add  x1, x22, x0
+    slli x2, x20, 2
+    add  x2, x2, x22
+    addi x5, x0, 0        # i
+sum:
+    lw   x3, 0(x1)
+    xor  x3, x3, x5
+    add  x25, x25, x3
+    addi x5, x5, 1
+    addi x1, x1, 4
+    bne  x1, x2, sum
+    addi x21, x21, -1
+    bne  x21, x0, rep
+    sw   x25, 1824(x0)
+    jalr x0, x0, 0        # halt
+)";
+inline constexpr std::uint32_t sort_n    = 256;
+inline constexpr std::uint32_t sort_seed = 2463534242u;
+
+inline void bubble_sort_setup(rv::MemoryBus& m, std::uint32_t reps) { params(m, sort_n, reps, sort_seed); }
+
+inline std::uint32_t bubble_sort_expect(std::uint32_t reps)
+{
+    std::uint32_t s = sort_seed, sum = 0;
+    std::vector<std::uint32_t> a(sort_n);
+    for (std::uint32_t r = 0; r < reps; ++r) {
+        for (auto& v : a) v = xorshift(s);
+        std::ranges::sort(a);
+        for (std::uint32_t i = 0; i < sort_n; ++i) sum += a[i] ^ i;
+    }
+    return sum;
+}
+
+/* ---- crc32: bitwise MSB-first CRC-32 (poly 0x04C11DB7) over 4 KiB, branch-free inner loop ---- */
+inline constexpr std::string_view crc32_src = R"(
+start:
+    lw   x20, 1792(x0)    # words
+    lw   x21, 1796(x0)    # reps
+    lui  x22, 16          # data = 0x10000
+    slli x23, x20, 2
+    add  x23, x23, x22    # end
+    lui  x11, 19474
+    addi x11, x11, -585   # poly = 0x04C11DB7
+    addi x10, x0, -1      # crc = ~0
+rep:
+    add  x1, x22, x0
+word:
+    lw   x3, 0(x1)
+    xor  x10, x10, x3
+    addi x4, x0, 32
+bit:
+    srai x5, x10, 31      # all ones if the top bit is set
+    and  x5, x5, x11
+    slli x10, x10, 1
+    xor  x10, x10, x5
+    addi x4, x4, -1
+    bne  x4, x0, bit
+    addi x1, x1, 4
+    bne  x1, x23, word
+    addi x21, x21, -1
+    bne  x21, x0, rep
+    xori x10, x10, -1
+    sw   x10, 1824(x0)
+    jalr x0, x0, 0        # halt
+)";
+inline constexpr std::uint32_t crc_words = 1024;
+
+inline void crc32_setup(rv::MemoryBus& m, std::uint32_t reps)
+{
+    params(m, crc_words, reps);
+    for (std::uint32_t i = 0; i < crc_words; ++i) m.store_word(data_base + i * 4, fill_word(i));
+}
+
+inline std::uint32_t crc32_expect(std::uint32_t reps)
+{
+    std::uint32_t crc = ~0u;
+    for (std::uint32_t r = 0; r < reps; ++r)
+        for (std::uint32_t i = 0; i < crc_words; ++i) {
+            crc ^= fill_word(i);
+            for (int b = 0; b < 32; ++b) crc = (crc << 1) ^ ((crc & 0x8000'0000u) ? 0x04C1'1DB7u : 0u);
+        }
+    return ~crc;
+}
+
+/* ---- matmul: 16x16 words, C = A * B with a shift-and-add multiply subroutine (no M extension) ---- */
+inline constexpr std::string_view matmul_src = R"(
+start:
+    jal  x0, main
+mul:                      # x12 = x10 * x11, clobbers x10 x11 x13
+    addi x12, x0, 0
+mul_loop:
+    beq  x11, x0, mul_done
+    andi x13, x11, 1
+    beq  x13, x0, mul_skip
+    add  x12, x12, x10
+mul_skip:
+    slli x10, x10, 1
+    srli x11, x11, 1
+    jal  x0, mul_loop
+mul_done:
+    jalr x0, 0(x1)
+main:
+    lw   x20, 1792(x0)    # n
+    lw   x21, 1796(x0)    # reps
+    slli x22, x20, 2      # row stride
+rep:
+    lui  x23, 16          # row of A = 0x10000
+    lui  x24, 48          # out = C = 0x30000
+    addi x25, x0, 0       # i
+iloop:
+    addi x26, x0, 0       # j
+    lui  x27, 32          # column of B = 0x20000
+jloop:
+    addi x28, x0, 0       # acc
+    add  x29, x23, x0
+    add  x30, x27, x0
+    addi x31, x0, 0       # k
+kloop:
+    lw   x10, 0(x29)
+    lw   x11, 0(x30)
+    jal  x1, mul
+    add  x28, x28, x12
+    addi x29, x29, 4
+    add  x30, x30, x22
+    addi x31, x31, 1
+    bne  x31, x20, kloop
+    sw   x28, 0(x24)
+    addi x24, x24, 4
+    addi x27, x27, 4
+    addi x26, x26, 1
+    bne  x26, x20, jloop
+    add  x23, x23, x22
+    addi x25, x25, 1
+    bne  x25, x20, iloop
+    addi x21, x21, -1
+    bne  x21, x0, rep
+    lui  x2, 48
+    addi x5, x0, 0        # i
+    addi x7, x0, 0        # checksum
+csum:
+    lw   x3, 0(x2)
+    xor  x3, x3, x5
+    add  x7, x7, x3
+    addi x5, x5, 1
+    addi x2, x2, 4
+    bne  x2, x24, csum
+    sw   x7, 1824(x0)
+    jalr x0, x0, 0        # halt
+)";
+inline constexpr std::uint32_t mat_n = 16;
+
+inline std::uint32_t mat_a(std::uint32_t i) noexcept { return fill_word(i) >> 24; }
+inline std::uint32_t mat_b(std::uint32_t i) noexcept { return fill_word(i + 977) >> 24; }
+
+inline void matmul_setup(rv::MemoryBus& m, std::uint32_t reps)
+{
+    params(m, mat_n, reps);
+    for (std::uint32_t i = 0; i < mat_n * mat_n; ++i) {
+        m.store_word(data_base + i * 4, mat_a(i));
+        m.store_word(0x2'0000 + i * 4, mat_b(i));
+    }
+}
+
+inline std::uint32_t matmul_expect(std::uint32_t)
+{
+    std::uint32_t sum = 0;
+    for (std::uint32_t i = 0; i < mat_n; ++i)
+        for (std::uint32_t j = 0; j < mat_n; ++j) {
+            std::uint32_t c = 0;
+            for (std::uint32_t k = 0; k < mat_n; ++k) c += mat_a(i * mat_n + k) * mat_b(k * mat_n + j);
+            sum += c ^ (i * mat_n + j);
+        }
+    return sum;
+}
+
+/* ---- pointer_chase: walk a random cycle through 16384 16-byte nodes (256 KiB) ---- */
+inline constexpr std::string_view pointer_chase_src = R"(
+start:
+    lw   x1, 1792(x0)     # node
+    lw   x2, 1796(x0)     # steps
+    addi x3, x0, 0        # sum
+chase:
+    lw   x4, 4(x1)
+    add  x3, x3, x4
+    lw   x1, 0(x1)
+    addi x2, x2, -1
+    bne  x2, x0, chase
+    sw   x3, 1824(x0)
+    jalr x0, x0, 0        # halt
+)";
+inline constexpr std::uint32_t chase_nodes = 1 << 14;
+
+/* visiting order of the cycle: node k lives at data_base + 16k as {next, value} */
+inline std::vector<std::uint32_t> chase_order()
+{
+    std::vector<std::uint32_t> order(chase_nodes);
+    std::iota(order.begin(), order.end(), 0u);
+    std::shuffle(order.begin(), order.end(), std::mt19937{ 4242 });
+    return order;
+}
+inline std::uint32_t chase_value(std::uint32_t k) noexcept { return k * 7 + 1; }
+
+inline void pointer_chase_setup(rv::MemoryBus& m, std::uint32_t reps)
+{
+    const auto order = chase_order();
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        const std::uint32_t node = data_base + order[i] * 16, next = data_base + order[(i + 1) % order.size()] * 16;
+        m.store_word(node, next);
+        m.store_word(node + 4, chase_value(order[i]));
+    }
+    params(m, data_base + order[0] * 16, reps * chase_nodes);
+}
+
+inline std::uint32_t pointer_chase_expect(std::uint32_t reps)
+{
+    std::uint32_t sum = 0;
+    for (std::uint32_t k = 0; k < chase_nodes; ++k) sum += chase_value(k); // each rep visits every node once
+    return sum * reps;
+}
+
+/* ---- branchy: bucket xorshift bytes into quarters with a compare chain (unpredictable branches) ---- */
+inline constexpr std::string_view branchy_src = R"(
+start:
+    lw   x2, 1792(x0)     # iterations
+    lw   x24, 1796(x0)    # xorshift state
+    addi x10, x0, 0
+    addi x11, x0, 0
+    addi x12, x0, 0
+    addi x13, x0, 0
+    addi x6, x0, 64
+    addi x7, x0, 128
+    addi x8, x0, 192
+loop:
+    slli x3, x24, 13
+    xor  x24, x24, x3
+    srli x3, x24, 17
+    xor  x24, x24, x3
+    slli x3, x24, 5
+    xor  x24, x24, x3
+    andi x3, x24, 255
+    bltu x3, x6, q0
+    bltu x3, x7, q1
+    bltu x3, x8, q2
+    addi x13, x13, 1
+    jal  x0, next
+q0:
+    addi x10, x10, 1
+    jal  x0, next
+q1:
+    addi x11, x11, 1
+    jal  x0, next
+q2:
+    addi x12, x12, 1
+next:
+    addi x2, x2, -1
+    bne  x2, x0, loop
+    slli x11, x11, 7
+    slli x12, x12, 14
+    slli x13, x13, 21
+    xor  x10, x10, x11
+    xor  x10, x10, x12
+    xor  x10, x10, x13
+    sw   x10, 1824(x0)
+    jalr x0, x0, 0        # halt
+)";
+inline constexpr std::uint32_t branchy_iters = 1 << 16; // per rep
+
+inline void branchy_setup(rv::MemoryBus& m, std::uint32_t reps) { params(m, reps * branchy_iters, sort_seed); }
+
+inline std::uint32_t branchy_expect(std::uint32_t reps)
+{
+    std::uint32_t s = sort_seed;
+    std::array<std::uint32_t, 4> q{};
+    for (std::uint32_t i = 0; i < reps * branchy_iters; ++i) ++q[(xorshift(s) & 255) / 64];
+    return q[0] ^ (q[1] << 7) ^ (q[2] << 14) ^ (q[3] << 21);
+}
+
+} // namespace kernels
+
+inline constexpr std::array bench_kernels{
+    Kernel{ "int_loop",      kernels::int_loop_src,      48,  kernels::int_loop_setup,      kernels::int_loop_expect      },
+    Kernel{ "memcpy",        kernels::memcpy_src,        800, kernels::memcpy_setup,        kernels::memcpy_expect        },
+    Kernel{ "bubble_sort",   kernels::bubble_sort_src,   100, kernels::bubble_sort_setup,   kernels::bubble_sort_expect   },
+    Kernel{ "crc32",         kernels::crc32_src,         100, kernels::crc32_setup,         kernels::crc32_expect         },
+    Kernel{ "matmul",        kernels::matmul_src,        80,  kernels::matmul_setup,        kernels::matmul_expect        },
+    Kernel{ "pointer_chase", kernels::pointer_chase_src, 250, kernels::pointer_chase_setup, kernels::pointer_chase_expect },
+    Kernel{ "branchy",       kernels::branchy_src,       22,  kernels::branchy_setup,       kernels::branchy_expect       },
+};
+
+} // namespace guest
@@ -0,0 +1,116 @@
+#pragma once
+#include "memory_bus.hpp"
+#include "riscv.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+/*
+Small guest assembly workloads shared by the example programs, and the plumbing to run them.
+Each one halts on its final `jalr x0, x0, 0`: run_to_halt() steps the CPU until pc reaches
+the last word.
+*/
+namespace guest {
+
+/* a plain word array (size a power of two, addresses wrap): memory reduced to an index */
+struct FlatRam : rv::MemoryBus
+{
+    explicit FlatRam(std::size_t n_words = std::size_t{1} << 20) : words(n_words) {}
+
+    std::vector<std::uint32_t> words;
+
+    std::optional<std::uint32_t> load_word(std::uint32_t a) override { return words[(a >> 2) & (words.size() - 1)]; }
+    bool store_word(std::uint32_t a, std::uint32_t v) override { words[(a >> 2) & (words.size() - 1)] = v; return true; }
+};
+
+/* assembled program words from address 0 up */
+inline void load_program(rv::MemoryBus& mem, std::span<const std::uint32_t> words)
+{
+    for (std::size_t i = 0; i < words.size(); ++i) mem.store_word(static_cast<std::uint32_t>(i * 4), words[i]);
+}
+
+/* address of the program's final (halting) word */
+inline std::uint32_t halt_pc(std::span<const std::uint32_t> words)
+{
+    return static_cast<std::uint32_t>((words.size() - 1) * 4);
+}
+
+/* step until pc reaches the halting word; returns the instructions executed */
+inline std::uint64_t run_to_halt(rv::RiscV& cpu, std::span<const std::uint32_t> words)
+{
+    const std::uint32_t stop = halt_pc(words);
+    std::uint64_t n = 0;
+    while (cpu.pc() != stop) { cpu.step(); ++n; }
+    return n;
+}
+
+struct Program
+{
+    std::string_view name;
+    std::string_view src;
+};
+
+// main.cpp's sum program
+inline constexpr std::string_view sum_src = R"(
+start:
+    addi x1, x0, 11       # loop upper-bound (exclusive)
+    addi x2, x0, 0        # sum
+    addi x3, x0, 1        # i = 1
+loop:
+    add  x2, x2, x3
+    addi x3, x3, 1
+    bne  x3, x1, loop
+    sw   x2, 32(x0)
+    jalr x0, x0, 0        # halt
+)";
+
+// fill a 128x128 word-per-pixel buffer at 0x1000 with one colour
+inline constexpr std::string_view fb_fill_src = R"(
+start:
+    addi x1, x0, 1024
+    add  x1, x1, x1
+    add  x1, x1, x1       # x1 = 0x1000 (buffer base)
+    add  x2, x1, x1
+    add  x2, x2, x2
+    add  x2, x2, x2
+    add  x2, x2, x2       # x2 = 0x10000 (128*128 words)
+    add  x2, x2, x1       # x2 = end
+    addi x3, x0, 255      # colour
+fill:
+    sw   x3, 0(x1)
+    addi x1, x1, 4
+    bne  x1, x2, fill
+    jalr x0, x0, 0        # halt
+)";
+
+// read the same buffer back and sum it
+inline constexpr std::string_view fb_sum_src = R"(
+start:
+    addi x1, x0, 1024
+    add  x1, x1, x1
+    add  x1, x1, x1       # x1 = 0x1000
+    add  x2, x1, x1
+    add  x2, x2, x2
+    add  x2, x2, x2
+    add  x2, x2, x2
+    add  x2, x2, x1       # x2 = end
+    addi x4, x0, 0        # sum
+sum:
+    lw   x3, 0(x1)
+    add  x4, x4, x3
+    addi x1, x1, 4
+    bne  x1, x2, sum
+    jalr x0, x0, 0        # halt
+)";
+
+inline constexpr std::array programs{
+    Program{ "sum",     sum_src     },
+    Program{ "fb_fill", fb_fill_src },
+    Program{ "fb_sum",  fb_sum_src  },
+};
+
+} // namespace guest
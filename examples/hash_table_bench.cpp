@@ -0,0 +1,170 @@
+#include "hash_table.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <utility>
+#include <vector>
+
+/*
+HashTable (Swiss layout) vs the previous linear-probing table on a lookup-heavy load.
+Both tables get the same fixed capacity and are filled to 50..90% with random word
+addresses, then answer a stream of lookups (75% hits, 25% misses). The legacy table never
+rehashes here, so it runs at the same load as the new one. Also times an erase/reinsert
+churn on the Swiss table to show tombstones being compacted.
+*/
+
+using namespace std::chrono;
+
+/* the array-of-structs linear-probing table HashTable used to be, minus its rehash (callers size it) */
+template <typename K, typename V>
+class LinearProbeTable
+{
+    enum class BucketState : std::uint8_t { empty, full, tomb };
+    struct Bucket {
+        K            key;
+        V            val;
+        BucketState  st{BucketState::empty};
+    };
+
+  public:
+    explicit LinearProbeTable(std::size_t cap) : buckets_(cap) {}
+
+    [[nodiscard]] std::optional<V> get(const K& key) const
+    {
+        auto idx = probe(key);
+        if (buckets_[idx].st == BucketState::full) return buckets_[idx].val;
+        return std::nullopt;
+    }
+
+    bool put(const K& key, const V& val)
+    {
+        auto idx = probe(key);
+        bool replaced = buckets_[idx].st == BucketState::full;
+        buckets_[idx] = Bucket{key, val, BucketState::full};
+        if (!replaced) ++size_;
+        return replaced;
+    }
+
+  private:
+    std::vector<Bucket> buckets_;
+    std::size_t         size_ = 0;
+    std::hash<K>        hasher_;
+
+    std::size_t probe(const K& key) const
+    {
+        std::size_t mask = buckets_.size() - 1;
+        std::size_t i    = hasher_(key) & mask;
+        while (buckets_[i].st != BucketState::empty && (buckets_[i].st == BucketState::tomb || buckets_[i].key != key))
+            i = (i + 1) & mask;
+        return i;
+    }
+};
+
+static constexpr std::size_t   capacity = 1 << 20;
+static constexpr std::uint32_t lookups  = 1u << 23;
+
+template <class F>
+static double ns_per(std::uint64_t n, F&& body)
+{
+    auto t0 = steady_clock::now();
+    body();
+    return static_cast<double>(duration_cast<nanoseconds>(steady_clock::now() - t0).count()) / static_cast<double>(n);
+}
+
+/* word-aligned addresses, drawn without repeats so `present` and `absent` never overlap */
+static void make_keys(std::size_t n_present, std::vector<std::uint32_t>& present, std::vector<std::uint32_t>& absent)
+{
+    std::mt19937 rng(12345);
+    std::vector<std::uint32_t> all;
+    all.reserve(n_present + n_present / 3 + 1);
+    rv::HashTable<std::uint32_t, bool> seen(n_present * 2);
+    while (all.size() < n_present + n_present / 3 + 1) {
+        const std::uint32_t a = rng() & ~3u;
+        if (!seen.put(a, true)) all.push_back(a);
+    }
+    present.assign(all.begin(), all.begin() + static_cast<std::ptrdiff_t>(n_present));
+    absent.assign(all.begin() + static_cast<std::ptrdiff_t>(n_present), all.end());
+}
+
+/* ns per get() over a fixed random query mix; the value sum lets the two tables be compared */
+template <class Table>
+static double lookup_ns(const Table& t, const std::vector<std::uint32_t>& present,
+                        const std::vector<std::uint32_t>& absent, std::uint64_t& checksum)
+{
+    std::mt19937 rng(777);
+    std::vector<std::uint32_t> q(1 << 16);
+    for (auto& k : q) {
+        k = (rng() & 3) ? present[rng() % present.size()] : absent[rng() % absent.size()];
+    }
+    std::uint64_t sum = 0;
+    const double ns = ns_per(lookups, [&] {
+        for (std::uint32_t i = 0; i < lookups; ++i)
+            sum += t.get(q[i & (q.size() - 1)]).value_or(0);
+    });
+    checksum = sum;
+    return ns;
+}
+
+int main()
+{
+    std::cout << std::format("capacity {} slots, {} lookups per row (75% hits)\n\n", capacity, lookups);
+    std::cout << std::format("{:>5} {:>10} {:>14} {:>14} {:>8}\n", "load", "keys", "linear ns/op", "swiss ns/op", "speedup");
+
+    bool ok = true;
+    for (int pct = 50; pct <= 90; pct += 10) {
+        const std::size_t n = capacity * static_cast<std::size_t>(pct) / 100;
+        std::vector<std::uint32_t> present, absent;
+        make_keys(n, present, absent);
+
+        LinearProbeTable<std::uint32_t, std::uint32_t> linear(capacity);
+        rv::HashTable<std::uint32_t, std::uint32_t>    swiss(capacity);
+        for (std::uint32_t k : present) {
+            linear.put(k, k ^ 0x5A5A5A5A);
+            swiss.put(k, k ^ 0x5A5A5A5A);
+        }
+        if (swiss.capacity() != capacity) { std::cout << "swiss table grew unexpectedly\n"; ok = false; }
+
+        std::uint64_t sum_linear = 0, sum_swiss = 0;
+        const double ns_linear = lookup_ns(linear, present, absent, sum_linear);
+        const double ns_swiss  = lookup_ns(swiss,  present, absent, sum_swiss);
+        if (sum_linear != sum_swiss) { std::cout << "lookup results differ\n"; ok = false; }
+
+        std::cout << std::format("{:>4}% {:>10} {:>14.2f} {:>14.2f} {:>7.2f}x\n",
+                                 pct, n, ns_linear, ns_swiss, ns_linear / ns_swiss);
+    }
+
+    // erase/reinsert at 80% load: tombstones build up until an in-place rehash clears them
+    {
+        const std::size_t n = capacity * 8 / 10;
+        std::vector<std::uint32_t> present, absent;
+        make_keys(n, present, absent);
+        rv::HashTable<std::uint32_t, std::uint32_t> t(capacity);
+        for (std::uint32_t k : present) t.put(k, k);
+
+        std::mt19937 rng(99);
+        std::size_t max_tombs = 0;
+        const std::uint64_t ops = 1u << 22;
+        const double ns = ns_per(ops, [&] {
+            for (std::uint64_t i = 0; i < ops; ++i) {
+                const std::size_t j = rng() % present.size(), m = rng() % absent.size();
+                t.erase(present[j]);
+                t.put(absent[m], absent[m]);
+                std::swap(present[j], absent[m]);
+                max_tombs = std::max(max_tombs, t.tombstones());
+            }
+        });
+        bool content = t.size() == present.size();
+        for (std::uint32_t k : present) content &= t.get(k) == k;
+        for (std::uint32_t k : absent)  content &= !t.get(k);
+        ok &= content && t.capacity() == capacity;
+        std::cout << std::format("\nchurn at 80%: {:.1f} ns per erase+insert, peak tombstones {}, capacity {} -> {}\n",
+                                 ns, max_tombs, capacity, t.capacity());
+    }
+
+    std::cout << (ok ? "results ok\n" : "MISMATCH\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,157 @@
+#include "cache.hpp"
+#include "clint.hpp"
+#include "hash_table.hpp"
+#include "irq_controller.hpp"
+#include "mmio_window.hpp"
+#include "riscv.hpp"
+#include "rv_assembler.hpp"
+#include "guest_programs.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <string_view>
+
+/*
+Timer and external interrupts versus polling.
+Two guests do the same job for two emulated seconds at 20 MHz: count 1 ms timer ticks
+(20000 cycles) and the vsync interrupt the "frontend" raises every 1/60 s. The busy guest
+spins on MTIME and the PENDING register; the WFI guest programs MTIMECMP, enables MTIE and
+MEIE, and sleeps in WFI, so RiscV::run() skips straight to the next event. Both must see
+the same ticks and vsyncs, and the WFI guest should retire a tiny fraction of the
+instructions.
+*/
+
+using namespace std::chrono;
+
+static constexpr std::uint64_t frame_cycles = 20'000'000 / 60;
+static constexpr int           frames       = 120;
+static constexpr std::uint64_t tick_cycles  = 20'000;
+
+// x20 counts ticks, x21 vsyncs
+static constexpr std::string_view busy_src = R"(
+start:
+    lui  x3, 8204         # 0x0200'C000: MTIME at -8
+    lui  x4, 131077       # 0x2000'5000 IRQ controller
+    lui  x5, 5
+    addi x5, x5, -480     # 20000 cycles per tick
+    lw   x6, -8(x3)
+    add  x6, x6, x5       # next tick
+poll:
+    lw   x9, 0(x4)        # PENDING
+    beq  x9, x0, time
+    sw   x9, 0(x4)        # acknowledge
+    addi x21, x21, 1
+time:
+    lw   x7, -8(x3)
+    sub  x8, x7, x6
+    blt  x8, x0, poll
+    addi x20, x20, 1
+    add  x6, x6, x5
+    jal  x0, poll
+)";
+
+// only the low word of MTIMECMP is advanced, which is plenty for a few seconds
+static constexpr std::string_view wfi_src = R"(
+start:
+    jal  x8, main         # x8 = handler
+handler:
+    csrrs x9, mcause, x0
+    andi x9, x9, 31
+    addi x10, x0, 7       # machine timer?
+    bne  x9, x10, ext
+    lw   x11, 0(x2)
+    add  x11, x11, x5
+    sw   x11, 0(x2)       # MTIMECMP += period
+    addi x20, x20, 1
+    mret
+ext:
+    lw   x11, 0(x4)       # PENDING
+    sw   x11, 0(x4)       # acknowledge
+    addi x21, x21, 1
+    mret
+main:
+    lui  x2, 8196         # 0x0200'4000 MTIMECMP
+    lui  x3, 8204
+    lui  x4, 131077
+    lui  x5, 5
+    addi x5, x5, -480
+    csrrw x0, mtvec, x8
+    addi x6, x0, 1
+    slli x6, x6, 11       # MEIE
+    ori  x6, x6, 128      # MTIE
+    csrrw x0, mie, x6
+    addi x6, x0, 1
+    sw   x6, 4(x4)        # ENABLE = vsync
+    sw   x0, 4(x2)        # MTIMECMPH = 0
+    lw   x7, -8(x3)
+    add  x7, x7, x5
+    sw   x7, 0(x2)        # first tick
+    csrrsi x0, mstatus, 8 # MIE
+idle:
+    wfi
+    jal  x0, idle
+)";
+
+struct Result
+{
+    std::uint64_t instructions = 0;
+    std::uint64_t cycles       = 0;
+    std::uint32_t ticks        = 0;
+    std::uint32_t vsyncs       = 0;
+    double        host_ms      = 0;
+};
+
+static Result run(std::string_view src)
+{
+    const auto program = rv::assemble(src);
+    auto dram = std::make_unique<rv::HashTable<std::uint32_t,std::uint32_t>>(1 << 12);
+    guest::load_program(*dram, program);
+
+    auto window = std::make_unique<rv::MmioWindow>(std::move(dram));
+    rv::MmioWindow& io = *window;
+    auto& irq = static_cast<rv::IrqController&>(io.map("irq", rv::IrqController::default_base,
+                                                       rv::IrqController::window_size,
+                                                       std::make_unique<rv::IrqController>()));
+    rv::Cache l1{ 64, 2, std::move(window) };
+    l1.set_attribute(rv::Clint::default_base, rv::Clint::window_size, rv::MemAttr::uncached);
+    l1.set_attribute(rv::IrqController::default_base, rv::IrqController::window_size, rv::MemAttr::uncached);
+    rv::RiscV cpu{ l1 };
+    io.map("clint", rv::Clint::default_base, rv::Clint::window_size, std::make_unique<rv::Clint>(cpu));
+    irq.on_line = [&cpu](bool level) { cpu.set_external_irq(level); };
+
+    const auto t0 = steady_clock::now();
+    for (int f = 0; f < frames; ++f) {
+        irq.raise(rv::IrqController::vsync);
+        cpu.run(frame_cycles, cpu.cycle() + frame_cycles);
+    }
+    Result res;
+    res.host_ms      = duration<double, std::milli>(steady_clock::now() - t0).count();
+    res.instructions = cpu.instret();
+    res.cycles       = cpu.cycle();
+    res.ticks        = cpu.reg(20);
+    res.vsyncs       = cpu.reg(21);
+    return res;
+}
+
+int main()
+{
+    const Result busy = run(busy_src);
+    const Result wfi  = run(wfi_src);
+
+    std::cout << std::format("{:<6} {:>14} {:>12} {:>8} {:>8} {:>8} {:>10}\n",
+                             "guest", "instructions", "cycles", "idle %", "ticks", "vsyncs", "host ms");
+    for (const auto& [name, r] : { std::pair{ "busy", busy }, std::pair{ "wfi", wfi } })
+        std::cout << std::format("{:<6} {:>14} {:>12} {:>8.1f} {:>8} {:>8} {:>10.2f}\n",
+                                 name, r.instructions, r.cycles,
+                                 r.cycles ? 100.0 * double(r.cycles - r.instructions) / double(r.cycles) : 0.0,
+                                 r.ticks, r.vsyncs, r.host_ms);
+
+    const auto expected_ticks = static_cast<std::int64_t>(frames * frame_cycles / tick_cycles);
+    const auto ticks_ok = [&](const Result& r) { return std::abs(std::int64_t{ r.ticks } - expected_ticks) <= 1; };
+    const bool ok = ticks_ok(busy) && ticks_ok(wfi) && busy.vsyncs == frames && wfi.vsyncs == frames &&
+                    wfi.instructions * 100 < busy.instructions;
+    std::cout << (ok ? "WFI guest kept time with a fraction of the work\n" : "UNEXPECTED tick/vsync/instruction counts\n");
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
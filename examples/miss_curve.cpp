@@ -0,0 +1,143 @@
+#include "cache.hpp"
+#include "hash_table.hpp"
+#include "riscv.hpp"
+#include "rv_assembler.hpp"
+#include "stack_distance.hpp"
+#include "guest_programs.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+Miss-ratio curves for every cache size from one pass.
+
+    miss_curve [csv-path] [accesses]
+
+Runs guest programs through a StackDistanceAnalyzer and checks its predicted miss counts
+against real Cache runs for a range of geometries, then streams `accesses` (default 2^24)
+synthetic addresses through the analyzer, reports throughput and state size, and writes
+all of that stream's curves to csv-path (default miss_curve.csv).
+*/
+
+using namespace std::chrono;
+
+// sum an 8 KiB buffer four times over: hits need 512 data lines of capacity
+static constexpr std::string_view resweep_src = R"(
+start:
+    addi x5, x0, 4        # passes
+pass:
+    addi x1, x0, 1024
+    add  x1, x1, x1
+    add  x1, x1, x1       # x1 = 0x1000
+    add  x2, x1, x1
+    add  x2, x2, x1       # x2 = 0x3000 = end
+sweep:
+    lw   x3, 0(x1)
+    add  x4, x4, x3
+    addi x1, x1, 4
+    bne  x1, x2, sweep
+    addi x5, x5, -1
+    bne  x5, x0, pass
+    jalr x0, x0, 0        # halt
+)";
+
+static std::unique_ptr<rv::MemoryBus> load(const std::vector<std::uint32_t>& words)
+{
+    auto dram = std::make_unique<rv::HashTable<std::uint32_t,std::uint32_t>>(1 << 16);
+    guest::load_program(*dram, words);
+    return dram;
+}
+
+static void run(rv::MemoryBus& bus, const std::vector<std::uint32_t>& words)
+{
+    rv::RiscV cpu{ bus };
+    guest::run_to_halt(cpu, words);
+}
+
+/* one analyzer pass vs one Cache run per geometry; returns false on any mismatch */
+static bool check(std::string_view name, std::string_view src)
+{
+    const auto words = rv::assemble(src);
+    rv::StackDistanceAnalyzer sda{ load(words), { .max_lines = 1024, .max_sets = 256, .max_ways = 16 } };
+    run(sda, words);
+
+    std::cout << std::format("\n== {}: {} accesses ==\n{:>5}", name, sda.accesses(), "sets");
+    for (std::size_t ways : { 1, 2, 4, 8, 16 }) std::cout << std::format(" {:>10}", std::format("{}-way", ways));
+    std::cout << '\n';
+
+    bool ok = true;
+    for (std::size_t sets : { 1, 4, 16, 64, 256 }) {
+        std::cout << std::format("{:>5}", sets);
+        for (std::size_t ways : { 1, 2, 4, 8, 16 }) {
+            rv::Cache cache(sets, ways, load(words));
+            run(cache, words);
+            const std::uint64_t real = cache.stats().misses(), predicted = sda.misses(sets, ways);
+            const bool same = real == predicted && (sets != 1 || sda.fa_misses(ways) == real);
+            ok &= same;
+            std::cout << std::format(" {:>9.3f}{}", static_cast<double>(predicted) * 100.0 / static_cast<double>(sda.accesses()),
+                                     same ? '%' : '!');
+        }
+        std::cout << '\n';
+    }
+    std::cout << "fully associative:";
+    for (std::size_t lines : { 64, 256, 512, 544, 1024 })
+        std::cout << std::format("  {} lines {:.2f}%", lines,
+                                 static_cast<double>(sda.fa_misses(lines)) * 100.0 / static_cast<double>(sda.accesses()));
+    std::cout << '\n';
+    return ok;
+}
+
+/* 50% a 256 KiB sequential sweep, 30% a 32 KiB hot region, 20% anywhere in 16 MiB */
+static void synthetic(rv::StackDistanceAnalyzer& sda, std::uint64_t n)
+{
+    std::uint64_t x = 0x9E3779B97F4A7C15ull;
+    std::uint32_t seq = 0;
+    for (std::uint64_t i = 0; i < n; ++i) {
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+        const auto r = static_cast<std::uint32_t>(x >> 32);
+        const std::uint32_t pick = r % 10;
+        std::uint32_t addr;
+        if (pick < 5)      { addr = 0x1000'0000u + seq; seq = (seq + 4) & 0x3'FFFF; }
+        else if (pick < 8) addr = 0x2000'0000u + ((r >> 4) & 0x7FFC);
+        else               addr = 0x3000'0000u + ((r >> 4) & 0xFF'FFFC);
+        sda.observe(addr);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const std::string path = argc > 1 ? argv[1] : "miss_curve.csv";
+    const std::uint64_t n  = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : std::uint64_t{1} << 24;
+
+    bool ok = check("resweep (4 x 8 KiB)", resweep_src);
+    for (auto const& p : guest::programs) ok &= check(p.name, p.src);
+    std::cout << (ok ? "\nanalyzer matches Cache on every geometry ('!' marks a mismatch)\n" : "\nMISMATCH\n");
+
+    rv::StackDistanceAnalyzer sda{ { .max_lines = 1 << 16, .max_sets = 1024, .max_ways = 16 } };
+    auto t0 = steady_clock::now();
+    synthetic(sda, n);
+    const double s = duration<double>(steady_clock::now() - t0).count();
+
+    std::cout << std::format("\nsynthetic: {} accesses in {:.2f} s ({:.1f} M/s), analyzer state {:.2f} MiB\n",
+                             sda.accesses(), s, static_cast<double>(sda.accesses()) / s / 1e6,
+                             static_cast<double>(sda.memory_bytes()) / (1024.0 * 1024.0));
+    for (std::size_t kib : { 4, 16, 32, 64, 128 }) {
+        const std::size_t lines = kib * 1024 / 16;
+        std::cout << std::format("  {:>5} KiB: FA {:6.2f}%  8-way {:6.2f}%\n", kib,
+                                 static_cast<double>(sda.fa_misses(lines)) * 100.0 / static_cast<double>(sda.accesses()),
+                                 static_cast<double>(sda.misses(lines / 8, 8)) * 100.0 / static_cast<double>(sda.accesses()));
+    }
+
+    std::ofstream csv{ path };
+    if (!csv) { std::cerr << std::format("cannot write '{}'\n", path); return EXIT_FAILURE; }
+    sda.write_csv(csv);
+    std::cout << std::format("curves written to {}\n", path);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
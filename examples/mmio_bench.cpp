@@ -0,0 +1,87 @@
+#include "mmio_window.hpp"
+#include "guest_programs.hpp"
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+/*
+Cost of the MMIO device map on ordinary RAM traffic.
+Loads and stores sweep a flat 1 MiB RAM through: the bare RAM bus, an MmioWindow with the
+stock devices, and an MmioWindow with 256 extra devices mapped. RAM ns/access should not
+change with the device count. Also times device accesses and prints per-device counters.
+*/
+
+using namespace std::chrono;
+
+/* scratch register device standing in for timers, UARTs, ... */
+struct ScratchDevice : rv::MmioDevice
+{
+    std::uint32_t reg = 0;
+    std::uint32_t read(std::uint32_t) override { return reg; }
+    void write(std::uint32_t, std::uint32_t v) override { reg = v; }
+};
+
+static constexpr std::uint32_t accesses = 1u << 25;
+
+template <class F>
+static double ns_per_access(F&& body)
+{
+    auto t0 = steady_clock::now();
+    body();
+    return static_cast<double>(duration_cast<nanoseconds>(steady_clock::now() - t0).count()) / accesses;
+}
+
+static double ram_sweep(rv::MemoryBus& bus)
+{
+    std::uint32_t sink = 0;
+    const double ns = ns_per_access([&] {
+        for (std::uint32_t i = 0; i < accesses; ++i) {
+            const std::uint32_t a = (i * 4) & 0xF'FFFF;
+            if (i & 1) bus.store_word(a, i);
+            else       sink += bus.load_word(a).value_or(0);
+        }
+    });
+    if (sink == 42) std::cout << ' ';
+    return ns;
+}
+
+int main()
+{
+    guest::FlatRam bare{ 1 << 18 };
+    std::cout << std::format("{:<28} {:>8.2f} ns/access\n", "RAM, no window", ram_sweep(bare));
+
+    rv::MmioWindow stock{ std::make_unique<guest::FlatRam>(1 << 18) };
+    std::cout << std::format("{:<28} {:>8.2f} ns/access\n", "RAM, stock devices", ram_sweep(stock));
+
+    std::vector<std::uint8_t> fb(128 * 128);
+    rv::MmioWindow crowded{ std::make_unique<guest::FlatRam>(1 << 18) };
+    crowded.framebuffer = fb.data();
+    for (std::uint32_t i = 0; i < 256; ++i)
+        crowded.map(std::format("scratch{}", i), 0x3000'0000 + i * 0x100, 4, std::make_unique<ScratchDevice>());
+    std::cout << std::format("{:<28} {:>8.2f} ns/access\n",
+                             std::format("RAM, {} devices", crowded.regions().size()), ram_sweep(crowded));
+
+    // device traffic: framebuffer stores, GPIO polls, scattered scratch registers
+    std::uint32_t sink = 0;
+    const double dev_ns = ns_per_access([&] {
+        for (std::uint32_t i = 0; i < accesses; ++i) {
+            switch (i & 3) {
+              case 0:  crowded.store_word(rv::MmioWindow::fb_base + ((i * 4) & (rv::MmioWindow::fb_size - 1)), i); break;
+              case 1:  sink += crowded.load_word(rv::MmioWindow::gpio_addr).value_or(0); break;
+              default: crowded.store_word(0x3000'0000 + ((i >> 2) & 0xFF) * 0x100, i); break;
+            }
+        }
+    });
+    if (sink == 42) std::cout << ' ';
+    std::cout << std::format("{:<28} {:>8.2f} ns/access\n\n", "device accesses", dev_ns);
+
+    std::cout << std::format("{:<12} {:>10} {:>10} {:>12} {:>12}\n", "device", "base", "size", "reads", "writes");
+    for (auto const& r : crowded.regions()) {
+        if (r.name.starts_with("scratch") && r.name != "scratch0") continue;
+        std::cout << std::format("{:<12} 0x{:08x} {:>10} {:>12} {:>12}\n", r.name, r.base, r.size, r.reads, r.writes);
+    }
+    return 0;
+}
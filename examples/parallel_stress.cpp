@@ -1,17 +1,43 @@
 #include "concurrent_hash_table.hpp"
+#include "node_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <format>
 #include <thread>
 #include <vector>
 #include <random>
+#include <string_view>
 #include <iostream>
 
 using Table = rv::ConcurrentHashTable<std::uint32_t,std::uint32_t>;
+using List  = rv::LockFreeList<std::uint32_t,std::uint32_t>;
+using PooledTable = rv::ConcurrentHashTable<std::uint32_t, std::uint32_t, std::hash<std::uint32_t>,
+                                            std::equal_to<std::uint32_t>, rv::PoolAllocator<std::byte>>;
+using namespace std::chrono;
 
-int main()
+/*
+1. mixed put/get smoke test (8 threads)
+2. read scaling: lock-free get() on a prefilled table, 1..N threads
+3. growth: threads insert into a tiny table that has to double many times; per-put latency
+   percentiles show that no single put pays for a whole rehash
+4. churn: put/erase/find/for_each/clear races on a LockFreeList and a growing table, checked
+   against per-thread expectations; build with -DENABLE_TSAN=ON to run it under ThreadSanitizer
+5. resize updates: updates and erases of existing keys while filler inserts keep the table
+   doubling; every update must survive its bucket's migration, and erase results and size()
+   must stay exact
+6. allocators: the same insert-heavy and put/erase-heavy loads with std::allocator and
+   with PoolAllocator nodes, plus the pool's allocation counters
+Configurable read/write mixes, key distributions and latency percentiles: see ds_bench.
+*/
+
+static void smoke()
 {
     constexpr std::size_t n_threads = 8;
     constexpr std::size_t ops_per_t = 200'000;
 
-    Table tbl(1 << 16);            // 65 536 buckets
+    Table tbl(1 << 16);            // 65 536 buckets
 
     auto worker = [&](unsigned id){
         std::mt19937 rng(id * 17u);
@@ -20,7 +46,10 @@ int main()
         for (std::size_t i = 0; i < ops_per_t; ++i) {
             auto k = dist(rng);
             tbl.put(k, k + 1);
-            (void)tbl.get(k);
+            if (auto v = tbl.get(k); !v || *v != k + 1) {
+                std::cerr << std::format("lost key {}\n", k);
+                std::exit(EXIT_FAILURE);
+            }
         }
     };
 
@@ -33,3 +62,246 @@ int main()
     std::cout << "Concurrent test finished.\n"
               << "Table size  : " << tbl.size() << '\n';
 }
+
+static void read_scaling(unsigned max_threads)
+{
+    constexpr std::uint32_t keys      = 1u << 20;
+    constexpr std::size_t   ops_per_t = 2'000'000;
+
+    Table tbl(keys * 2);
+    for (std::uint32_t k = 0; k < keys; ++k) tbl.put(k, k);
+
+    std::cout << std::format("\nRead scaling ({} keys, {} gets/thread)\n", keys, ops_per_t);
+    std::cout << std::format("{:>8} {:>12} {:>9}\n", "threads", "Mops/s", "speedup");
+
+    double base = 0;
+    for (unsigned n = 1; n <= max_threads; n *= 2) {
+        std::atomic<std::uint64_t> sink{0};
+        auto t0 = steady_clock::now();
+        std::vector<std::thread> pool;
+        for (unsigned id = 0; id < n; ++id)
+            pool.emplace_back([&, id] {
+                std::uint32_t k = id * 7919u, sum = 0;
+                for (std::size_t i = 0; i < ops_per_t; ++i) {
+                    k = k * 1664525u + 1013904223u;
+                    sum += tbl.get(k & (keys - 1)).value_or(0);
+                }
+                sink += sum;
+            });
+        for (auto& t : pool) t.join();
+        const double secs = duration<double>(steady_clock::now() - t0).count();
+        const double mops = static_cast<double>(n * ops_per_t) / secs / 1e6;
+        if (n == 1) base = mops;
+        std::cout << std::format("{:>8} {:>12.2f} {:>8.2f}x\n", n, mops, mops / base);
+    }
+}
+
+static void growth(unsigned n_threads)
+{
+    constexpr std::uint32_t per_thread = 250'000;
+
+    Table tbl(64);
+    std::vector<std::vector<std::uint32_t>> lat_ns(n_threads);
+
+    std::vector<std::thread> pool;
+    for (unsigned id = 0; id < n_threads; ++id)
+        pool.emplace_back([&, id] {
+            auto& lat = lat_ns[id];
+            lat.reserve(per_thread);
+            for (std::uint32_t i = 0; i < per_thread; ++i) {
+                const std::uint32_t k = i * n_threads + id;
+                auto t0 = steady_clock::now();
+                tbl.put(k, k);
+                lat.push_back(static_cast<std::uint32_t>(duration_cast<nanoseconds>(steady_clock::now() - t0).count()));
+            }
+        });
+    for (auto& t : pool) t.join();
+
+    std::vector<std::uint32_t> all;
+    for (auto& l : lat_ns) all.insert(all.end(), l.begin(), l.end());
+    std::ranges::sort(all);
+    auto pct = [&](double p) { return all[static_cast<std::size_t>(p * static_cast<double>(all.size() - 1))]; };
+
+    bool ok = tbl.size() == std::size_t{per_thread} * n_threads;
+    for (std::uint32_t k = 0; ok && k < per_thread * n_threads; ++k) ok = tbl.get(k) == k;
+
+    std::cout << std::format("\nGrowth: {} threads insert {} keys into a 64-bucket table (now {} buckets)\n",
+                             n_threads, all.size(), tbl.capacity());
+    std::cout << std::format("put latency ns  p50 {}  p99 {}  p99.9 {}  max {}   contents {}\n",
+                             pct(0.5), pct(0.99), pct(0.999), all.back(), ok ? "ok" : "WRONG");
+    if (!ok) std::exit(EXIT_FAILURE);
+}
+
+[[noreturn]] static void fail(std::string_view what, std::uint32_t k)
+{
+    std::cerr << std::format("churn: {} (key {})\n", what, k);
+    std::exit(EXIT_FAILURE);
+}
+
+static void churn(unsigned n_threads)
+{
+    constexpr std::uint32_t keys_per_t = 48;     // short lists: erasers, inserters and readers collide
+    constexpr std::size_t   ops_per_t  = 200'000;
+    const std::uint32_t     keys       = keys_per_t * n_threads;
+
+    List  list;
+    Table tbl(2);                              // grows several times while erases are in flight
+    std::atomic<bool> stop{false};
+
+    // thread id owns keys k with k % n_threads == id, so it knows exactly what find() must say about them;
+    // values are key << 8 | version, so any value read for any key can be sanity-checked
+    auto worker = [&](unsigned id) {
+        std::mt19937 rng(id * 31u + 7u);
+        std::vector<std::optional<std::uint32_t>> mine(keys_per_t);
+        for (std::size_t i = 0; i < ops_per_t; ++i) {
+            const std::uint32_t slot = static_cast<std::uint32_t>(rng() % keys_per_t), k = slot * n_threads + id;
+            const std::uint32_t v = k << 8 | static_cast<std::uint32_t>(i & 0xFF);
+            switch (rng() % 8) {
+              case 0: case 1: case 2:
+                list.put(k, v); tbl.put(k, v); mine[slot] = v; break;
+              case 3: case 4:
+                if (list.erase(k) != mine[slot].has_value()) fail("list erase result", k);
+                if (tbl.erase(k)  != mine[slot].has_value()) fail("table erase result", k);
+                mine[slot].reset();
+                break;
+              case 5: {
+                const auto other = static_cast<std::uint32_t>(rng() % keys);
+                if (auto x = list.find(other); x && *x >> 8 != other) fail("list foreign value", other);
+                if (auto x = tbl.get(other);   x && *x >> 8 != other) fail("table foreign value", other);
+                break;
+              }
+              case 6:
+                list.for_each([](std::uint32_t key, std::uint32_t val) {
+                    if (val >> 8 != key) fail("for_each value", key);
+                });
+                break;
+              default:
+                if (list.find(k) != mine[slot]) fail("list find", k);
+                if (tbl.get(k)   != mine[slot]) fail("table get", k);
+            }
+        }
+        for (std::uint32_t s = 0; s < keys_per_t; ++s) {
+            const std::uint32_t k = s * n_threads + id;
+            if (list.find(k) != mine[s] || tbl.get(k) != mine[s]) fail("final contents", k);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned id = 0; id < n_threads; ++id) pool.emplace_back(worker, id);
+    for (auto& t : pool) t.join();
+    const std::size_t list_size = list.size(), tbl_size = tbl.size();
+
+    // clear() while readers walk the same nodes
+    pool.clear();
+    for (unsigned id = 0; id < n_threads; ++id)
+        pool.emplace_back([&] {
+            while (!stop.load()) list.for_each([](std::uint32_t key, std::uint32_t val) {
+                if (val >> 8 != key) fail("for_each during clear", key);
+            });
+        });
+    for (std::uint32_t round = 0; round < 2'000; ++round) {
+        for (std::uint32_t k = 0; k < 64; ++k) list.put(k, k << 8);
+        list.clear();
+    }
+    stop = true;
+    for (auto& t : pool) t.join();
+
+    std::cout << std::format("\nChurn: {} threads x {} ops, list {} entries, table {} entries / {} buckets, size {}\n",
+                             n_threads, ops_per_t, list_size, tbl_size, tbl.capacity(),
+                             list.size() == 0 ? "ok" : "WRONG");
+    if (list.size() != 0) std::exit(EXIT_FAILURE);
+}
+
+static void resize_updates(unsigned n_threads)
+{
+    constexpr std::uint32_t keys_per_t  = 64;
+    constexpr std::uint32_t fill_per_t  = 100'000;   // one filler insert per op: 64 -> 256K+ buckets
+    constexpr std::uint32_t filler_base = 0x8000'0000;
+
+    Table tbl(64);
+    std::vector<std::size_t> live(n_threads);
+
+    // thread id owns keys slot * n_threads + id and is the only writer of them
+    auto worker = [&](unsigned id) {
+        std::mt19937 rng(id * 13u + 5u);
+        std::vector<std::optional<std::uint32_t>> mine(keys_per_t);
+        for (std::uint32_t i = 0; i < fill_per_t; ++i) {
+            tbl.put(filler_base + i * n_threads + id, i);
+            const std::uint32_t slot = static_cast<std::uint32_t>(rng() % keys_per_t), k = slot * n_threads + id;
+            if (rng() % 4 == 0) {
+                if (tbl.erase(k) != mine[slot].has_value()) fail("resize erase result", k);
+                mine[slot].reset();
+            } else {
+                tbl.put(k, i);
+                mine[slot] = i;
+            }
+            if (tbl.get(k) != mine[slot]) fail("resize lost update", k);
+        }
+        for (std::uint32_t s = 0; s < keys_per_t; ++s)
+            if (tbl.get(s * n_threads + id) != mine[s]) fail("resize final contents", s * n_threads + id);
+        live[id] = static_cast<std::size_t>(std::ranges::count_if(mine, [](const auto& v) { return v.has_value(); }));
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned id = 0; id < n_threads; ++id) pool.emplace_back(worker, id);
+    for (auto& t : pool) t.join();
+
+    std::size_t expect = std::size_t{fill_per_t} * n_threads;
+    for (std::size_t n : live) expect += n;
+    const bool ok = tbl.size() == expect;
+    std::cout << std::format("\nResize updates: {} threads, table now {} buckets, size {} (expected {}) {}\n",
+                             n_threads, tbl.capacity(), tbl.size(), expect, ok ? "ok" : "WRONG");
+    if (!ok) std::exit(EXIT_FAILURE);
+}
+
+/* Mops/s of `n_threads` threads each running `ops_per_t` iterations of body(table, thread, i) */
+template <class Tbl, class Body>
+static double throughput(unsigned n_threads, std::size_t ops_per_t, std::size_t cap, Body body)
+{
+    Tbl tbl(cap);
+    auto t0 = steady_clock::now();
+    std::vector<std::thread> pool;
+    for (unsigned id = 0; id < n_threads; ++id)
+        pool.emplace_back([&, id] { for (std::size_t i = 0; i < ops_per_t; ++i) body(tbl, id, i); });
+    for (auto& t : pool) t.join();
+    return static_cast<double>(n_threads * ops_per_t) / duration<double>(steady_clock::now() - t0).count() / 1e6;
+}
+
+static void allocators(unsigned n_threads)
+{
+    constexpr std::size_t inserts = 500'000, churn_ops = 1'000'000;
+
+    // every put is a new key: one node per op, plus the copies each resize makes
+    auto insert = [n_threads](auto& tbl, unsigned id, std::size_t i) {
+        const auto k = static_cast<std::uint32_t>(i * n_threads + id);
+        tbl.put(k, k);
+    };
+    // a small hot key set: nodes are freed by erase and immediately wanted again
+    auto churn = [](auto& tbl, unsigned id, std::size_t i) {
+        const auto k = static_cast<std::uint32_t>((i * 2654435761u + id) & 4095);
+        if (i & 1) tbl.erase(k);
+        else       tbl.put(k, k);
+    };
+
+    std::cout << std::format("\nAllocators ({} threads, Mops/s)\n", n_threads);
+    std::cout << std::format("{:<14} {:>14} {:>14}\n", "", "insert+grow", "put/erase");
+    std::cout << std::format("{:<14} {:>14.2f} {:>14.2f}\n", "std::allocator",
+                             throughput<Table>(n_threads, inserts, 64, insert),
+                             throughput<Table>(n_threads, churn_ops, 8192, churn));
+    std::cout << std::format("{:<14} {:>14.2f} {:>14.2f}\n", "PoolAllocator",
+                             throughput<PooledTable>(n_threads, inserts, 64, insert),
+                             throughput<PooledTable>(n_threads, churn_ops, 8192, churn));
+    std::cout << "node pool: " << rv::node_pool_stats().pretty() << '\n';
+}
+
+int main(int argc, char** argv)
+{
+    const unsigned hw = argc > 1 ? static_cast<unsigned>(std::atoi(argv[1]))
+                                 : std::max(1u, std::thread::hardware_concurrency());
+    smoke();
+    read_scaling(hw);
+    growth(hw);
+    churn(std::max(hw, 2u));
+    resize_updates(std::max(hw, 2u));
+    allocators(hw);
+}
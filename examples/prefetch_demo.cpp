@@ -0,0 +1,65 @@
+#include "cache.hpp"
+#include "hash_table.hpp"
+#include "prefetcher.hpp"
+#include "riscv.hpp"
+#include "rv_assembler.hpp"
+#include "cache_stats_formatter.hpp"
+#include "guest_programs.hpp"
+#include <format>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+/*
+Runs guest workloads through a 64-set, 2-way L1 with each prefetcher model attached
+and prints miss counts plus prefetch accuracy / coverage / timeliness.
+*/
+
+struct Config
+{
+    std::string_view                               name;
+    std::function<std::unique_ptr<rv::Prefetcher>()> make;
+};
+
+static void run(std::string_view title, std::string_view src, const std::vector<Config>& configs)
+{
+    auto words = rv::assemble(src);
+
+    std::cout << std::format("\n== {} ({} instructions) ==\n", title, words.size());
+    std::cout << std::format("{:<14} {:>9} {:>9} {:>8} {:>9} {:>9} {:>9}\n",
+                             "prefetcher", "accesses", "misses", "HR %", "acc %", "cov %", "timely %");
+
+    for (auto const& cfg : configs) {
+        auto dram = std::make_unique<rv::HashTable<std::uint32_t,std::uint32_t>>(1 << 16);
+        guest::load_program(*dram, words);
+
+        rv::Cache l1(64, 2, std::move(dram));
+        if (cfg.make) l1.attach_prefetcher(cfg.make());
+
+        rv::RiscV cpu{ l1 };
+        guest::run_to_halt(cpu, words);
+
+        auto const& st = l1.stats();
+        std::cout << std::format("{:<14} {:>9} {:>9} {:>8.2f} {:>9.2f} {:>9.2f} {:>9.2f}\n",
+                                 cfg.name, st.cpu_accesses(), st.misses(), st.hit_rate()*100.0,
+                                 st.pf_accuracy()*100.0, st.pf_coverage()*100.0, st.pf_timeliness()*100.0);
+    }
+}
+
+int main()
+{
+    const std::vector<Config> configs{
+        { "none",        nullptr },
+        { "next-line x1", []{ return std::make_unique<rv::NextLinePrefetcher>(1); } },
+        { "next-line x4", []{ return std::make_unique<rv::NextLinePrefetcher>(4); } },
+        { "stride",       []{ return std::make_unique<rv::StridePrefetcher>(2); } },
+        { "stream",       []{ return std::make_unique<rv::StreamPrefetcher>(4, 4); } },
+    };
+
+    run("sum 1..10",         guest::sum_src,     configs);
+    run("framebuffer fill",  guest::fb_fill_src, configs);
+    run("framebuffer sum",   guest::fb_sum_src,  configs);
+    return 0;
+}
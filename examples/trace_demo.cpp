@@ -0,0 +1,173 @@
+#include "exec_trace.hpp"
+#include "hash_table.hpp"
+#include "mapped_file.hpp"
+#include "riscv.hpp"
+#include "rv_assembler.hpp"
+#include "rv_disassembler.hpp"
+#include "guest_kernels.hpp"
+#include "guest_programs.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/*
+Execution tracing: cost, a post-mortem, and the disassembler.
+
+    trace_demo [reps divisor, default 8]
+
+1. Runs the cpu_bench kernels on a flat RAM with tracing off, with a 4096-entry
+   FlightRecorder, and with the recorder plus an ExecTraceWriter streaming to a temp file.
+   Prints ns per instruction, the added ns, and trace bytes per instruction, then reads
+   each stream back and checks it against instret and the recorder's history.
+2. Runs a guest that calls a routine that was never loaded, catches the fetch fault and
+   dumps the last instructions from the recorder.
+3. Disassembles every kernel and reassembles each line without a label operand; the
+   words must round-trip.
+Exits nonzero if a check fails.
+*/
+
+using namespace std::chrono;
+
+enum class Mode { off, flight, flight_stream };
+
+struct Timing
+{
+    double        ns_per_instr = 0;
+    std::uint64_t instret = 0, trace_bytes = 0;
+    bool          ok = true;
+};
+
+static Timing run_kernel(const guest::Kernel& k, const std::vector<std::uint32_t>& words, std::uint32_t reps,
+                         Mode mode, const std::filesystem::path& trace_path)
+{
+    guest::FlatRam ram;
+    guest::load_program(ram, words);
+    k.setup(ram, reps);
+
+    rv::RiscV cpu{ ram };
+    rv::FlightRecorder fr{ 4096 };
+    std::optional<rv::ExecTraceWriter> tw;
+    if (mode != Mode::off) cpu.attach_flight_recorder(&fr);
+    if (mode == Mode::flight_stream) cpu.attach_trace_writer(&tw.emplace(trace_path.string()));
+
+    const auto t0 = steady_clock::now();
+    guest::run_to_halt(cpu, words);
+    const double s = duration<double>(steady_clock::now() - t0).count();
+
+    Timing t{ s * 1e9 / static_cast<double>(cpu.instret()), cpu.instret() };
+    t.ok = ram.load_word(guest::result_addr) == k.expect(reps);
+    if (mode != Mode::off) t.ok &= fr.total() == cpu.instret();
+    if (!tw) return t;
+
+    /* the stream holds every instruction; its tail is the recorder's history */
+    tw->close();
+    t.trace_bytes = tw->bytes();
+    const rv::MappedFile file{ trace_path.string() };
+    rv::ExecTraceReader rd{ file.bytes() };
+    const auto hist = fr.snapshot();
+    std::uint64_t n = 0;
+    const std::uint64_t tail = rd.count() - hist.size();
+    while (auto r = rd.next()) {
+        if (n >= tail) t.ok &= *r == hist[n - tail];
+        ++n;
+    }
+    t.ok &= n == cpu.instret() && rd.count() == n;
+    return t;
+}
+
+/* calls a routine at 0x10000 that was never loaded */
+static constexpr std::string_view crash_src = R"(
+start:
+    addi x1, x0, 5        # countdown
+    addi x2, x0, 0        # running sum
+loop:
+    add  x2, x2, x1
+    sw   x2, 256(x0)
+    addi x1, x1, -1
+    bne  x1, x0, loop
+    lw   x4, 256(x0)
+    lui  x3, 16           # x3 = 0x10000: nothing there
+    jalr x1, x3, 0
+    jalr x0, x0, 0        # never reached
+)";
+
+static bool crash_demo()
+{
+    const auto words = rv::assemble(crash_src);
+    rv::HashTable<std::uint32_t, std::uint32_t> dram{ 1 << 10 };
+    guest::load_program(dram, words);
+
+    rv::RiscV cpu{ dram };
+    rv::FlightRecorder fr{ 16 };
+    cpu.attach_flight_recorder(&fr);
+    try {
+        for (int i = 0; i < 1000; ++i) cpu.step();
+    } catch (const std::exception& e) {
+        std::cout << std::format("trap at pc 0x{:08x} after {} instructions: {}\n", cpu.pc(), cpu.instret(), e.what());
+        fr.dump(std::cout, 10);
+        return fr.last(1).front().raw == words[words.size() - 2];
+    }
+    std::cout << "expected a fetch fault\n";
+    return false;
+}
+
+/* every line whose operands aren't labels must reassemble to the same word */
+static bool round_trip()
+{
+    std::size_t checked = 0, skipped = 0, bad = 0;
+    for (const auto& k : guest::bench_kernels) {
+        for (const std::uint32_t w : rv::assemble(k.src)) {
+            const auto text = rv::disassemble(w);
+            const auto opc  = static_cast<rv::Opcode>(w & 0x7F);
+            if (opc == rv::Opcode::BRANCH || opc == rv::Opcode::JAL) { ++skipped; continue; }
+            ++checked;
+            const auto again = rv::assemble(text);
+            if (again.size() != 1 || again[0] != w) {
+                ++bad;
+                std::cout << std::format("  {:08x} -> '{}' -> {:08x}\n", w, text, again.empty() ? 0u : again[0]);
+            }
+        }
+    }
+    std::cout << std::format("round trip: {} words reassembled, {} branches/jumps skipped, {} mismatches\n",
+                             checked, skipped, bad);
+    return bad == 0;
+}
+
+int main(int argc, char** argv)
+{
+    const std::uint32_t div  = argc > 1 ? static_cast<std::uint32_t>(std::stoul(argv[1])) : 8;
+    const auto          path = std::filesystem::temp_directory_path() / "trace_demo.rvxt";
+    bool ok = true;
+
+    std::cout << std::format("{:<14}{:>12}{:>11}{:>13}{:>9}{:>15}{:>10}\n",
+                             "kernel", "instret", "off ns/i", "flight ns/i", "+ns", "stream ns/i", "B/instr");
+    for (const auto& k : guest::bench_kernels) {
+        const auto words = rv::assemble(k.src);
+        const auto reps  = std::max<std::uint32_t>(1, k.reps / div);
+        const Timing off    = run_kernel(k, words, reps, Mode::off, path);
+        const Timing flight = run_kernel(k, words, reps, Mode::flight, path);
+        const Timing stream = run_kernel(k, words, reps, Mode::flight_stream, path);
+        ok &= off.ok && flight.ok && stream.ok;
+        std::cout << std::format("{:<14}{:>12}{:>11.2f}{:>13.2f}{:>+9.2f}{:>15.2f}{:>10.2f}{}\n",
+                                 k.name, off.instret, off.ns_per_instr, flight.ns_per_instr,
+                                 flight.ns_per_instr - off.ns_per_instr, stream.ns_per_instr,
+                                 static_cast<double>(stream.trace_bytes) / static_cast<double>(stream.instret),
+                                 off.ok && flight.ok && stream.ok ? "" : "  FAILED");
+    }
+    std::filesystem::remove(path);
+
+    std::cout << '\n';
+    ok &= crash_demo();
+    std::cout << '\n';
+    ok &= round_trip();
+
+    std::cout << (ok ? "all checks passed\n" : "CHECK FAILED\n");
+    return ok ? 0 : 1;
+}
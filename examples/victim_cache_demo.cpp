@@ -0,0 +1,99 @@
+#include "cache.hpp"
+#include "hash_table.hpp"
+#include "riscv.hpp"
+#include "rv_assembler.hpp"
+#include "cache_stats_formatter.hpp"
+#include "guest_programs.hpp"
+#include <format>
+#include <iostream>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+/*
+Is a small victim cache worth more than doubling associativity?
+Runs guest workloads through 64-set L1s: 2-way, 2-way + victim cache of 4/8/16 lines, 4-way,
+and prints how many misses still reach DRAM.
+*/
+
+// a[i] += b[i] + c[i] with a, b, c exactly 1 KiB x 4 apart: all three map to the same set
+// of a 64-set cache, so a 2-way L1 thrashes on every iteration
+static constexpr std::string_view conflict_src = R"(
+start:
+    addi x1, x0, 1024
+    add  x1, x1, x1
+    add  x1, x1, x1       # x1 = a = 0x1000
+    add  x2, x1, x1       # x2 = b = 0x2000
+    add  x3, x2, x1       # x3 = c = 0x3000
+    addi x6, x1, 1024     # end of a (256 words)
+loop:
+    lw   x4, 0(x2)
+    lw   x5, 0(x3)
+    add  x4, x4, x5
+    lw   x5, 0(x1)
+    add  x4, x4, x5
+    sw   x4, 0(x1)
+    addi x1, x1, 4
+    addi x2, x2, 4
+    addi x3, x3, 4
+    bne  x1, x6, loop
+    jalr x0, x0, 0        # halt
+)";
+
+struct Config
+{
+    std::string_view name;
+    std::size_t      ways;
+    std::size_t      victim_lines;
+};
+
+static void run(std::string_view title, std::string_view src, const std::vector<Config>& configs)
+{
+    auto words = rv::assemble(src);
+
+    std::cout << std::format("\n== {} ==\n", title);
+    std::cout << std::format("{:<12} {:>9} {:>9} {:>9} {:>9} {:>11}\n",
+                             "L1", "accesses", "misses", "VC hits", "VC HR %", "DRAM fills");
+
+    for (auto const& cfg : configs) {
+        auto dram = std::make_unique<rv::HashTable<std::uint32_t,std::uint32_t>>(1 << 16);
+        guest::load_program(*dram, words);
+
+        rv::Cache l1(64, cfg.ways, std::move(dram));
+        if (cfg.victim_lines) l1.attach_victim_cache(cfg.victim_lines);
+
+        rv::RiscV cpu{ l1 };
+        guest::run_to_halt(cpu, words);
+
+        auto const& st = l1.stats();
+        const auto vc_hits = st.count(rv::CacheStats::Event::vc_hit);
+        std::cout << std::format("{:<12} {:>9} {:>9} {:>9} {:>9.2f} {:>11}\n",
+                                 cfg.name, st.cpu_accesses(), st.misses(), vc_hits,
+                                 st.vc_hit_rate()*100.0, st.misses() - vc_hits);
+    }
+}
+
+int main()
+{
+    const std::vector<Config> configs{
+        { "2-way",        2,  0 },
+        { "2-way + VC4",  2,  4 },
+        { "2-way + VC8",  2,  8 },
+        { "2-way + VC16", 2, 16 },
+        { "4-way",        4,  0 },
+    };
+
+    run("3-way set conflict", conflict_src,      configs);
+    run("framebuffer sum",    guest::fb_sum_src, configs);
+
+    // full breakdown for one configuration
+    auto words = rv::assemble(conflict_src);
+    auto dram  = std::make_unique<rv::HashTable<std::uint32_t,std::uint32_t>>(1 << 16);
+    guest::load_program(*dram, words);
+    rv::Cache l1(64, 2, std::move(dram));
+    l1.attach_victim_cache(8);
+    rv::RiscV cpu{ l1 };
+    guest::run_to_halt(cpu, words);
+    std::cout << std::format("\n{:victim}", l1.stats());
+    return 0;
+}
@@ -0,0 +1,138 @@
+#include "cache.hpp"
+#include "hash_table.hpp"
+#include "riscv.hpp"
+#include "rv_assembler.hpp"
+#include "write_buffer.hpp"
+#include "guest_programs.hpp"
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <string_view>
+
+/*
+Write-through L1 with and without a coalescing write buffer in front of DRAM.
+Counts the transactions DRAM actually sees and checks that the final memory
+image is the same either way (exit status nonzero if not).
+*/
+
+// fill 256 words, FENCE, then read them back
+static constexpr std::string_view fill_fence_sum_src = R"(
+start:
+    addi x1, x0, 1024
+    add  x1, x1, x1
+    add  x1, x1, x1       # x1 = 0x1000
+    addi x2, x1, 1024     # x2 = end (256 words)
+    addi x3, x0, 7
+fill:
+    sw   x3, 0(x1)
+    addi x1, x1, 4
+    bne  x1, x2, fill
+    fence
+    addi x1, x2, -1024
+    addi x4, x0, 0
+sum:
+    lw   x5, 0(x1)
+    add  x4, x4, x5
+    addi x1, x1, 4
+    bne  x1, x2, sum
+    sw   x4, 32(x0)
+    jalr x0, x0, 0        # halt
+)";
+
+// byte stores between word stores to the same lines; sub-word stores must keep their byte address
+static constexpr std::string_view byte_store_src = R"(
+start:
+    addi x1, x0, 1024
+    add  x1, x1, x1
+    add  x1, x1, x1       # x1 = 0x1000
+    addi x2, x0, 64       # iterations
+    addi x3, x0, 7
+    addi x6, x0, 9
+loop:
+    sw   x3, 0(x1)
+    sb   x6, 1(x1)        # same line as the word store around it
+    sw   x3, 4(x1)
+    sb   x6, 10(x1)
+    lw   x5, 1(x1)        # reads the byte store back at its own address
+    add  x4, x4, x5
+    addi x1, x1, 16
+    addi x2, x2, -1
+    bne  x2, x0, loop
+    sw   x4, 32(x0)
+    jalr x0, x0, 0        # halt
+)";
+
+/* counts bus transactions on their way into DRAM; a store_block is one transaction */
+class CountingBus : public rv::MemoryBus
+{
+  public:
+    explicit CountingBus(std::unique_ptr<rv::MemoryBus> next) : next_{std::move(next)} {}
+
+    std::optional<std::uint32_t> load_word(std::uint32_t addr) override { ++reads; return next_->load_word(addr); }
+    bool store_word(std::uint32_t addr, std::uint32_t v) override { ++writes; return next_->store_word(addr, v); }
+    bool store_block(std::uint32_t addr, std::span<const std::uint32_t> words, std::uint32_t mask) override
+    {
+        ++writes;
+        return next_->store_block(addr, words, mask);
+    }
+
+    std::uint64_t reads  = 0;
+    std::uint64_t writes = 0;
+
+  private:
+    std::unique_ptr<rv::MemoryBus> next_;
+};
+
+static bool run(std::string_view title, std::string_view src)
+{
+    bool ok = true;
+    auto words = rv::assemble(src);
+
+    std::cout << std::format("\n== {} ==\n", title);
+    std::uint64_t reference = 0;
+
+    for (std::size_t entries : { 0, 2, 8, 32 }) {
+        auto dram = std::make_unique<rv::HashTable<std::uint32_t,std::uint32_t>>(1 << 16);
+        auto* image = dram.get();
+        guest::load_program(*dram, words);
+
+        auto counter = std::make_unique<CountingBus>(std::move(dram));
+        auto* cnt = counter.get();
+
+        rv::WriteBuffer* wb = nullptr;
+        std::unique_ptr<rv::MemoryBus> below = std::move(counter);
+        if (entries) {
+            auto buf = std::make_unique<rv::WriteBuffer>(std::move(below), entries);
+            wb = buf.get();
+            below = std::move(buf);
+        }
+
+        rv::Cache l1(64, 2, std::move(below), rv::Cache::WritePolicy::write_through);
+        rv::RiscV cpu{ l1 };
+        guest::run_to_halt(cpu, words);
+        l1.fence(); // drain whatever is still buffered before looking at DRAM
+
+        // checksum of the data region (every byte address: sub-word stores live at their own) so every
+        // configuration can be compared
+        std::uint64_t sum = 0;
+        for (std::uint32_t a = 0; a < 0x11000; ++a)
+            sum = sum * 31 + image->load_word(a).value_or(0);
+        if (entries == 0) reference = sum;
+        ok &= sum == reference;
+
+        std::cout << std::format("{:<10} DRAM writes {:8}  reads {:6}  image {}\n",
+                                 entries ? std::format("WB x{}", entries) : std::string{"no buffer"},
+                                 cnt->writes, cnt->reads, sum == reference ? "ok" : "MISMATCH");
+        if (wb) std::cout << std::format("           {}\n", wb->stats().pretty());
+    }
+    return ok;
+}
+
+int main()
+{
+    bool ok = run("framebuffer fill", guest::fb_fill_src);
+    ok &= run("fill, fence, sum", fill_fence_sum_src);
+    ok &= run("byte stores", byte_store_src);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
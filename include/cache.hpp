@@ -2,16 +2,24 @@
 #include "memory_bus.hpp"
 #include "cache_line.hpp"
 #include "cache_stats.hpp"
+#include "miss_classifier.hpp"
+#include "prefetcher.hpp"
+#include "victim_cache.hpp"
+#include "mem_attributes.hpp"
+#include <array>
 #include <vector>
+#include <mutex>
 #include <atomic>
 #include <ranges>
 #include <optional>
+#include <bit>
 #include <cassert>
 
 namespace rv {
 
 /*
-Simple N-way set-associative cache.
+Simple N-way set-associative cache with LRU replacement.
+`sets` must be a power of two.
 */
 class Cache : public MemoryBus
 {
@@ -26,12 +34,16 @@ class Cache : public MemoryBus
       WritePolicy wp = WritePolicy::write_back)
     : sets_{sets},
       ways_{ways},
+      set_bits_{static_cast<unsigned>(std::countr_zero(sets))},
       policy_{wp},
       data_(sets * ways),
-      lru_way_(sets, 0),
+      lru_stamp_(sets * ways, 0),
+      lru_clock_(sets, 0),
       lru_lock_{ std::make_unique<std::atomic_flag[]>(sets) },
-      next_{std::move(next)}
+      next_{std::move(next)},
+      stats_{sets}
 {
+    assert(std::has_single_bit(sets) && ways > 0);
     for (std::size_t i = 0; i < sets_; ++i) {
         lru_lock_[i].clear();
     }
@@ -42,30 +54,92 @@ class Cache : public MemoryBus
     */
     std::optional<std::uint32_t> load_word(Address addr) override;
     bool store_word(Address addr, std::uint32_t v) override;
+    void set_pc(std::uint32_t pc) noexcept override { pc_ = pc; }
+    void fence() override { flush_wc(); next_->fence(); }
 
     [[nodiscard]] CacheStats const& stats() const noexcept { return stats_; }
 
+    /*
+    Give [base, base+size) a memory attribute (everything defaults to cacheable).
+    Uncached and write-combining ranges never allocate lines, so device registers
+    behind the cache are never stale. Throws std::invalid_argument on overlap.
+    */
+    void set_attribute(Address base, std::uint32_t size, MemAttr attr) { attrs_.set(base, size, attr); }
+
+    /*
+    Opt-in detailed profiling: 3C miss classification and reuse-distance histogram.
+    Keeps a fully-associative shadow directory, so it costs a map lookup per access.
+    */
+    void enable_profiling(bool on = true);
+
+    /*
+    Attach a prefetcher (nullptr detaches; none by default).
+    A prefetched line first used within `late_window` demand accesses of its fill
+    counts as late: a real prefetch would still have been in flight.
+    */
+    void attach_prefetcher(std::unique_ptr<Prefetcher> pf, std::uint32_t late_window = 8)
+    {
+        prefetcher_  = std::move(pf);
+        late_window_ = late_window;
+    }
+
+    /*
+    Attach a fully-associative victim cache of `entries` lines (0 detaches it and
+    writes its dirty lines back). Evicted lines go there instead of being dropped;
+    a miss probes it before the next level and swaps the line back in on a hit.
+    */
+    void attach_victim_cache(std::size_t entries);
+
   private:
     const std::size_t sets_;
     const std::size_t ways_;
+    const unsigned    set_bits_;
     const WritePolicy policy_;
 
     std::vector<CacheLine> data_; // flat [set*ways + way]
-    std::vector<std::size_t> lru_way_; // per-set MRU tracker
+    std::vector<std::uint64_t> lru_stamp_; // flat [set*ways + way], last-use time
+    std::vector<std::uint64_t> lru_clock_; // per-set use counter
     std::unique_ptr<std::atomic_flag[]> lru_lock_;
 
     std::unique_ptr<MemoryBus> next_;
     CacheStats stats_;
 
+    std::unique_ptr<MissClassifier> profiler_; // null unless enable_profiling()
+    std::mutex                      profiler_mtx_;
+    std::atomic<bool>               profiling_{false};
+
+    std::unique_ptr<Prefetcher>     prefetcher_; // null unless attach_prefetcher()
+    std::vector<std::uint32_t>      pf_queue_;
+    std::uint32_t                   pf_clock_{0};
+    std::uint32_t                   late_window_{8};
+    std::uint32_t                   pc_{no_pc};
+
+    std::unique_ptr<VictimCache>    victim_; // null unless attach_victim_cache()
+
+    MemoryAttributes                attrs_;
+
+    // single write-combining buffer: one line of pending stores, mask == 0 when empty
+    struct WcBuffer
+    {
+        Address                      base = 0;
+        std::array<std::uint32_t, 4> words{};
+        std::uint32_t                mask = 0;
+    } wc_;
+
     /*
     helpers
     */
     static constexpr std::size_t line_words = 4;
     static constexpr std::size_t line_shift = 4; // 16-byte line
 
-    [[nodiscard]] static std::uint32_t tag(Address a) noexcept
+    [[nodiscard]] std::uint32_t tag(Address a) const noexcept
     {
-        return a >> (line_shift+6);
+        return a >> (line_shift + set_bits_);
+    }
+
+    [[nodiscard]] Address line_base(std::uint32_t tg, std::size_t set) const noexcept
+    {
+        return static_cast<Address>(((static_cast<std::size_t>(tg) << set_bits_) | set) << line_shift);
     }
 
     [[nodiscard]] std::size_t index(Address a) const noexcept
@@ -80,7 +154,13 @@ class Cache : public MemoryBus
 
     void touch_lru(std::size_t set, std::size_t way) noexcept;
     std::size_t select_victim(std::size_t set) noexcept;
-    void fill_line(std::size_t set, std::size_t way, Address addr);
+    void fill_line(std::size_t set, std::size_t way, Address addr, bool promote = true);
+    void record_access(std::size_t set, Address addr, bool hit);
+    std::size_t demand(std::size_t set, Address addr, Prefetcher::Outcome& outcome);
+    void prefetch(Address addr, Prefetcher::Outcome outcome);
+    std::optional<std::uint32_t> device_load(Address addr);
+    bool device_store(Address addr, std::uint32_t v, MemAttr attr);
+    void flush_wc();
 };
 
 /*
@@ -89,90 +169,227 @@ Implementation
 inline void Cache::touch_lru(std::size_t set, std::size_t way) noexcept
 {
     while (lru_lock_[set].test_and_set(std::memory_order_acquire)) ; // spin
-    lru_way_[set] = way;
+    lru_stamp_[slot(set,way)] = ++lru_clock_[set];
     lru_lock_[set].clear(std::memory_order_release);
 }
 
 inline std::size_t Cache::select_victim(std::size_t set) noexcept
 {
-    // ranges pipeline: 0..ways-1 | filter(!mru) | take(1)
+    // an invalid way if there is one, otherwise the least recently used
     auto ways = std::views::iota(std::size_t{0}, ways_);
-    auto cand = ways | std::views::filter([&](std::size_t w){return w!=lru_way_[set];});
-    return cand.empty() ? 0 : *cand.begin();
+    if (auto free = std::ranges::find_if(ways, [&](std::size_t w){ return !data_[slot(set,w)].valid; });
+        free != ways.end())
+        return *free;
+    return *std::ranges::min_element(ways, {}, [&](std::size_t w){ return lru_stamp_[slot(set,w)]; });
 }
 
-inline std::optional<std::uint32_t> Cache::load_word(Address addr)
+inline void Cache::enable_profiling(bool on)
 {
-    ++stats_.n_cpu_accesses;
-    std::size_t set = index(addr);
-    std::uint32_t tg = tag(addr);
+    std::scoped_lock lk(profiler_mtx_);
+    profiler_ = on ? std::make_unique<MissClassifier>(sets_ * ways_) : nullptr;
+    profiling_.store(on, std::memory_order_relaxed);
+}
+
+inline void Cache::record_access(std::size_t set, Address addr, bool hit)
+{
+    stats_.record_access(set, hit);
+
+    if (!profiling_.load(std::memory_order_relaxed)) return;
+    std::scoped_lock lk(profiler_mtx_);
+    if (!profiler_) return;
+
+    auto obs = profiler_->observe(addr >> line_shift);
+    if (!obs.first_touch) stats_.record_reuse(obs.reuse);
+    if (hit) return;
+    switch (MissClassifier::classify(obs)) {
+      case MissClassifier::Kind::compulsory: stats_.record(CacheStats::Event::compulsory); break;
+      case MissClassifier::Kind::capacity:   stats_.record(CacheStats::Event::capacity);   break;
+      case MissClassifier::Kind::conflict:   stats_.record(CacheStats::Event::conflict);   break;
+    }
+}
 
+/*
+Demand lookup shared by load_word/store_word: hit or allocate, returns the way holding `addr`.
+*/
+inline std::size_t Cache::demand(std::size_t set, Address addr, Prefetcher::Outcome& outcome)
+{
+    std::uint32_t tg = tag(addr);
     auto ways = std::views::iota(std::size_t{0}, ways_);
-    if (auto hit = std::ranges::find_if(ways, [&](std::size_t w){
+
+    auto hit = std::ranges::find_if(ways, [&](std::size_t w){
             const CacheLine& cl = data_[slot(set,w)];
             return cl.valid && cl.tag == tg; });
-        hit != ways.end())
-    {
-        ++stats_.n_hits;
-        touch_lru(set, *hit);
-        const auto& line = data_[slot(set,*hit)];
-        return line.words[(addr >> 2) & (line_words-1)];
+    record_access(set, addr, hit != ways.end());
+
+    if (hit == ways.end()) {
+        outcome = Prefetcher::Outcome::miss;
+        std::size_t victim = select_victim(set);
+        fill_line(set, victim, addr);
+        return victim;
+    }
+
+    touch_lru(set, *hit);
+    CacheLine& cl = data_[slot(set,*hit)];
+    outcome = Prefetcher::Outcome::hit;
+    if (cl.prefetched) {
+        outcome = Prefetcher::Outcome::prefetch_hit;
+        cl.prefetched = false;
+        stats_.record(CacheStats::Event::pf_useful);
+        if (pf_clock_ - cl.fill_stamp < late_window_) stats_.record(CacheStats::Event::pf_late);
     }
+    return *hit;
+}
+
+/*
+Ask the prefetcher what to bring in after a demand access and fill those lines.
+Prefetched lines are inserted at LRU position, so they cannot push out the demand line.
+*/
+inline void Cache::prefetch(Address addr, Prefetcher::Outcome outcome)
+{
+    ++pf_clock_;
+    pf_queue_.clear();
+    prefetcher_->on_access({ addr, pc_, 1u << line_shift, outcome }, pf_queue_);
+    pc_ = no_pc;
 
-    // miss
-    ++stats_.n_misses;
-    std::size_t victim = select_victim(set);
-    fill_line(set, victim, addr);
-    const auto& line = data_[slot(set,victim)];
-    return line.words[(addr >> 2) & (line_words-1)];
+    for (Address pa : pf_queue_) {
+        if ((pa >> line_shift) == (addr >> line_shift)) continue;
+        if (!attrs_.empty() && attrs_(pa) != MemAttr::cacheable) continue; // never speculate into devices
+
+        std::size_t set = index(pa);
+        std::uint32_t tg = tag(pa);
+        auto ways = std::views::iota(std::size_t{0}, ways_);
+        if (std::ranges::any_of(ways, [&](std::size_t w){
+                const CacheLine& cl = data_[slot(set,w)];
+                return cl.valid && cl.tag == tg; })) {
+            stats_.record(CacheStats::Event::pf_redundant);
+            continue;
+        }
+
+        std::size_t victim = select_victim(set);
+        fill_line(set, victim, pa, /*promote=*/false);
+        CacheLine& cl = data_[slot(set,victim)];
+        cl.prefetched = true;
+        cl.fill_stamp = pf_clock_;
+        stats_.record(CacheStats::Event::pf_issued);
+    }
+}
+
+inline void Cache::flush_wc()
+{
+    if (!wc_.mask) return;
+    next_->store_block(wc_.base, wc_.words, wc_.mask);
+    stats_.record(CacheStats::Event::wc_flush);
+    wc_.mask = 0;
+}
+
+/* non-cacheable load: pending combined stores go first so the device sees program order */
+inline std::optional<std::uint32_t> Cache::device_load(Address addr)
+{
+    stats_.record(CacheStats::Event::uncached);
+    pc_ = no_pc;
+    flush_wc();
+    return next_->load_word(addr);
+}
+
+inline bool Cache::device_store(Address addr, std::uint32_t v, MemAttr attr)
+{
+    stats_.record(CacheStats::Event::uncached);
+    pc_ = no_pc;
+    const Address base = addr & ~((Address{1} << line_shift) - 1);
+    // sub-word (byte-addressed) stores can't be combined into word slots: pass them through in order
+    const bool pass = attr == MemAttr::uncached || (addr & 3);
+    if (pass || (wc_.mask && wc_.base != base)) flush_wc();
+    if (pass) return next_->store_word(addr, v);
+
+    wc_.base = base;
+    wc_.words[(addr >> 2) & (line_words-1)] = v;
+    wc_.mask |= 1u << ((addr >> 2) & (line_words-1));
+    if (wc_.mask == (1u << line_words) - 1) flush_wc(); // full line: nothing left to combine
+    return true;
+}
+
+inline std::optional<std::uint32_t> Cache::load_word(Address addr)
+{
+    if (!attrs_.empty()) [[unlikely]]
+        if (attrs_(addr) != MemAttr::cacheable) return device_load(addr);
+
+    std::size_t set = index(addr);
+    Prefetcher::Outcome outcome;
+    std::size_t way = demand(set, addr, outcome);
+    const std::uint32_t v = data_[slot(set,way)].words[(addr >> 2) & (line_words-1)];
+
+    if (prefetcher_) prefetch(addr, outcome);
+    return v;
 }
 
 inline bool Cache::store_word(Address addr, std::uint32_t v)
 {
-    ++stats_.n_cpu_accesses;
+    if (!attrs_.empty()) [[unlikely]]
+        if (const MemAttr at = attrs_(addr); at != MemAttr::cacheable) return device_store(addr, v, at);
+
     std::size_t set = index(addr);
-    std::uint32_t tg = tag(addr);
-    auto ways = std::views::iota(std::size_t{0}, ways_);
+    Prefetcher::Outcome outcome;
+    std::size_t way = demand(set, addr, outcome); // write-miss => write-allocate
 
-    if (auto hit = std::ranges::find_if(ways, [&](std::size_t w){
-            CacheLine& cl = data_[slot(set,w)];
-            if (cl.valid && cl.tag == tg) { cl.words[(addr>>2)&3]=v; cl.dirty=true; return true; }
-            return false; });
-        hit != ways.end())
-    {
-        ++stats_.n_hits;
-        touch_lru(set,*hit);
-        if (policy_ == WritePolicy::write_through)
-            return next_->store_word(addr, v);
-        return true;
-    }
+    CacheLine& cl = data_[slot(set,way)];
+    cl.words[(addr>>2)&(line_words-1)] = v;
+    cl.dirty = policy_ == WritePolicy::write_back; // write-through lines are never stale below
 
-    // write-miss => write-allocate, then retry as hit
-    ++stats_.n_misses;
-    std::size_t victim = select_victim(set);
-    fill_line(set, victim, addr);
-    return store_word(addr, v);
+    if (prefetcher_) prefetch(addr, outcome);
+    if (policy_ == WritePolicy::write_through)
+        return next_->store_word(addr, v);
+    return true;
 }
 
-inline void Cache::fill_line(std::size_t set, std::size_t way, Address addr)
+inline void Cache::attach_victim_cache(std::size_t entries)
+{
+    if (victim_)
+        victim_->drain([&](const VictimCache::Entry& e) {
+            if (e.data.dirty) next_->store_block(e.line << line_shift, e.data.words);
+        });
+    victim_ = entries ? std::make_unique<VictimCache>(entries) : nullptr;
+}
+
+inline void Cache::fill_line(std::size_t set, std::size_t way, Address addr, bool promote)
 {
     std::size_t sl = slot(set, way);
     CacheLine& cl = data_[sl];
 
-    // write-back dirty victim
-    if (cl.valid && cl.dirty)
-        for (std::size_t i=0;i<line_words;++i)
-            next_->store_word(static_cast<std::uint32_t>(((cl.tag<<6)|set)<<line_shift | (i<<2)), cl.words[i]);
+    // the victim cache may hold the incoming line (possibly dirty): take it before it can be displaced
+    std::optional<CacheLine> swapped;
+    if (victim_) {
+        swapped = victim_->take(addr >> line_shift);
+        if (promote) stats_.record(swapped ? CacheStats::Event::vc_hit : CacheStats::Event::vc_miss);
+    }
 
-    stats_.n_evictions += cl.valid;
-    Address base = addr & ~( (1u<<line_shift)-1 );
-    for (std::size_t i=0;i<line_words;++i)
-        cl.words[i] = next_->load_word(static_cast<std::uint32_t>(base | (i<<2))).value_or(0);
+    stats_.record(CacheStats::Event::eviction, cl.valid);
+    if (cl.valid && cl.prefetched) stats_.record(CacheStats::Event::pf_useless);
+
+    if (cl.valid && victim_) {
+        // park the evicted line; only what falls out of the victim cache is written back
+        if (auto out = victim_->insert(static_cast<std::uint32_t>(line_base(cl.tag, set) >> line_shift), cl);
+            out && out->data.dirty) {
+            next_->store_block(out->line << line_shift, out->data.words);
+            stats_.record(CacheStats::Event::vc_writeback);
+        }
+    } else if (cl.valid && cl.dirty) {
+        next_->store_block(line_base(cl.tag, set), cl.words);
+    }
+
+    if (swapped) {
+        cl.words = swapped->words;
+        cl.dirty = swapped->dirty;
+    } else {
+        Address base = addr & ~( (1u<<line_shift)-1 );
+        for (std::size_t i=0;i<line_words;++i)
+            cl.words[i] = next_->load_word(static_cast<std::uint32_t>(base | (i<<2))).value_or(0);
+        cl.dirty = false;
+    }
 
     cl.tag = tag(addr);
     cl.valid = true;
-    cl.dirty = false;
-    touch_lru(set, way);
+    cl.prefetched = false;
+    if (promote) touch_lru(set, way);
 }
 
 } // namespace rv
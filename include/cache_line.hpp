@@ -10,10 +10,12 @@ struct CacheLine
     std::uint32_t tag  = 0;
     bool          valid{false};
     bool          dirty{false};
+    bool          prefetched{false}; // brought in by a prefetcher, not yet used
+    std::uint32_t fill_stamp = 0;    // cache access clock at prefetch fill
 
     std::array<std::uint32_t, 4> words{}; // 16-byte line (4-by-32-bit)
 
-    void reset() noexcept { valid = dirty = false; }
+    void reset() noexcept { valid = dirty = prefetched = false; }
 };
 
 } // namespace rv
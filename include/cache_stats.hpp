@@ -1,25 +1,232 @@
 #pragma once
+#include <array>
 #include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
 #include <format>
+#include <memory>
+#include <mutex>
 #include <string>
-#include <format>
+#include <vector>
 
 namespace rv {
 
+/*
+Cache counters, one shard per host thread so that concurrent accesses never bounce a shared cache line.
+Only the owning thread writes a shard, so an update is a relaxed load and store (no locked instruction);
+readers aggregate all shards on demand. Per-set hit/miss counts and the reuse histogram live in the
+shards too. A thread finds its shard through a small thread_local table keyed by the instance's id and
+only takes the registry lock the first time it touches an instance (or after a table collision).
+When a thread exits its shards keep their counts and are handed to the next thread that attaches,
+so thread-pool replays don't grow the registry past the peak number of live threads.
+Attaching allocates, so the writers can throw std::bad_alloc on a thread's first access.
+*/
 struct CacheStats
 {
-    std::atomic<std::uint64_t> n_hits{0};
-    std::atomic<std::uint64_t> n_misses{0};
-    std::atomic<std::uint64_t> n_evictions{0};
-    std::atomic<std::uint64_t> n_cpu_accesses{0};
+    enum class Event : std::uint8_t {
+        hit, miss, eviction, cpu_access,
+        compulsory, capacity, conflict, // 3C miss classes (only with Cache::enable_profiling)
+        pf_issued,     // prefetch fills
+        pf_redundant,  // prefetch candidates already resident (dropped)
+        pf_useful,     // prefetched lines later hit by a demand access
+        pf_late,       // useful, but used within the cache's late window of the fill
+        pf_useless,    // prefetched lines evicted before any demand use
+        vc_hit,        // demand misses served by the victim cache (only with Cache::attach_victim_cache)
+        vc_miss,       // demand misses that also missed the victim cache
+        vc_writeback,  // dirty lines pushed out of the victim cache to the next level
+        uncached,      // accesses to uncached / write-combining ranges (not counted as cpu_access)
+        wc_flush,      // write-combining bursts sent to the next level
+        count_
+    };
+
+    static constexpr std::size_t n_events      = static_cast<std::size_t>(Event::count_);
+    static constexpr std::size_t reuse_buckets = 34; // [0], [1], [2,3], [4,7], ..., [2^32, inf)
+
+    explicit CacheStats(std::size_t sets = 0) : sets_{sets} {}
+
+    CacheStats(const CacheStats&)            = delete;
+    CacheStats& operator=(const CacheStats&) = delete;
+
+    /*
+    writers (hot path)
+    */
+    void record(Event e, std::uint64_t n = 1)
+    {
+        bump(local_shard().counters[static_cast<std::size_t>(e)], n);
+    }
+
+    /* one demand access: cpu_access, hit or miss, and the set's hit/miss count */
+    void record_access(std::size_t set, bool hit)
+    {
+        Shard& sh = local_shard();
+        bump(sh.counters[static_cast<std::size_t>(Event::cpu_access)]);
+        bump(sh.counters[static_cast<std::size_t>(hit ? Event::hit : Event::miss)]);
+        if (set < sets_) bump(sh.per_set[2 * set + (hit ? 0 : 1)]);
+    }
+
+    /* `distance` = accesses to the cache since this line was last touched */
+    void record_reuse(std::uint64_t distance)
+    {
+        bump(local_shard().reuse[reuse_bucket_of(distance)]);
+    }
+
+    /*
+    readers (aggregate across shards)
+    */
+    [[nodiscard]] std::uint64_t count(Event e) const noexcept
+    {
+        return sum([&](const Shard& sh) { return sh.counters[static_cast<std::size_t>(e)].load(std::memory_order_relaxed); });
+    }
+
+    [[nodiscard]] std::uint64_t hits()              const noexcept { return count(Event::hit); }
+    [[nodiscard]] std::uint64_t misses()            const noexcept { return count(Event::miss); }
+    [[nodiscard]] std::uint64_t evictions()         const noexcept { return count(Event::eviction); }
+    [[nodiscard]] std::uint64_t cpu_accesses()      const noexcept { return count(Event::cpu_access); }
+    [[nodiscard]] std::uint64_t compulsory_misses() const noexcept { return count(Event::compulsory); }
+    [[nodiscard]] std::uint64_t capacity_misses()   const noexcept { return count(Event::capacity); }
+    [[nodiscard]] std::uint64_t conflict_misses()   const noexcept { return count(Event::conflict); }
+
+    /* prefetch quality: accuracy = useful / issued, coverage = useful / (useful + misses), timeliness = on-time / useful */
+    [[nodiscard]] double pf_accuracy() const noexcept
+    {
+        const auto n = count(Event::pf_issued);
+        return n ? static_cast<double>(count(Event::pf_useful)) / static_cast<double>(n) : 0.0;
+    }
+    [[nodiscard]] double pf_coverage() const noexcept
+    {
+        const auto u = count(Event::pf_useful), d = u + misses();
+        return d ? static_cast<double>(u) / static_cast<double>(d) : 0.0;
+    }
+    [[nodiscard]] double pf_timeliness() const noexcept
+    {
+        const auto u = count(Event::pf_useful);
+        return u ? 1.0 - static_cast<double>(count(Event::pf_late)) / static_cast<double>(u) : 0.0;
+    }
+
+    /* share of L1 misses the victim cache caught; those never reach the next level */
+    [[nodiscard]] double vc_hit_rate() const noexcept
+    {
+        const auto h = count(Event::vc_hit), n = h + count(Event::vc_miss);
+        return n ? static_cast<double>(h) / static_cast<double>(n) : 0.0;
+    }
+
+    [[nodiscard]] std::size_t   set_count()            const noexcept { return sets_; }
+    [[nodiscard]] std::size_t   shard_count() const
+    {
+        std::scoped_lock lk(shards_mtx_);
+        return shards_.size();
+    }
+    [[nodiscard]] std::uint64_t set_hits(std::size_t s)   const noexcept { return per_set_count(s, 0); }
+    [[nodiscard]] std::uint64_t set_misses(std::size_t s) const noexcept { return per_set_count(s, 1); }
+
+    [[nodiscard]] std::uint64_t reuse_bucket(std::size_t b) const noexcept
+    {
+        return sum([&](const Shard& sh) { return sh.reuse[b].load(std::memory_order_relaxed); });
+    }
+
+    /* lower bound of the distances counted in bucket `b` */
+    [[nodiscard]] static constexpr std::uint64_t reuse_bucket_floor(std::size_t b) noexcept
+    { return b == 0 ? 0 : std::uint64_t{1} << (b - 1); }
+
+    [[nodiscard]] static constexpr std::size_t reuse_bucket_of(std::uint64_t distance) noexcept
+    {
+        const auto b = static_cast<std::size_t>(std::bit_width(distance));
+        return b < reuse_buckets ? b : reuse_buckets - 1;
+    }
 
     [[nodiscard]] double hit_rate()  const noexcept
-    { return n_hits ? static_cast<double>(n_hits) / static_cast<double>(n_cpu_accesses) : 0.0; }
+    {
+        const auto h = hits();
+        return h ? static_cast<double>(h) / static_cast<double>(cpu_accesses()) : 0.0;
+    }
     [[nodiscard]] double miss_rate() const noexcept { return 1.0 - hit_rate(); }
 
     std::string pretty() const
     {
-        return std::format("Hits {:8}, Misses {:8}  =>  HR {:5.2f}%", n_hits.load(), n_misses.load(), hit_rate()*100.0);
+        return std::format("Hits {:8}, Misses {:8}  =>  HR {:5.2f}%", hits(), misses(), hit_rate()*100.0);
+    }
+
+  private:
+    using ExitFlag = std::shared_ptr<std::atomic<bool>>;
+
+    struct alignas(64) Shard
+    {
+        explicit Shard(ExitFlag t, std::size_t sets)
+            : owner{std::move(t)}, per_set{ std::make_unique<std::atomic<std::uint64_t>[]>(2 * sets) } {}
+
+        ExitFlag                                              owner;     // set once the owning thread has exited
+        std::array<std::atomic<std::uint64_t>, n_events>      counters{};
+        std::array<std::atomic<std::uint64_t>, reuse_buckets> reuse{};
+        std::unique_ptr<std::atomic<std::uint64_t>[]>         per_set;   // [2*set] hits, [2*set+1] misses
+    };
+
+    static constexpr std::size_t lookup_slots = 16;   // thread_local (instance id -> shard) table
+
+    std::size_t                         sets_;
+    const std::uint64_t                 id_ = next_id_.fetch_add(1, std::memory_order_relaxed);
+    mutable std::mutex                  shards_mtx_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+
+    inline static std::atomic<std::uint64_t> next_id_{1};   // ids are never reused, so stale table entries never match
+
+    /* single writer per shard: no read-modify-write needed */
+    static void bump(std::atomic<std::uint64_t>& c, std::uint64_t n = 1) noexcept
+    {
+        c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    /* this thread's exit flag; the release store orders its last counter updates before a new owner's */
+    static const ExitFlag& thread_exit_flag()
+    {
+        struct Token
+        {
+            ExitFlag exited = std::make_shared<std::atomic<bool>>(false);
+            ~Token() { exited->store(true, std::memory_order_release); }
+        };
+        thread_local Token token;
+        return token.exited;
+    }
+
+    Shard& local_shard()
+    {
+        struct Slot { std::uint64_t owner = 0; Shard* shard = nullptr; };
+        thread_local std::array<Slot, lookup_slots> slots{};
+        Slot& slot = slots[id_ % lookup_slots];
+        if (slot.owner != id_) [[unlikely]] slot = { id_, &attach_shard() };
+        return *slot.shard;
+    }
+
+    /* this thread's shard: the one it already owns, else one left by an exited thread, else a new one */
+    Shard& attach_shard()
+    {
+        const ExitFlag& me = thread_exit_flag();
+        std::scoped_lock lk(shards_mtx_);
+        Shard* orphan = nullptr;
+        for (auto& sh : shards_) {
+            if (sh->owner == me) return *sh;
+            if (!orphan && sh->owner->load(std::memory_order_acquire)) orphan = sh.get();
+        }
+        if (orphan) {
+            orphan->owner = me;
+            return *orphan;
+        }
+        return *shards_.emplace_back(std::make_unique<Shard>(me, sets_));
+    }
+
+    template <class F>
+    std::uint64_t sum(F&& field) const noexcept
+    {
+        std::scoped_lock lk(shards_mtx_);
+        std::uint64_t total = 0;
+        for (const auto& sh : shards_) total += field(*sh);
+        return total;
+    }
+
+    std::uint64_t per_set_count(std::size_t s, std::size_t which) const noexcept
+    {
+        if (s >= sets_) return 0;
+        return sum([&](const Shard& sh) { return sh.per_set[2 * s + which].load(std::memory_order_relaxed); });
     }
 };
 
@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include <format>
 #include <string_view>
 #include "cache_stats.hpp"
@@ -6,15 +7,20 @@
 /*
 Add a formatter *into namespace std*.
 Supports:
-    "{}"      ->  single-line (same as CacheStats::pretty())
-    "{:full}" ->  multi-line, nicely indented block
+    "{}"          ->  single-line (same as CacheStats::pretty())
+    "{:full}"     ->  multi-line, nicely indented block
+    "{:3c}"       ->  compulsory / capacity / conflict miss breakdown
+    "{:sets}"     ->  per-set miss-rate heatmap
+    "{:reuse}"    ->  log2 reuse-distance histogram
+    "{:prefetch}" ->  prefetcher issued / useful / useless, accuracy, coverage, timeliness
+    "{:victim}"   ->  victim-cache hits / misses / write-backs and hit rate
 Any other specifier triggers a std::format_error.
 */
 template <>
 struct std::formatter<rv::CacheStats, char>
 {
     // store which style the user asked for
-    enum class style { single, full } sty{style::single};
+    enum class style { single, full, three_c, sets, reuse, prefetch, victim } sty{style::single};
 
     constexpr auto parse(std::format_parse_context& ctx)
     {
@@ -22,7 +28,12 @@ struct std::formatter<rv::CacheStats, char>
         if (it != ctx.end() && *it != '}') {
             if (*it == ':' ) ++it; // ignore :
             const std::string_view tag{ it, ctx.end() };
-            if (tag.starts_with("full")) { sty = style::full; it += 4; }
+            if      (tag.starts_with("full"))  { sty = style::full;    it += 4; }
+            else if (tag.starts_with("3c"))    { sty = style::three_c; it += 2; }
+            else if (tag.starts_with("sets"))  { sty = style::sets;    it += 4; }
+            else if (tag.starts_with("reuse")) { sty = style::reuse;   it += 5; }
+            else if (tag.starts_with("prefetch")) { sty = style::prefetch; it += 8; }
+            else if (tag.starts_with("victim"))   { sty = style::victim;   it += 6; }
             else throw std::format_error("unknown format for CacheStats");
         }
         return it; // points at '}'
@@ -36,7 +47,7 @@ struct std::formatter<rv::CacheStats, char>
         case style::single:
             return format_to(ctx.out(), "Hits {:8}, Misses {:8}  "
                                          "HR {:5.2f}%  MR {:5.2f}%",
-                              cs.n_hits.load(), cs.n_misses.load(),
+                              cs.hits(), cs.misses(),
                               cs.hit_rate()*100.0, cs.miss_rate()*100.0);
 
         case style::full:
@@ -49,9 +60,90 @@ R"(Cache statistics
     Hit rate     : {4:5.2f} %
     Miss rate    : {5:5.2f} %
 )",
-                cs.n_cpu_accesses.load(), cs.n_hits.load(),
-                cs.n_misses.load(), cs.n_evictions.load(),
+                cs.cpu_accesses(), cs.hits(),
+                cs.misses(), cs.evictions(),
                 cs.hit_rate()*100.0, cs.miss_rate()*100.0);
+
+        case style::three_c: {
+            const auto total = cs.compulsory_misses() + cs.capacity_misses() + cs.conflict_misses();
+            auto pct = [&](std::uint64_t n) {
+                return total ? static_cast<double>(n) * 100.0 / static_cast<double>(total) : 0.0;
+            };
+            return format_to(ctx.out(),
+R"(Miss classification (3C)
+    Compulsory   : {0:10}  ({1:5.2f} %)
+    Capacity     : {2:10}  ({3:5.2f} %)
+    Conflict     : {4:10}  ({5:5.2f} %)
+)",
+                cs.compulsory_misses(), pct(cs.compulsory_misses()),
+                cs.capacity_misses(),   pct(cs.capacity_misses()),
+                cs.conflict_misses(),   pct(cs.conflict_misses()));
+        }
+
+        case style::sets: {
+            // one glyph per set, darker = higher miss rate
+            constexpr std::string_view shades = " .:-=+*#%@";
+            constexpr std::size_t      per_row = 32;
+            auto out = format_to(ctx.out(), "Per-set miss heatmap ({} sets, '{}' = 0..100 % miss)\n",
+                                 cs.set_count(), shades);
+            for (std::size_t s = 0; s < cs.set_count(); ++s) {
+                if (s % per_row == 0) out = format_to(out, "    {:5} |", s);
+                const auto h = cs.set_hits(s), m = cs.set_misses(s);
+                const auto shade = (h + m) ? (m * (shades.size() - 1) + (h + m) / 2) / (h + m) : 0;
+                out = format_to(out, "{}", shades[shade]);
+                if (s % per_row == per_row - 1 || s + 1 == cs.set_count()) out = format_to(out, "|\n");
+            }
+            return out;
+        }
+
+        case style::reuse: {
+            constexpr std::size_t bar_width = 40;
+            std::uint64_t peak = 0;
+            for (std::size_t b = 0; b < rv::CacheStats::reuse_buckets; ++b)
+                peak = std::max(peak, cs.reuse_bucket(b));
+
+            auto out = format_to(ctx.out(), "Reuse distance (accesses since last touch)\n");
+            for (std::size_t b = 0; b < rv::CacheStats::reuse_buckets; ++b) {
+                const auto n = cs.reuse_bucket(b);
+                if (!n) continue;
+                const auto len = static_cast<std::size_t>(n * bar_width / peak);
+                out = format_to(out, "    >= {:10} : {:10} {:#<{}}\n",
+                                rv::CacheStats::reuse_bucket_floor(b), n, "", std::max<std::size_t>(len, 1));
+            }
+            return out;
+        }
+
+        case style::prefetch: {
+            using E = rv::CacheStats::Event;
+            return format_to(ctx.out(),
+R"(Prefetcher
+    Issued       : {0:10}
+    Redundant    : {1:10}
+    Useful       : {2:10}
+    Late         : {3:10}
+    Useless      : {4:10}
+    Accuracy     : {5:5.2f} %
+    Coverage     : {6:5.2f} %
+    Timeliness   : {7:5.2f} %
+)",
+                cs.count(E::pf_issued), cs.count(E::pf_redundant), cs.count(E::pf_useful),
+                cs.count(E::pf_late), cs.count(E::pf_useless),
+                cs.pf_accuracy()*100.0, cs.pf_coverage()*100.0, cs.pf_timeliness()*100.0);
+        }
+
+        case style::victim: {
+            using E = rv::CacheStats::Event;
+            return format_to(ctx.out(),
+R"(Victim cache
+    L1 misses    : {0:10}
+    VC hits      : {1:10}
+    VC misses    : {2:10}
+    Write-backs  : {3:10}
+    VC hit rate  : {4:5.2f} %
+)",
+                cs.misses(), cs.count(E::vc_hit), cs.count(E::vc_miss),
+                cs.count(E::vc_writeback), cs.vc_hit_rate()*100.0);
+        }
         }
         // unreachable, but silences -Wreturn-type
         return format_to(ctx.out(), "");
@@ -0,0 +1,62 @@
+#pragma once
+#include "mmio_device.hpp"
+#include "riscv.hpp"
+#include <cstdint>
+
+namespace rv {
+
+/*
+Core-local interruptor (CLINT) in the usual SiFive layout, for one hart:
+
+    0x0000 MSIP          bit0 drives the software interrupt line
+    0x4000 MTIMECMP      low word  } timer interrupt pending while mtime >= mtimecmp
+    0x4004 MTIMECMPH     high word }
+    0xBFF8 MTIME         low word  } read-only here: mtime is the CPU's cycle count
+    0xBFFC MTIMEH        high word }
+
+mtime therefore ticks at the emulated clock (one per instruction, plus the cycles a WFI
+lets pass), so a guest that programs mtimecmp sees time at the rate the host runs it.
+mtimecmp starts at all ones (no timer).
+*/
+class Clint : public MmioDevice
+{
+  public:
+    static constexpr std::uint32_t default_base = 0x0200'0000;
+    static constexpr std::uint32_t window_size  = 0xC000;
+
+    enum Reg : std::uint32_t { msip = 0x0000, mtimecmp = 0x4000, mtimecmph = 0x4004, mtime = 0xBFF8, mtimeh = 0xBFFC };
+
+    explicit Clint(RiscV& cpu) : cpu_{cpu} {}
+
+    std::uint32_t read(std::uint32_t offset) override
+    {
+        switch (offset) {
+          case msip:      return msip_;
+          case mtimecmp:  return static_cast<std::uint32_t>(cpu_.timer_compare());
+          case mtimecmph: return static_cast<std::uint32_t>(cpu_.timer_compare() >> 32);
+          case mtime:     return static_cast<std::uint32_t>(cpu_.cycle());
+          case mtimeh:    return static_cast<std::uint32_t>(cpu_.cycle() >> 32);
+          default:        return 0;
+        }
+    }
+
+    void write(std::uint32_t offset, std::uint32_t v) override
+    {
+        const std::uint64_t cmp = cpu_.timer_compare();
+        switch (offset) {
+          case msip:
+            msip_ = v & 1;
+            cpu_.set_software_irq(msip_);
+            break;
+          case mtimecmp:  cpu_.set_timer_compare((cmp & ~std::uint64_t{ 0xFFFF'FFFF }) | v); break;
+          case mtimecmph: cpu_.set_timer_compare((cmp & 0xFFFF'FFFF) | (std::uint64_t{ v } << 32)); break;
+          default:        break;
+        }
+    }
+
+  private:
+    RiscV&        cpu_;
+    std::uint32_t msip_ = 0;
+};
+
+} // namespace rv
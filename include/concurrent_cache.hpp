@@ -0,0 +1,267 @@
+#pragma once
+#include "memory_bus.hpp"
+#include "cache_stats.hpp"
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <thread>
+
+namespace rv {
+
+/*
+N-way set-associative cache that many host threads (or harts) can share.
+
+Every set is guarded by a seqlock living in its own cache line:
+  - load hits are optimistic and lock-free: read the sequence, probe, re-check;
+  - fills, write-backs and stores take the set's lock (sequence goes odd).
+Line contents are relaxed atomics so optimistic readers never race on plain memory.
+Replacement is CLOCK (second chance): a hit only sets the line's reference bit, and only
+if it is clear, so a read hit writes shared state at most once per line per CLOCK sweep
+(the first hit after the hand cleared the bit); repeat hits are pure reads. That one
+store dirties the line's cache line for the other readers of the set.
+The next level must be thread-safe (e.g. ConcurrentHashTable).
+*/
+class ConcurrentCache : public MemoryBus
+{
+  public:
+    using Address = std::uint32_t;
+
+    enum class WritePolicy { write_back, write_through };
+
+    ConcurrentCache(std::size_t sets,
+                    std::size_t ways,
+                    std::unique_ptr<MemoryBus> next,
+                    WritePolicy wp = WritePolicy::write_back)
+        : sets_{sets},
+          ways_{ways},
+          set_bits_{static_cast<unsigned>(std::countr_zero(sets))},
+          policy_{wp},
+          lines_{ std::make_unique<Line[]>(sets * ways) },
+          locks_{ std::make_unique<SetLock[]>(sets) },
+          next_{std::move(next)},
+          stats_{sets}
+    {
+        assert(std::has_single_bit(sets) && ways > 0);
+    }
+
+    /*
+    MemoryBus
+    */
+    std::optional<std::uint32_t> load_word(Address addr) override;
+    bool store_word(Address addr, std::uint32_t v) override;
+    void fence() override { next_->fence(); }
+
+    /* write every dirty line back to the next level (lines stay valid) */
+    void flush();
+
+    [[nodiscard]] CacheStats const& stats() const noexcept { return stats_; }
+
+  private:
+    static constexpr std::size_t line_words = 4;
+    static constexpr std::size_t line_shift = 4; // 16-byte line
+    static constexpr int         optimistic_tries = 4;
+
+    struct Line
+    {
+        std::atomic<std::uint32_t>                          tag{0};
+        std::atomic<bool>                                   valid{false};
+        std::atomic<bool>                                   dirty{false};
+        std::atomic<bool>                                   ref{false};
+        std::array<std::atomic<std::uint32_t>, line_words>  words{};
+    };
+
+    struct alignas(64) SetLock
+    {
+        std::atomic<std::uint32_t> seq{0}; // odd while a writer holds the set
+        std::size_t                hand{0}; // CLOCK hand, only touched under the lock
+    };
+
+    const std::size_t sets_;
+    const std::size_t ways_;
+    const unsigned    set_bits_;
+    const WritePolicy policy_;
+
+    std::unique_ptr<Line[]>    lines_; // flat [set*ways + way]
+    std::unique_ptr<SetLock[]> locks_;
+    std::unique_ptr<MemoryBus> next_;
+    CacheStats                 stats_;
+
+    [[nodiscard]] std::uint32_t tag(Address a) const noexcept { return a >> (line_shift + set_bits_); }
+    [[nodiscard]] std::size_t index(Address a) const noexcept { return (a >> line_shift) & (sets_ - 1); }
+    [[nodiscard]] static std::size_t word(Address a) noexcept { return (a >> 2) & (line_words - 1); }
+    [[nodiscard]] Line& line(std::size_t set, std::size_t way) const noexcept { return lines_[set * ways_ + way]; }
+
+    [[nodiscard]] Address line_base(std::uint32_t tg, std::size_t set) const noexcept
+    {
+        return static_cast<Address>(((static_cast<std::size_t>(tg) << set_bits_) | set) << line_shift);
+    }
+
+    /* way holding `tg` in `set`, or ways_ if absent (relaxed probes) */
+    [[nodiscard]] std::size_t find(std::size_t set, std::uint32_t tg) const noexcept
+    {
+        for (std::size_t w = 0; w < ways_; ++w) {
+            const Line& l = line(set, w);
+            if (l.valid.load(std::memory_order_relaxed) && l.tag.load(std::memory_order_relaxed) == tg)
+                return w;
+        }
+        return ways_;
+    }
+
+    /* test before set: only the first hit after a CLOCK sweep stores */
+    static void mark_used(Line& l) noexcept
+    {
+        if (!l.ref.load(std::memory_order_relaxed)) l.ref.store(true, std::memory_order_relaxed);
+    }
+
+    std::uint32_t lock(std::size_t set) noexcept;
+    void unlock(std::size_t set, std::uint32_t seq) noexcept;
+    std::size_t select_victim(std::size_t set) noexcept;
+    std::size_t fill_locked(std::size_t set, Address addr);
+    void record(std::size_t set, bool hit);
+};
+
+/*
+Implementation
+*/
+inline std::uint32_t ConcurrentCache::lock(std::size_t set) noexcept
+{
+    auto& seq = locks_[set].seq;
+    for (unsigned spins = 0;; ++spins) {
+        std::uint32_t s = seq.load(std::memory_order_relaxed);
+        if (!(s & 1) && seq.compare_exchange_weak(s, s + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+            std::atomic_thread_fence(std::memory_order_release); // data writes stay after the odd sequence
+            return s + 1;
+        }
+        if (spins > 64) std::this_thread::yield();
+    }
+}
+
+inline void ConcurrentCache::unlock(std::size_t set, std::uint32_t seq) noexcept
+{
+    locks_[set].seq.store(seq + 1, std::memory_order_release);
+}
+
+inline void ConcurrentCache::record(std::size_t set, bool hit)
+{
+    stats_.record_access(set, hit);
+}
+
+inline std::size_t ConcurrentCache::select_victim(std::size_t set) noexcept
+{
+    for (std::size_t w = 0; w < ways_; ++w)
+        if (!line(set, w).valid.load(std::memory_order_relaxed)) return w;
+
+    // CLOCK: skip (and clear) referenced ways until an unreferenced one comes round
+    std::size_t& hand = locks_[set].hand;
+    for (;;) {
+        const std::size_t w = hand;
+        hand = (hand + 1) % ways_;
+        if (!line(set, w).ref.exchange(false, std::memory_order_relaxed)) return w;
+    }
+}
+
+/* caller holds the set lock; returns the way now holding `addr` */
+inline std::size_t ConcurrentCache::fill_locked(std::size_t set, Address addr)
+{
+    const std::size_t way = select_victim(set);
+    Line& l = line(set, way);
+
+    if (l.valid.load(std::memory_order_relaxed)) {
+        stats_.record(CacheStats::Event::eviction);
+        if (l.dirty.load(std::memory_order_relaxed)) {
+            const Address base = line_base(l.tag.load(std::memory_order_relaxed), set);
+            for (std::size_t i = 0; i < line_words; ++i)
+                next_->store_word(base | static_cast<Address>(i << 2), l.words[i].load(std::memory_order_relaxed));
+        }
+    }
+
+    const Address base = addr & ~((Address{1} << line_shift) - 1);
+    for (std::size_t i = 0; i < line_words; ++i)
+        l.words[i].store(next_->load_word(base | static_cast<Address>(i << 2)).value_or(0), std::memory_order_relaxed);
+    l.tag.store(tag(addr), std::memory_order_relaxed);
+    l.dirty.store(false, std::memory_order_relaxed);
+    l.ref.store(true, std::memory_order_relaxed);
+    l.valid.store(true, std::memory_order_relaxed);
+    return way;
+}
+
+inline std::optional<std::uint32_t> ConcurrentCache::load_word(Address addr)
+{
+    const std::size_t   set = index(addr);
+    const std::uint32_t tg  = tag(addr);
+    auto& seq = locks_[set].seq;
+
+    // optimistic, lock-free hit path
+    for (int attempt = 0; attempt < optimistic_tries; ++attempt) {
+        const std::uint32_t s1 = seq.load(std::memory_order_acquire);
+        if (s1 & 1) continue;
+
+        const std::size_t way = find(set, tg);
+        const std::uint32_t v = way < ways_ ? line(set, way).words[word(addr)].load(std::memory_order_relaxed) : 0;
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seq.load(std::memory_order_relaxed) != s1) continue;
+        if (way == ways_) break; // consistent miss: go fill
+
+        mark_used(line(set, way));
+        record(set, true);
+        return v;
+    }
+
+    // locked path: miss (or too much write traffic on this set)
+    const std::uint32_t s = lock(set);
+    std::size_t way = find(set, tg);
+    const bool hit = way < ways_;
+    if (!hit) way = fill_locked(set, addr);
+    const std::uint32_t v = line(set, way).words[word(addr)].load(std::memory_order_relaxed);
+    mark_used(line(set, way));
+    unlock(set, s);
+
+    record(set, hit);
+    return v;
+}
+
+inline bool ConcurrentCache::store_word(Address addr, std::uint32_t v)
+{
+    const std::size_t set = index(addr);
+    const std::uint32_t s = lock(set);
+
+    std::size_t way = find(set, tag(addr));
+    const bool hit = way < ways_;
+    if (!hit) way = fill_locked(set, addr); // write-allocate
+
+    Line& l = line(set, way);
+    l.words[word(addr)].store(v, std::memory_order_relaxed);
+    l.dirty.store(policy_ == WritePolicy::write_back, std::memory_order_relaxed);
+    mark_used(l);
+
+    bool ok = true;
+    if (policy_ == WritePolicy::write_through)
+        ok = next_->store_word(addr, v); // under the lock, so per-line write order is kept
+    unlock(set, s);
+
+    record(set, hit);
+    return ok;
+}
+
+inline void ConcurrentCache::flush()
+{
+    for (std::size_t set = 0; set < sets_; ++set) {
+        const std::uint32_t s = lock(set);
+        for (std::size_t w = 0; w < ways_; ++w) {
+            Line& l = line(set, w);
+            if (!l.valid.load(std::memory_order_relaxed) || !l.dirty.load(std::memory_order_relaxed)) continue;
+            const Address base = line_base(l.tag.load(std::memory_order_relaxed), set);
+            for (std::size_t i = 0; i < line_words; ++i)
+                next_->store_word(base | static_cast<Address>(i << 2), l.words[i].load(std::memory_order_relaxed));
+            l.dirty.store(false, std::memory_order_relaxed);
+        }
+        unlock(set, s);
+    }
+}
+
+} // namespace rv
@@ -1,25 +1,109 @@
 #pragma once
+#include "epoch.hpp"
 #include "lock_free_list.hpp"
 #include "memory_bus.hpp"
-#include <shared_mutex>
-#include <exception>
-#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
 #include <optional>
-#ifndef __EMSCRIPTEN__
-#  include <oneapi/dpl/execution>
-#  include <oneapi/dpl/algorithm>
-#endif
+#include <thread>
 
 namespace rv {
 
-template <typename K, typename V, typename Hash = std::hash<K>, typename KeyEq = std::equal_to<K>>
+/*
+Lock-free hash map (LockFreeList buckets) with lock-free reads and incremental resize.
+
+Buckets live in fixed-size segments hanging off an atomically published table, and are
+read under an Epoch guard: get() takes no lock and writes nothing shared.
+Growing publishes a table twice the size that points back at the old one. From then on
+every put/erase first moves its own old bucket, then a few more: one thread claims the old
+bucket, freezes it, copies its entries across and retires its nodes (a writer that needs a
+bucket someone else is copying waits for that one bucket). A fully moved old segment is
+retired on the spot and the old table once all are gone; new segments are allocated on
+first write. So neither allocation, copying nor freeing is ever paid for the whole table
+by one put. Entry nodes come from `Alloc` (see LockFreeList); PoolAllocator keeps them
+in per-thread slabs.
+*/
+template <typename K, typename V, typename Hash = std::hash<K>, typename KeyEq = std::equal_to<K>,
+          typename Alloc = std::allocator<std::byte>>
 class ConcurrentHashTable : public MemoryBus
 {
-    using Bucket = LockFreeList<K,V>;
+    using Bucket = LockFreeList<K,V,Alloc>;
+
+    static constexpr unsigned max_seg_bits = 10; // 1024 buckets per segment
+
+    /* migration state of an old bucket */
+    enum : std::uint8_t { unmoved, copying, moved };
+
+    struct Segment
+    {
+        explicit Segment(std::size_t len)
+            : buckets{ std::make_unique<Bucket[]>(len) },
+              state{ std::make_unique<std::atomic<std::uint8_t>[]>(len) } {}
+
+        std::unique_ptr<Bucket[]>                    buckets;
+        std::unique_ptr<std::atomic<std::uint8_t>[]> state;  // unmoved / copying / moved
+        std::atomic<std::size_t>                     moved_count{0};
+    };
+
+    struct Table
+    {
+        Table(std::size_t cap, Table* prev)
+            : mask{cap - 1},
+              seg_bits{ std::min<unsigned>(max_seg_bits, static_cast<unsigned>(std::countr_zero(cap))) },
+              n_segs{ cap >> seg_bits },
+              segs{ std::make_unique<std::atomic<Segment*>[]>(n_segs) },
+              old{prev} {}
+
+        ~Table()
+        {
+            for (std::size_t s = 0; s < n_segs; ++s)
+                if (Segment* sg = segs[s].load(std::memory_order_relaxed); sg && sg != moved_segment()) delete sg;
+            delete old.load(std::memory_order_relaxed); // only non-null if destroyed mid-migration
+        }
+
+        const std::size_t                       mask;
+        const unsigned                          seg_bits;
+        const std::size_t                       n_segs;
+        std::unique_ptr<std::atomic<Segment*>[]> segs;          // null = never written, moved_segment() = drained
+        std::atomic<Table*>                     old;           // table being drained into this one
+        std::atomic<std::size_t>                claim{0};      // next old bucket to hand to a helper
+        std::atomic<std::size_t>                segs_done{0};  // old segments fully drained
+
+        [[nodiscard]] std::size_t capacity() const noexcept { return mask + 1; }
+        [[nodiscard]] std::size_t seg_len()  const noexcept { return std::size_t{1} << seg_bits; }
+
+        /* bucket `i` for writing, allocating its segment; nullptr once the segment has been drained */
+        Bucket* writable(std::size_t i)
+        {
+            auto& slot = segs[i >> seg_bits];
+            Segment* sg = slot.load(std::memory_order_acquire);
+            if (!sg) {
+                auto* fresh = new Segment(seg_len());
+                if (slot.compare_exchange_strong(sg, fresh, std::memory_order_acq_rel)) sg = fresh;
+                else delete fresh;
+            }
+            return sg == moved_segment() ? nullptr : &sg->buckets[i & (seg_len() - 1)];
+        }
+    };
+
+    /* marker for a drained old segment (never dereferenced) */
+    static Segment* moved_segment() noexcept
+    {
+        alignas(Segment) static std::byte marker[1];
+        return reinterpret_cast<Segment*>(&marker);
+    }
 
   public:
     explicit ConcurrentHashTable(std::size_t cap = 64)
-        : buckets_(cap) {}
+        : table_{ new Table(std::bit_ceil(cap < 2 ? std::size_t{2} : cap), nullptr) } {}
+
+    ~ConcurrentHashTable() { delete table_.load(std::memory_order_relaxed); }
+
+    ConcurrentHashTable(const ConcurrentHashTable&)            = delete;
+    ConcurrentHashTable& operator=(const ConcurrentHashTable&) = delete;
 
     /*
     MemoryBus facade
@@ -40,62 +124,159 @@ class ConcurrentHashTable : public MemoryBus
     [[nodiscard]]
     std::optional<V> get(const K& key) const
     {
-        std::shared_lock lk(table_mtx_);
-        return buckets_[bucket_index(key)].find(key);
+        auto guard = Epoch::pin();
+        const std::size_t h = hasher_(key);
+        for (;;) {
+            const Table* t = table_.load(std::memory_order_acquire);
+
+            // until an old bucket is moved it is the authoritative copy (writers to the new
+            // table move it first); if it moved while we looked, the new table has it all
+            if (const Table* o = t->old.load(std::memory_order_acquire)) {
+                const std::size_t i = h & o->mask, j = i & (o->seg_len() - 1);
+                const Segment* sg = o->segs[i >> o->seg_bits].load(std::memory_order_acquire);
+                if (sg && sg != moved_segment() && sg->state[j].load(std::memory_order_acquire) != moved) {
+                    auto v = sg->buckets[j].find(key);
+                    if (sg->state[j].load(std::memory_order_acquire) != moved) return v;
+                }
+            }
+
+            const std::size_t i = h & t->mask;
+            const Segment* sg = t->segs[i >> t->seg_bits].load(std::memory_order_acquire);
+            if (!sg) return std::nullopt;           // never written
+            if (sg == moved_segment()) continue;    // t was drained under us
+            const Bucket& b = sg->buckets[i & (t->seg_len() - 1)];
+            auto v = b.find(key);
+            if (!b.frozen()) return v;
+            // t started draining into a successor while we looked: read that instead
+        }
     }
 
     bool put(const K& key, const V& val)
     {
-        {   std::shared_lock lk(table_mtx_);
-            auto& b = buckets_[bucket_index(key)];
-            if (!b.put(key,val)) ++size_;
+        {
+            auto guard = Epoch::pin();
+            const std::size_t h = hasher_(key);
+            for (;;) {
+                Table* t = table_.load(std::memory_order_acquire);
+                if (Table* o = t->old.load(std::memory_order_acquire)) {
+                    migrate_bucket(t, o, h & o->mask); // our key's old entries must land first
+                    help_migrate(t);
+                }
+                Bucket* b = t->writable(h & t->mask);
+                const auto r = b ? b->try_put(key, val) : Bucket::PutResult::frozen;
+                if (r == Bucket::PutResult::frozen) continue; // t started draining under us: redo in its successor
+                if (r == Bucket::PutResult::inserted) size_.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
         }
-        maybe_rehash();
+        maybe_grow();
         return true;
     }
 
+    /* lock-free; returns true if the key was there */
+    bool erase(const K& key)
+    {
+        auto guard = Epoch::pin();
+        const std::size_t h = hasher_(key);
+        for (;;) {
+            Table* t = table_.load(std::memory_order_acquire);
+            if (Table* o = t->old.load(std::memory_order_acquire)) {
+                migrate_bucket(t, o, h & o->mask); // the key may still live in the old bucket
+                help_migrate(t);
+            }
+            const std::size_t i = h & t->mask;
+            Segment* sg = t->segs[i >> t->seg_bits].load(std::memory_order_acquire);
+            if (!sg) return false;                  // never written
+            if (sg == moved_segment()) continue;    // t drained under us
+            const auto r = sg->buckets[i & (t->seg_len() - 1)].try_erase(key);
+            if (r == Bucket::EraseResult::frozen) continue; // the bucket is being moved: erase from the successor
+            if (r == Bucket::EraseResult::absent) return false;
+            // `erased` is exact: a frozen node can't be marked, so nothing was copied
+            size_.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
     [[nodiscard]] std::size_t size() const noexcept { return size_.load(); }
+    [[nodiscard]] std::size_t capacity() const noexcept { return table_.load(std::memory_order_acquire)->capacity(); }
+    [[nodiscard]] bool resizing() const noexcept { return table_.load(std::memory_order_acquire)->old.load() != nullptr; }
 
   private:
-    mutable std::shared_mutex table_mtx_; // guards resize
-    std::vector<Bucket>       buckets_;
+    std::atomic<Table*>       table_;
     std::atomic<std::size_t>  size_{0};
     Hash                      hasher_;
 
-    static constexpr float max_load = 0.75f;
+    static constexpr float       max_load      = 0.75f;
+    static constexpr std::size_t migrate_batch = 8; // extra old buckets each put moves
+
+    /* make sure old bucket `i` has been moved into `t`: claim and copy it, or wait for whoever claimed it */
+    void migrate_bucket(Table* t, Table* o, std::size_t i)
+    {
+        auto& slot = o->segs[i >> o->seg_bits];
+        Segment* sg = slot.load(std::memory_order_acquire);
+        if (sg == moved_segment()) return;
+        if (!sg) {
+            // never written: seal it so a writer still holding `o` can't start filling it now
+            if (slot.compare_exchange_strong(sg, moved_segment(), std::memory_order_acq_rel)) {
+                segment_drained(t, o);
+                return;
+            }
+            if (sg == moved_segment()) return;
+        }
+
+        const std::size_t j = i & (o->seg_len() - 1);
+        std::uint8_t st = unmoved;
+        if (!sg->state[j].compare_exchange_strong(st, copying, std::memory_order_acq_rel)) {
+            while (sg->state[j].load(std::memory_order_acquire) != moved) std::this_thread::yield();
+            return;
+        }
+
+        // only the claimant copies, so nothing stale can land in `t` after the bucket is marked moved
+        Bucket& b = sg->buckets[j];
+        b.freeze();
+        b.for_each([&](const K& k, const V& v) { t->writable(hasher_(k) & t->mask)->try_insert(k, v); });
+        sg->state[j].store(moved, std::memory_order_release);
 
-    std::size_t bucket_index(const K& k) const noexcept
-    { return hasher_(k) & (buckets_.size() - 1); }
+        b.retire_frozen();
+        if (sg->moved_count.fetch_add(1, std::memory_order_acq_rel) + 1 == o->seg_len()) {
+            slot.store(moved_segment(), std::memory_order_release);
+            Epoch::retire(sg);
+            segment_drained(t, o);
+        }
+    }
+
+    void segment_drained(Table* t, Table* o)
+    {
+        if (o->segs_done.fetch_add(1, std::memory_order_acq_rel) + 1 == o->n_segs) {
+            // last one: unlink the (now empty) old table; readers still inside it keep it alive via their guards
+            t->old.store(nullptr, std::memory_order_release);
+            Epoch::retire(o);
+        }
+    }
+
+    void help_migrate(Table* t)
+    {
+        Table* o = t->old.load(std::memory_order_acquire);
+        if (!o) return;
+        for (std::size_t n = 0; n < migrate_batch; ++n) {
+            const std::size_t i = o->claim.fetch_add(1, std::memory_order_relaxed);
+            if (i >= o->capacity()) return;
+            migrate_bucket(t, o, i); // at worst waits for a bucket a writer is copying for its own key
+        }
+    }
 
-    void maybe_rehash()
+    void maybe_grow()
     {
-        if (static_cast<float>(size_.load()) / static_cast<float>(buckets_.size()) < max_load)
+        Table* t = table_.load(std::memory_order_acquire);
+        if (t->old.load(std::memory_order_acquire)) return; // still draining the previous one
+        if (static_cast<float>(size_.load(std::memory_order_relaxed)) / static_cast<float>(t->capacity()) < max_load)
             return;
 
-        std::unique_lock lk(table_mtx_); // exclusive
-        std::size_t new_cap = buckets_.size() * 2;
-        std::vector<Bucket> new_buckets(new_cap);
-
-    #ifdef __EMSCRIPTEN__
-        // Sequential rehash on WebAssembly
-        for (auto const& old_b : buckets_) {
-            old_b.for_each([&](const K& k, const V& v){
-                auto idx = hasher_(k) & (new_cap - 1);
-                new_buckets[idx].put(k, v);
-            });
+        auto* nt = new Table(t->capacity() * 2, t);
+        if (!table_.compare_exchange_strong(t, nt, std::memory_order_acq_rel)) {
+            nt->old.store(nullptr, std::memory_order_relaxed); // lost the race; don't take `t` down with it
+            delete nt;
         }
-    #else
-        oneapi::dpl::for_each(
-            oneapi::dpl::execution::par, // using par because each sub-loop does heap-allocs and atomics, so vectorization isn't beneficial.
-            buckets_.begin(), buckets_.end(),
-            [&](Bucket const& old_b) {
-                old_b.for_each([&](const K& k, const V& v){
-                    new_buckets[hasher_(k) & (new_cap - 1)].put(k, v);
-                });
-            });
-    #endif
-        
-        buckets_.swap(new_buckets);
     }
 };
 
@@ -0,0 +1,125 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace rv {
+
+/*
+Which 8x8 tiles of the 128-by-128 framebuffer changed since the last clear(). One bit
+per tile, a 16-bit mask per tile row, so marking a pixel is a shift and an OR and a
+whole frame's worth of state copies like an integer. for_each_rect() turns the set into
+a few disjoint rectangles for partial texture uploads.
+*/
+class DirtyTiles
+{
+  public:
+    static constexpr int width  = 128;
+    static constexpr int height = 128;
+    static constexpr int tile   = 8;
+    static constexpr int cols   = width / tile;
+    static constexpr int rows   = height / tile;
+    static_assert(cols <= 16, "one tile row must fit a 16-bit mask");
+
+    struct Rect
+    {
+        int x, y, w, h; // pixels, same layout as SDL_Rect
+    };
+
+    /* the pixel at byte offset `offset` (row-major, width bytes per row) */
+    void mark(std::uint32_t offset) noexcept
+    {
+        if (offset < std::uint32_t{ width * height })
+            rows_[offset / (width * tile)] |= static_cast<std::uint16_t>(1u << (offset % width / tile));
+    }
+
+    /* `n` consecutive bytes from `offset`, wrapping across rows as the framebuffer does */
+    void mark_span(std::uint32_t offset, std::uint32_t n) noexcept
+    {
+        const std::uint32_t end = std::min<std::uint32_t>(offset + n, width * height);
+        while (offset < end) {
+            const std::uint32_t row_end = std::min<std::uint32_t>(end, (offset / width + 1) * width);
+            mark_cols(static_cast<int>(offset / width), static_cast<int>(offset % width),
+                      static_cast<int>((row_end - 1) % width));
+            offset = row_end;
+        }
+    }
+
+    void mark_rect(int x, int y, int w, int h) noexcept
+    {
+        const int x0 = std::max(x, 0), x1 = std::min(x + w, width) - 1;
+        const int y0 = std::max(y, 0), y1 = std::min(y + h, height) - 1;
+        if (x0 > x1) return;
+        for (int ty = y0 / tile; y0 <= y1 && ty <= y1 / tile; ++ty) mark_cols(ty * tile, x0, x1);
+    }
+
+    void mark_all() noexcept { rows_.fill(full_row); }
+    void clear() noexcept { rows_.fill(0); }
+
+    [[nodiscard]] bool any() const noexcept
+    {
+        return std::ranges::any_of(rows_, [](std::uint16_t m) { return m != 0; });
+    }
+
+    /* dirty tiles, and the bytes they cover */
+    [[nodiscard]] int count() const noexcept
+    {
+        int n = 0;
+        for (std::uint16_t m : rows_) n += std::popcount(m);
+        return n;
+    }
+    [[nodiscard]] std::size_t bytes() const noexcept { return static_cast<std::size_t>(count()) * tile * tile; }
+
+    /* any dirty tile touching rows [y, y+h)? */
+    [[nodiscard]] bool any_in_rows(int y, int h) const noexcept
+    {
+        for (int ty = std::max(y, 0) / tile; ty < rows && ty * tile < y + h; ++ty)
+            if (rows_[ty]) return true;
+        return false;
+    }
+
+    DirtyTiles& operator|=(const DirtyTiles& o) noexcept
+    {
+        for (int i = 0; i < rows; ++i) rows_[i] |= o.rows_[i];
+        return *this;
+    }
+
+    friend bool operator==(const DirtyTiles&, const DirtyTiles&) = default;
+
+    /*
+    Calls f(Rect) for disjoint rectangles covering exactly the dirty tiles: each run of
+    tiles in a row, extended downwards while the rows below contain the same run.
+    */
+    template <class F>
+    void for_each_rect(F&& f) const
+    {
+        std::array<std::uint16_t, rows> left = rows_;
+        for (int ty = 0; ty < rows; ++ty) {
+            while (left[ty]) {
+                const int           tx0  = std::countr_zero(left[ty]);
+                const int           run  = std::countr_one(static_cast<std::uint16_t>(left[ty] >> tx0));
+                const std::uint16_t mask = static_cast<std::uint16_t>(((1u << run) - 1) << tx0);
+                int ty1 = ty;
+                while (ty1 + 1 < rows && (left[ty1 + 1] & mask) == mask) ++ty1;
+                for (int t = ty; t <= ty1; ++t) left[t] = static_cast<std::uint16_t>(left[t] & ~mask);
+                f(Rect{ tx0 * tile, ty * tile, run * tile, (ty1 - ty + 1) * tile });
+            }
+        }
+    }
+
+  private:
+    static constexpr std::uint16_t full_row = static_cast<std::uint16_t>((1u << cols) - 1);
+
+    std::array<std::uint16_t, rows> rows_{};
+
+    /* pixel row y, columns x0..x1 inclusive */
+    void mark_cols(int y, int x0, int x1) noexcept
+    {
+        const unsigned t0 = static_cast<unsigned>(x0 / tile), t1 = static_cast<unsigned>(x1 / tile);
+        rows_[y / tile] |= static_cast<std::uint16_t>(((2u << t1) - 1) & ~((1u << t0) - 1));
+    }
+};
+
+} // namespace rv
@@ -0,0 +1,196 @@
+#pragma once
+#include "memory_bus.hpp"
+#include "mmio_device.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+namespace rv {
+
+/*
+Memory-mapped DMA controller: byte-granular copies, fills and 2D rectangle blits.
+
+Register map (word offsets from the device base):
+    0x00 SRC         source address
+    0x04 DST         destination address
+    0x08 WIDTH       bytes per row (the length of a 1D transfer)
+    0x0C HEIGHT      rows (0 counts as 1)
+    0x10 SRC_STRIDE  bytes between source rows
+    0x14 DST_STRIDE  bytes between destination rows
+    0x18 FILL        fill byte (low 8 bits)
+    0x1C CTRL        write: bit0 start, bit1 fill instead of copy, bit2 interrupt on completion
+    0x20 STATUS      read: bit0 done, bit1 error (zero width, or width*rows over max_transfer), bit2 interrupt pending; write 1s to clear
+    0x24 COUNT       read: transfers completed
+
+Transfers run to completion inside the CTRL store, so polling STATUS.done right after
+start always succeeds; the bit exists so guest code doesn't depend on that.
+The engine masters `bus`, which should be the bus the CPU sees (normally the L1 cache)
+so transfers stay coherent with cached data. Ranges registered with map_direct()
+(e.g. the framebuffer) are read and written with memcpy/memset instead; a row that
+crosses the edge of one is split there.
+*/
+class DmaDevice : public MmioDevice
+{
+  public:
+    static constexpr std::uint32_t default_base = 0x2000'3000;
+    static constexpr std::uint32_t window_size  = 0x28;
+    static constexpr std::uint64_t max_transfer = 1u << 20;   // bytes per CTRL start; the copy runs inside one guest store
+
+    enum Reg : std::uint32_t {
+        src = 0x00, dst = 0x04, width = 0x08, height = 0x0C,
+        src_stride = 0x10, dst_stride = 0x14, fill = 0x18, ctrl = 0x1C, status = 0x20, count = 0x24
+    };
+    static constexpr std::uint32_t ctrl_start = 1u << 0, ctrl_fill = 1u << 1, ctrl_irq = 1u << 2;
+    static constexpr std::uint32_t status_done = 1u << 0, status_error = 1u << 1, status_irq = 1u << 2;
+
+    explicit DmaDevice(MemoryBus& bus) : bus_{bus} {}
+
+    /*
+    guest range [base, base+size) is backed by contiguous host bytes at `host` (read through the reference);
+    `written(offset, n)`, if set, is told about every transfer into it
+    */
+    void map_direct(std::uint32_t base, std::uint32_t size, std::uint8_t* const& host,
+                    std::function<void(std::uint32_t, std::uint32_t)> written = {})
+    {
+        direct_.push_back({ base, size, &host, std::move(written) });
+    }
+
+    /* called after a transfer that had CTRL.irq set (e.g. to raise an external interrupt) */
+    std::function<void()> on_complete;
+
+    [[nodiscard]] bool          irq_pending() const noexcept { return status_ & status_irq; }
+    [[nodiscard]] std::uint64_t bytes_moved() const noexcept { return bytes_; }
+
+    std::uint32_t read(std::uint32_t offset) override
+    {
+        switch (offset) {
+          case status: return status_;
+          case count:  return count_;
+          case ctrl:   return 0;
+          default:     return offset / 4 < regs_.size() ? regs_[offset / 4] : 0;
+        }
+    }
+
+    void write(std::uint32_t offset, std::uint32_t v) override
+    {
+        switch (offset) {
+          case ctrl:   if (v & ctrl_start) run(v); break;
+          case status: status_ &= ~v;              break;
+          case count:                              break;
+          default:     if (offset / 4 < regs_.size()) regs_[offset / 4] = v;
+        }
+    }
+
+  private:
+    struct Direct
+    {
+        std::uint32_t        base;
+        std::uint32_t        size;
+        std::uint8_t* const* host;
+        std::function<void(std::uint32_t, std::uint32_t)> written;
+    };
+
+    MemoryBus&                   bus_;
+    std::vector<Direct>          direct_;
+    std::array<std::uint32_t, 7> regs_{}; // src .. fill
+    std::uint32_t                status_ = 0;
+    std::uint32_t                count_  = 0;
+    std::uint64_t                bytes_  = 0;
+    std::vector<std::uint8_t>    row_;
+
+    [[nodiscard]] std::uint32_t reg(Reg r) const noexcept { return regs_[r / 4]; }
+
+    /*
+    the longest prefix of [addr, addr+n) that lies inside one direct range (`d` set) or outside
+    all of them, so a row crossing a range boundary is split there instead of taking the word path whole
+    */
+    struct Piece
+    {
+        const Direct* d;
+        std::uint32_t n;
+    };
+    [[nodiscard]] Piece piece(std::uint32_t addr, std::uint32_t n) const noexcept
+    {
+        for (const Direct& d : direct_)
+            if (*d.host && addr - d.base < d.size) return { &d, std::min(n, d.size - (addr - d.base)) };
+        for (const Direct& d : direct_)
+            if (*d.host && d.size && d.base - addr < n) n = d.base - addr; // stop where a direct range begins
+        return { nullptr, n };
+    }
+
+    void gather(std::uint32_t addr, std::uint32_t n)
+    {
+        for (std::uint32_t i = 0; i < n;) {
+            const auto [d, len] = piece(addr + i, n - i);
+            if (d) std::memcpy(row_.data() + i, *d->host + (addr + i - d->base), len);
+            else   gather_bus(addr + i, row_.data() + i, len);
+            i += len;
+        }
+    }
+
+    void scatter(std::uint32_t addr, std::uint32_t n)
+    {
+        for (std::uint32_t i = 0; i < n;) {
+            const auto [d, len] = piece(addr + i, n - i);
+            if (d) {
+                std::memcpy(*d->host + (addr + i - d->base), row_.data() + i, len);
+                if (d->written) d->written(addr + i - d->base, len);
+            } else {
+                scatter_bus(addr + i, row_.data() + i, len);
+            }
+            i += len;
+        }
+    }
+
+    void gather_bus(std::uint32_t addr, std::uint8_t* out, std::uint32_t n)
+    {
+        std::uint32_t w = 0, cur = ~0u;
+        for (std::uint32_t i = 0; i < n; ++i) {
+            const std::uint32_t a = addr + i;
+            if ((a & ~3u) != cur) { cur = a & ~3u; w = bus_.load_word(cur).value_or(0); }
+            out[i] = static_cast<std::uint8_t>(w >> (8 * (a & 3)));
+        }
+    }
+
+    void scatter_bus(std::uint32_t addr, const std::uint8_t* in, std::uint32_t n)
+    {
+        for (std::uint32_t i = 0; i < n;) {
+            const std::uint32_t a = addr + i, base = a & ~3u, lane = a & 3;
+            const std::uint32_t take = std::min<std::uint32_t>(4 - lane, n - i);
+            // whole aligned words are plain stores; partial ones are read-modify-write
+            std::uint32_t w = take == 4 ? 0 : bus_.load_word(base).value_or(0);
+            for (std::uint32_t k = 0; k < take; ++k) {
+                const std::uint32_t sh = 8 * (lane + k);
+                w = (w & ~(0xFFu << sh)) | (std::uint32_t{in[i + k]} << sh);
+            }
+            bus_.store_word(base, w);
+            i += take;
+        }
+    }
+
+    void run(std::uint32_t c)
+    {
+        status_ &= ~(status_done | status_error);
+        const std::uint32_t wd = reg(width), rows = std::max<std::uint32_t>(reg(height), 1);
+        if (wd == 0 || std::uint64_t{wd} * rows > max_transfer) { status_ |= status_error | status_done; return; }
+
+        row_.resize(wd);
+        if (c & ctrl_fill) std::memset(row_.data(), static_cast<int>(reg(fill) & 0xFF), wd);
+        for (std::uint32_t r = 0; r < rows; ++r) {
+            if (!(c & ctrl_fill)) gather(reg(src) + r * reg(src_stride), wd);
+            scatter(reg(dst) + r * reg(dst_stride), wd);
+        }
+
+        bytes_ += std::uint64_t{wd} * rows;
+        ++count_;
+        status_ |= status_done;
+        if (c & ctrl_irq) {
+            status_ |= status_irq;
+            if (on_complete) on_complete();
+        }
+    }
+};
+
+} // namespace rv
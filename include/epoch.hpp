@@ -0,0 +1,172 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace rv {
+
+namespace detail {
+
+struct EpochRetired
+{
+    void*          ptr;
+    void         (*deleter)(void*);
+    std::uint64_t  epoch;
+};
+
+struct alignas(64) EpochSlot
+{
+    std::atomic<std::uint64_t> epoch{~std::uint64_t{0}}; // idle
+    std::atomic<bool>          taken{false};
+};
+
+} // namespace detail
+
+/*
+Process-wide epoch-based reclamation (Fraser).
+
+Readers pin the global epoch for the duration of a traversal with an Epoch::Guard.
+Writers unlink an object, then retire() it; it is freed once every pinned thread has
+been seen in the current epoch twice over, so no reader can still hold a pointer to it.
+Pinning is one store + fence on the thread's own cache line; nothing shared is written.
+*/
+class Epoch
+{
+  public:
+    static constexpr std::size_t max_threads = 256;
+
+    class Guard
+    {
+      public:
+        Guard() { Epoch::enter(); }
+        ~Guard() { Epoch::leave(); }
+        Guard(const Guard&)            = delete;
+        Guard& operator=(const Guard&) = delete;
+    };
+
+    [[nodiscard]] static Guard pin() { return {}; }
+
+    /* free `p` with `deleter` once no reader can reach it */
+    static void retire(void* p, void (*deleter)(void*))
+    {
+        ThreadRec& t = rec();
+        t.limbo.push_back({ p, deleter, global_.load(std::memory_order_acquire) });
+        if (t.limbo.size() >= collect_every) collect(t);
+    }
+
+    template <class T>
+    static void retire(T* p)
+    {
+        retire(static_cast<void*>(p), [](void* q) { delete static_cast<T*>(q); });
+    }
+
+  private:
+    static constexpr std::uint64_t idle          = ~std::uint64_t{0};
+    static constexpr std::size_t   collect_every = 64;
+
+    using Retired = detail::EpochRetired;
+    using Slot    = detail::EpochSlot;
+
+    /* per-thread state: its slot, guard nesting depth and not-yet-safe garbage */
+    struct ThreadRec
+    {
+        std::size_t          slot  = max_threads;
+        unsigned             depth = 0;
+        std::vector<Retired> limbo;
+
+        ~ThreadRec()
+        {
+            if (!limbo.empty()) {
+                std::scoped_lock lk(orphans().mtx);
+                orphans().items.insert(orphans().items.end(), limbo.begin(), limbo.end());
+            }
+            if (slot < max_threads) slots_[slot].taken.store(false, std::memory_order_release);
+        }
+    };
+
+    /* garbage left behind by exited threads; whatever is left at exit is freed then */
+    struct Orphans
+    {
+        std::mutex           mtx;
+        std::vector<Retired> items;
+        ~Orphans() { for (auto& r : items) r.deleter(r.ptr); }
+    };
+
+    inline static std::atomic<std::uint64_t>  global_{0};
+    inline static std::array<Slot, max_threads> slots_{};
+
+    static Orphans& orphans()
+    {
+        static Orphans o;
+        return o;
+    }
+
+    static ThreadRec& rec()
+    {
+        thread_local ThreadRec t;
+        if (t.slot == max_threads) {
+            (void)orphans(); // constructed before any ThreadRec dies, so it outlives them all
+            for (std::size_t i = 0; i < max_threads; ++i) {
+                bool expected = false;
+                if (slots_[i].taken.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+                    t.slot = i;
+                    break;
+                }
+            }
+            if (t.slot == max_threads) throw std::runtime_error("Epoch: too many threads");
+        }
+        return t;
+    }
+
+    static void enter()
+    {
+        ThreadRec& t = rec();
+        if (t.depth++ == 0) {
+            slots_[t.slot].epoch.store(global_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst); // announce before reading shared pointers
+        }
+    }
+
+    static void leave() noexcept
+    {
+        ThreadRec& t = rec();
+        if (--t.depth == 0) slots_[t.slot].epoch.store(idle, std::memory_order_release);
+    }
+
+    /* advance the epoch if every pinned thread has caught up with it */
+    static void try_advance() noexcept
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::uint64_t e = global_.load(std::memory_order_relaxed);
+        for (auto const& s : slots_) {
+            if (!s.taken.load(std::memory_order_relaxed)) continue;
+            const std::uint64_t se = s.epoch.load(std::memory_order_acquire);
+            if (se != idle && se != e) return;
+        }
+        global_.compare_exchange_strong(e, e + 1, std::memory_order_acq_rel);
+    }
+
+    static void free_safe(std::vector<Retired>& items)
+    {
+        const std::uint64_t e = global_.load(std::memory_order_acquire);
+        std::erase_if(items, [e](const Retired& r) {
+            if (r.epoch + 2 > e) return false;
+            r.deleter(r.ptr);
+            return true;
+        });
+    }
+
+    static void collect(ThreadRec& t)
+    {
+        try_advance();
+        free_safe(t.limbo);
+        if (std::unique_lock lk(orphans().mtx, std::try_to_lock); lk && !orphans().items.empty())
+            free_safe(orphans().items);
+    }
+};
+
+} // namespace rv
@@ -0,0 +1,269 @@
+#pragma once
+#include "mem_trace.hpp"       // zigzag helpers
+#include "riscv_types.hpp"
+#include "rv_disassembler.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace rv {
+
+/*
+One retired instruction as the CPU saw it. `value` is rd after the instruction, or the
+rs2 being stored for a store (0 when neither applies, see traced_reg()). `addr` is the
+effective address of a load or store, no_addr otherwise.
+*/
+struct RetiredInstr
+{
+    static constexpr std::uint32_t no_addr = 0xFFFF'FFFF;
+
+    std::uint32_t pc;
+    std::uint32_t raw;
+    std::uint32_t value;
+    std::uint32_t addr;
+
+    friend bool operator==(const RetiredInstr&, const RetiredInstr&) = default;
+};
+
+/* the register whose value a trace records for `raw`: rd if it writes one (not x0), rs2 for stores */
+[[nodiscard]] constexpr std::optional<std::uint8_t> traced_reg(std::uint32_t raw) noexcept
+{
+    const auto rd = static_cast<std::uint8_t>((raw >> 7) & 0x1F);
+    switch (static_cast<Opcode>(raw & 0x7F)) {
+      case Opcode::OP: case Opcode::OP_IMM: case Opcode::LOAD: case Opcode::JALR:
+      case Opcode::LUI: case Opcode::AUIPC: case Opcode::JAL:
+        return rd ? std::optional{ rd } : std::nullopt;
+      case Opcode::STORE:
+        return static_cast<std::uint8_t>((raw >> 20) & 0x1F);
+      case Opcode::SYSTEM: // CSR reads write rd; MRET/WFI don't
+        return rd && ((raw >> 12) & 0x7) ? std::optional{ rd } : std::nullopt;
+      default:
+        return std::nullopt;
+    }
+}
+
+[[nodiscard]] constexpr bool accesses_memory(std::uint32_t raw) noexcept
+{
+    const auto opc = static_cast<Opcode>(raw & 0x7F);
+    return opc == Opcode::LOAD || opc == Opcode::STORE;
+}
+
+/*
+Flight recorder: the last `capacity` retired instructions (rounded up to a power of two)
+in a ring, cheap enough to leave on. Attach it with RiscV::attach_flight_recorder() and
+dump() it when step() throws or whenever the history is wanted.
+*/
+class FlightRecorder
+{
+  public:
+    explicit FlightRecorder(std::size_t capacity = 4096)
+        : ring_(std::bit_ceil(std::max<std::size_t>(capacity, 1))), mask_{ ring_.size() - 1 } {}
+
+    void record(const RetiredInstr& r) noexcept { ring_[total_++ & mask_] = r; }
+
+    [[nodiscard]] std::size_t   capacity() const noexcept { return ring_.size(); }
+    /* instructions recorded since construction or clear(), including overwritten ones */
+    [[nodiscard]] std::uint64_t total() const noexcept { return total_; }
+    [[nodiscard]] std::size_t   size() const noexcept { return static_cast<std::size_t>(std::min<std::uint64_t>(total_, ring_.size())); }
+
+    /* the last min(n, size()) instructions, oldest first */
+    [[nodiscard]] std::vector<RetiredInstr> last(std::size_t n) const
+    {
+        n = std::min(n, size());
+        std::vector<RetiredInstr> out;
+        out.reserve(n);
+        for (std::uint64_t i = total_ - n; i < total_; ++i) out.push_back(ring_[i & mask_]);
+        return out;
+    }
+    [[nodiscard]] std::vector<RetiredInstr> snapshot() const { return last(size()); }
+
+    void clear() noexcept { total_ = 0; }
+
+    /* one line per instruction: retire index, pc, word, disassembly, value and address */
+    void dump(std::ostream& os, std::size_t n = ~std::size_t{ 0 }) const
+    {
+        const auto hist = last(n);
+        std::uint64_t idx = total_ - hist.size();
+        os << std::format("last {} of {} retired instructions:\n", hist.size(), total_);
+        for (const auto& r : hist) {
+            std::string text = disassemble(r.raw);
+            if (auto reg = traced_reg(r.raw)) text = std::format("{:<26}{}=0x{:08x}", text, reg_names[*reg], r.value);
+            if (r.addr != RetiredInstr::no_addr) text += std::format("  @0x{:08x}", r.addr);
+            os << std::format("{:>12}  {:08x}  {:08x}  {}\n", idx++, r.pc, r.raw, text);
+        }
+    }
+
+  private:
+    std::vector<RetiredInstr> ring_;
+    std::size_t               mask_;
+    std::uint64_t             total_ = 0;
+};
+
+/*
+Streaming execution trace: every retired instruction, for offline analysis.
+
+File layout:
+    header  : "RVXT" | u16 version | u16 reserved | u64 record count   (little endian)
+    records : pc delta | raw word | [value] | [addr delta]
+The pc delta is a zigzag varint against the fall-through pc of the previous record, so
+straight-line code costs one byte. The raw word is 4 bytes little endian; from it the
+reader knows whether a value (traced_reg) and an address (loads/stores, zigzag varint
+against the previous address) follow. Values are plain LEB128 varints.
+*/
+namespace detail {
+
+inline constexpr std::array<char, 4> exec_trace_magic{ 'R', 'V', 'X', 'T' };
+inline constexpr std::uint16_t       exec_trace_version = 1;
+
+struct ExecTraceState
+{
+    std::uint32_t next_pc   = 0;
+    std::uint32_t last_addr = 0;
+};
+
+} // namespace detail
+
+class ExecTraceWriter
+{
+  public:
+    explicit ExecTraceWriter(const std::string& path)
+        : out_{path, std::ios::binary | std::ios::trunc}
+    {
+        if (!out_) throw std::runtime_error(std::format("cannot open trace '{}'", path));
+        buf_.reserve(buffer_bytes + 32);
+        std::array<char, detail::trace_header_size> hdr{};
+        std::memcpy(hdr.data(), detail::exec_trace_magic.data(), 4);
+        hdr[4] = static_cast<char>(detail::exec_trace_version & 0xFF);
+        hdr[5] = static_cast<char>(detail::exec_trace_version >> 8);
+        out_.write(hdr.data(), hdr.size());
+    }
+
+    ~ExecTraceWriter()
+    {
+        try { close(); } catch (...) {}
+    }
+
+    ExecTraceWriter(const ExecTraceWriter&)            = delete;
+    ExecTraceWriter& operator=(const ExecTraceWriter&) = delete;
+
+    void write(const RetiredInstr& r)
+    {
+        put_varint(detail::zigzag(static_cast<std::int32_t>(r.pc - st_.next_pc)));
+        st_.next_pc = r.pc + 4;
+        for (unsigned i = 0; i < 4; ++i) buf_.push_back(static_cast<std::uint8_t>(r.raw >> (8 * i)));
+        if (traced_reg(r.raw)) put_varint(r.value);
+        if (accesses_memory(r.raw)) {
+            put_varint(detail::zigzag(static_cast<std::int32_t>(r.addr - st_.last_addr)));
+            st_.last_addr = r.addr;
+        }
+        ++count_;
+        if (buf_.size() >= buffer_bytes) flush();
+    }
+
+    [[nodiscard]] std::uint64_t count() const noexcept { return count_; }
+    [[nodiscard]] std::uint64_t bytes() const noexcept { return written_ + buf_.size(); }
+
+    void close()
+    {
+        if (!out_.is_open()) return;
+        flush();
+        std::array<char, 8> n{};
+        for (std::size_t i = 0; i < 8; ++i) n[i] = static_cast<char>((count_ >> (8 * i)) & 0xFF);
+        out_.seekp(8);
+        out_.write(n.data(), n.size());
+        out_.close();
+        if (out_.fail()) throw std::runtime_error("trace write failed");
+    }
+
+  private:
+    static constexpr std::size_t buffer_bytes = 1 << 16;
+
+    std::ofstream              out_;
+    std::vector<std::uint8_t>  buf_;
+    detail::ExecTraceState     st_;
+    std::uint64_t              count_   = 0;
+    std::uint64_t              written_ = detail::trace_header_size;
+
+    void put_varint(std::uint32_t v)
+    {
+        while (v >= 0x80) { buf_.push_back(static_cast<std::uint8_t>(v | 0x80)); v >>= 7; }
+        buf_.push_back(static_cast<std::uint8_t>(v));
+    }
+
+    void flush()
+    {
+        out_.write(reinterpret_cast<const char*>(buf_.data()), static_cast<std::streamsize>(buf_.size()));
+        written_ += buf_.size();
+        buf_.clear();
+    }
+};
+
+/* Decodes an execution trace held in memory (e.g. a MappedFile). */
+class ExecTraceReader
+{
+  public:
+    explicit ExecTraceReader(std::span<const std::byte> bytes)
+        : bytes_{bytes}
+    {
+        if (bytes.size() < detail::trace_header_size ||
+            std::memcmp(bytes.data(), detail::exec_trace_magic.data(), 4) != 0)
+            throw std::runtime_error("not an RVXT trace");
+        const auto version = static_cast<std::uint16_t>(byte(4) | (byte(5) << 8));
+        if (version != detail::exec_trace_version)
+            throw std::runtime_error(std::format("unsupported trace version {}", version));
+        for (std::size_t i = 0; i < 8; ++i) count_ |= std::uint64_t{byte(8 + i)} << (8 * i);
+        pos_ = detail::trace_header_size;
+    }
+
+    [[nodiscard]] std::uint64_t count() const noexcept { return count_; }
+
+    [[nodiscard]] std::optional<RetiredInstr> next()
+    {
+        if (pos_ >= bytes_.size()) return std::nullopt;
+
+        RetiredInstr r{ 0, 0, 0, RetiredInstr::no_addr };
+        r.pc = st_.next_pc + static_cast<std::uint32_t>(detail::unzigzag(get_varint()));
+        st_.next_pc = r.pc + 4;
+        if (pos_ + 4 > bytes_.size()) throw std::runtime_error("truncated trace record");
+        for (unsigned i = 0; i < 4; ++i) r.raw |= byte(pos_++) << (8 * i);
+        if (traced_reg(r.raw)) r.value = get_varint();
+        if (accesses_memory(r.raw)) {
+            st_.last_addr += static_cast<std::uint32_t>(detail::unzigzag(get_varint()));
+            r.addr = st_.last_addr;
+        }
+        return r;
+    }
+
+  private:
+    std::span<const std::byte> bytes_;
+    std::size_t                pos_   = 0;
+    std::uint64_t              count_ = 0;
+    detail::ExecTraceState     st_;
+
+    [[nodiscard]] std::uint32_t byte(std::size_t i) const noexcept
+    { return std::to_integer<std::uint32_t>(bytes_[i]); }
+
+    std::uint32_t get_varint()
+    {
+        std::uint32_t v = 0;
+        for (unsigned shift = 0; pos_ < bytes_.size() && shift < 35; shift += 7) {
+            const std::uint32_t b = byte(pos_++);
+            v |= (b & 0x7F) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        throw std::runtime_error("truncated trace record");
+    }
+};
+
+} // namespace rv
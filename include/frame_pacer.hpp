@@ -0,0 +1,90 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace rv {
+
+/*
+Per-frame instruction budget for running the guest in step with the display.
+
+The target is `clock_hz` guest instructions per second (one instruction per emulated
+cycle), i.e. clock_hz / fps per frame. After each frame the pacer updates a smoothed host
+cost per instruction and sizes the next budget so the CPU takes at most `cpu_share` of
+the frame period, leaving the rest for rendering and the browser. A host too slow for the
+target runs the emulated clock slow rather than missing frames; clock_ratio() says by how
+much.
+*/
+class FramePacer
+{
+  public:
+    struct Config
+    {
+        double        clock_hz   = 20e6;  // emulated instructions per second
+        double        fps        = 60.0;  // display rate; the frame deadline is 1/fps
+        double        cpu_share  = 0.75;  // most of a frame the CPU may use
+        std::uint64_t min_budget = 1000;  // floor, so a slow frame can't stall the guest
+    };
+
+    explicit FramePacer(Config c) noexcept
+        : cfg_{ c },
+          target_{ std::max<std::uint64_t>(1, static_cast<std::uint64_t>(c.clock_hz / c.fps)) },
+          budget_{ std::max(c.min_budget, target_ / 8) } {} // modest first frame, before anything is measured
+
+    /* instructions to run this frame */
+    [[nodiscard]] std::uint64_t budget() const noexcept { return budget_; }
+    /* instructions per frame at the configured clock */
+    [[nodiscard]] std::uint64_t target() const noexcept { return target_; }
+    [[nodiscard]] double        period() const noexcept { return 1.0 / cfg_.fps; }
+
+    /*
+    Report a finished frame: `executed` instructions took `cpu_seconds`; the whole frame,
+    from its start to the next one's, took `frame_seconds`. `idle_cycles` passed in WFI
+    without host work: they count towards the clock but not the cost per instruction.
+    */
+    void end_frame(std::uint64_t executed, double cpu_seconds, double frame_seconds, std::uint64_t idle_cycles = 0) noexcept
+    {
+        if (executed && cpu_seconds > 0) {
+            const double s = cpu_seconds / static_cast<double>(executed);
+            s_per_instr_ = s_per_instr_ ? s_per_instr_ + alpha * (s - s_per_instr_) : s;
+        }
+        if (frame_seconds > 0) frame_s_ = frame_s_ ? frame_s_ + alpha * (frame_seconds - frame_s_) : frame_seconds;
+        cpu_s_    = cpu_s_ + alpha * (cpu_seconds - cpu_s_);
+        executed_ = executed;
+        idle_     = idle_cycles;
+
+        // an overrun (CPU alone past its share) cuts straight to what would have fit
+        const double allowed = cfg_.cpu_share * period();
+        const double fit     = s_per_instr_ ? allowed / s_per_instr_ : static_cast<double>(target_);
+        double next          = std::min(fit, static_cast<double>(target_));
+        if (cpu_seconds > allowed && executed)
+            next = std::min(next, static_cast<double>(executed) * allowed / cpu_seconds);
+        budget_ = std::max(cfg_.min_budget, static_cast<std::uint64_t>(std::floor(next)));
+    }
+
+    /* host speed while running guest code (million instructions per second) */
+    [[nodiscard]] double mips() const noexcept { return s_per_instr_ ? 1e-6 / s_per_instr_ : 0.0; }
+    /* smoothed frame time and CPU time per frame (ms) */
+    [[nodiscard]] double frame_ms() const noexcept { return frame_s_ * 1e3; }
+    [[nodiscard]] double cpu_ms()   const noexcept { return cpu_s_ * 1e3; }
+    /* emulated clock actually delivered, relative to the target (1.0 = full speed) */
+    [[nodiscard]] double clock_ratio() const noexcept
+    { return static_cast<double>(executed_ + idle_) / static_cast<double>(target_); }
+    /* share of the last frame's cycles the guest spent asleep in WFI */
+    [[nodiscard]] double idle_ratio() const noexcept
+    { return executed_ + idle_ ? static_cast<double>(idle_) / static_cast<double>(executed_ + idle_) : 0.0; }
+
+  private:
+    static constexpr double alpha = 0.2; // EWMA weight of the newest frame
+
+    Config        cfg_;
+    std::uint64_t target_;
+    std::uint64_t budget_;
+    std::uint64_t executed_    = 0;
+    std::uint64_t idle_        = 0;
+    double        s_per_instr_ = 0;
+    double        frame_s_     = 0;
+    double        cpu_s_       = 0;
+};
+
+} // namespace rv
@@ -1,29 +1,122 @@
 #pragma once
-#include "linked_list.hpp"
 #include "memory_bus.hpp"
-#include <vector>
-#include <optional>
+#include <bit>
+#include <cstdint>
+#include <cstring>
 #include <functional>
-#include <ranges>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define RV_SWISS_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define RV_SWISS_NEON 1
+#endif
 
 namespace rv {
 
+namespace swiss {
+
+/*
+Control bytes: full slots hold the low 7 bits of their key's hash (0..127); the two
+free states have the sign bit set, so "empty or deleted" is one movemask.
+*/
+using ctrl_t = std::int8_t;
+inline constexpr ctrl_t empty   = -128;
+inline constexpr ctrl_t deleted = -2;
+inline constexpr std::size_t group_width = 16;
+
+/* one bit (SSE2, scalar) or one nibble (NEON) per slot of a group */
+struct BitMask
+{
+#if RV_SWISS_NEON
+    static constexpr int shift = 2;
+#else
+    static constexpr int shift = 0;
+#endif
+    std::uint64_t bits;
+
+    explicit operator bool() const noexcept { return bits != 0; }
+    [[nodiscard]] unsigned lowest() const noexcept { return static_cast<unsigned>(std::countr_zero(bits)) >> shift; }
+    void pop() noexcept { bits &= bits - 1; }
+};
+
+/* 16 control bytes compared in parallel */
+struct Group
+{
+#if RV_SWISS_SSE2
+    __m128i v;
+    explicit Group(const ctrl_t* p) noexcept : v{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)) } {}
+
+    [[nodiscard]] BitMask match(ctrl_t h) const noexcept
+    {
+        return { static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h), v))) };
+    }
+    [[nodiscard]] BitMask match_free() const noexcept
+    {
+        return { static_cast<std::uint32_t>(_mm_movemask_epi8(v)) };
+    }
+#elif RV_SWISS_NEON
+    int8x16_t v;
+    explicit Group(const ctrl_t* p) noexcept : v{ vld1q_s8(p) } {}
+
+    static BitMask to_mask(uint8x16_t m) noexcept
+    {
+        const uint8x8_t nib = vshrn_n_u16(vreinterpretq_u16_u8(m), 4);
+        return { vget_lane_u64(vreinterpret_u64_u8(nib), 0) & 0x8888'8888'8888'8888ull };
+    }
+    [[nodiscard]] BitMask match(ctrl_t h) const noexcept { return to_mask(vceqq_s8(vdupq_n_s8(h), v)); }
+    [[nodiscard]] BitMask match_free() const noexcept { return to_mask(vcltq_s8(v, vdupq_n_s8(0))); }
+#else
+    ctrl_t b[group_width];
+    explicit Group(const ctrl_t* p) noexcept { std::memcpy(b, p, group_width); }
+
+    [[nodiscard]] BitMask match(ctrl_t h) const noexcept
+    {
+        std::uint64_t m = 0;
+        for (std::size_t i = 0; i < group_width; ++i) m |= std::uint64_t{b[i] == h} << i;
+        return { m };
+    }
+    [[nodiscard]] BitMask match_free() const noexcept
+    {
+        std::uint64_t m = 0;
+        for (std::size_t i = 0; i < group_width; ++i) m |= std::uint64_t{b[i] < 0} << i;
+        return { m };
+    }
+#endif
+    [[nodiscard]] BitMask match_empty() const noexcept { return match(empty); }
+};
+
+} // namespace swiss
+
 /*
-Open-addressing hash table (linear probing).
+Open-addressing hash table, Swiss-table layout.
+
+A control byte per slot (7-bit hash fragment, or empty/deleted) lives in its own array,
+separate from the key and value arrays, and probing tests 16 control bytes per step with
+SSE2/NEON (scalar fallback elsewhere): the keys themselves are only touched on a fragment
+match, ~1/128 of non-matching slots. Groups are probed triangularly, which visits every
+group of a power-of-two table. erase() leaves a tombstone; tombstones are dropped when
+the table next rehashes, which happens in place (same capacity) when they are what
+filled it.
 */
 template < typename K, typename V, typename Hash = std::hash<K>, typename KeyEq = std::equal_to<K>>
 class HashTable : public MemoryBus
 {
-    enum class BucketState : std::uint8_t { empty, full, tomb };
-    struct Bucket {
-        K            key;
-        V            val;
-        BucketState  st{BucketState::empty};
-    };
+    using ctrl_t = swiss::ctrl_t;
+    static constexpr std::size_t group_width = swiss::group_width;
 
   public:
-    explicit HashTable(std::size_t cap = 64)
-        : buckets_(cap) {}
+    explicit HashTable(std::size_t cap = 64) { allocate(capacity_for(cap)); }
+
+    ~HashTable() override { release(); }
+
+    HashTable(const HashTable&)            = delete;
+    HashTable& operator=(const HashTable&) = delete;
 
     /*
     MemoryBus interface; drive by key = address.
@@ -43,55 +136,178 @@ class HashTable : public MemoryBus
     */
     [[nodiscard]] std::optional<V> get(const K& key) const
     {
-        auto idx = probe(key);
-        if (buckets_[idx].st == BucketState::full) return buckets_[idx].val;
-        return std::nullopt;
+        const std::size_t i = find(key);
+        if (i == npos) return std::nullopt;
+        return vals_[i];
     }
 
-    bool put(const K& key, const V& val)
+    /* insert or assign; returns true if the key was already there */
+    template <typename KK, typename VV>
+    bool put(KK&& key, VV&& val)
     {
-        maybe_rehash();
-        auto idx = probe(key);
-        bool replaced = buckets_[idx].st == BucketState::full;
-        buckets_[idx] = Bucket{key, val, BucketState::full};
-        if (!replaced) ++size_;
-        return replaced;
+        const std::size_t h = hash(key);
+        if (const std::size_t i = find(key, h); i != npos) {
+            vals_[i] = std::forward<VV>(val);
+            return true;
+        }
+        if (growth_left_ == 0) rehash_for_insert();
+        const std::size_t i = first_free(h);
+        if (ctrl_[i] == swiss::empty) --growth_left_;
+        else                          --tombstones_; // reusing a deleted slot costs no growth
+        set_ctrl(i, h2(h));
+        std::construct_at(keys_ + i, std::forward<KK>(key));
+        std::construct_at(vals_ + i, std::forward<VV>(val));
+        ++size_;
+        return false;
+    }
+
+    /* returns true if the key was there */
+    bool erase(const K& key)
+    {
+        const std::size_t i = find(key);
+        if (i == npos) return false;
+        std::destroy_at(keys_ + i);
+        std::destroy_at(vals_ + i);
+        set_ctrl(i, swiss::deleted); // probe chains through this slot must keep going
+        --size_;
+        ++tombstones_;
+        return true;
+    }
+
+    void clear() noexcept
+    {
+        destroy_all();
+        std::memset(ctrl_, static_cast<unsigned char>(swiss::empty), cap_ + group_width - 1);
+        size_ = tombstones_ = 0;
+        growth_left_ = max_fill(cap_);
     }
 
     [[nodiscard]] std::size_t size() const noexcept { return size_; }
+    [[nodiscard]] std::size_t capacity() const noexcept { return cap_; }
+    [[nodiscard]] std::size_t tombstones() const noexcept { return tombstones_; }
+    [[nodiscard]] double load_factor() const noexcept { return static_cast<double>(size_) / static_cast<double>(cap_); }
 
   private:
-    std::vector<Bucket> buckets_;
-    std::size_t         size_  = 0;
-    Hash                hasher_;
-    KeyEq               eq_;
+    static constexpr std::size_t npos = ~std::size_t{0};
+
+    ctrl_t*     ctrl_ = nullptr; // cap_ + group_width - 1 bytes: the tail mirrors the first slots
+    K*          keys_ = nullptr;
+    V*          vals_ = nullptr;
+    std::size_t cap_  = 0;
+    std::size_t size_ = 0;
+    std::size_t tombstones_  = 0;
+    std::size_t growth_left_ = 0; // inserts into empty slots left before a rehash
+    [[no_unique_address]] Hash  hasher_;
+    [[no_unique_address]] KeyEq eq_;
 
-    static constexpr float max_load = 0.7f;
+    /* fill to 15/16: group probing keeps chains short well past what linear probing tolerates */
+    static constexpr std::size_t max_fill(std::size_t cap) noexcept { return cap - cap / 16; }
 
-    inline void maybe_rehash()
+    static std::size_t capacity_for(std::size_t n) noexcept
     {
-        constexpr float max_load = 0.75f;
-        if (static_cast<float>(size_) / static_cast<float>(buckets_.size()) < max_load) {
-            return; // no need to rehash
+        return std::bit_ceil(n < group_width ? group_width : n);
+    }
+
+    /* std::hash on integers is the identity; mix so both the 7-bit fragment and the slot bits are usable */
+    [[nodiscard]] std::size_t hash(const K& key) const noexcept
+    {
+        std::uint64_t x = static_cast<std::uint64_t>(hasher_(key));
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdull;
+        x ^= x >> 33;
+        return static_cast<std::size_t>(x);
+    }
+    static ctrl_t      h2(std::size_t h) noexcept { return static_cast<ctrl_t>(h & 0x7F); }
+    static std::size_t h1(std::size_t h) noexcept { return h >> 7; }
+
+    void set_ctrl(std::size_t i, ctrl_t c) noexcept
+    {
+        ctrl_[i] = c;
+        if (i < group_width - 1) ctrl_[cap_ + i] = c; // mirror, so a group load never wraps
+    }
+
+    [[nodiscard]] std::size_t find(const K& key) const noexcept { return find(key, hash(key)); }
+
+    [[nodiscard]] std::size_t find(const K& key, std::size_t h) const noexcept
+    {
+        const std::size_t mask = cap_ - 1;
+        const ctrl_t frag = h2(h);
+        std::size_t pos = h1(h) & mask;
+        for (std::size_t step = group_width;; pos = (pos + step) & mask, step += group_width) {
+            const swiss::Group g{ ctrl_ + pos };
+            for (auto m = g.match(frag); m; m.pop()) {
+                const std::size_t i = (pos + m.lowest()) & mask;
+                if (eq_(keys_[i], key)) [[likely]] return i;
+            }
+            if (g.match_empty()) return npos;
         }
+    }
 
-        std::vector<Bucket> old = std::move(buckets_);
-        buckets_.assign(old.size()*2, {});
-        size_ = 0;
+    /* first empty or deleted slot on `h`'s probe sequence */
+    [[nodiscard]] std::size_t first_free(std::size_t h) const noexcept
+    {
+        const std::size_t mask = cap_ - 1;
+        std::size_t pos = h1(h) & mask;
+        for (std::size_t step = group_width;; pos = (pos + step) & mask, step += group_width)
+            if (auto m = swiss::Group{ ctrl_ + pos }.match_free()) return (pos + m.lowest()) & mask;
+    }
 
-        for (auto& b : old)
-            if (b.st == BucketState::full) put(std::move(b.key), std::move(b.val));
+    void allocate(std::size_t cap)
+    {
+        cap_  = cap;
+        ctrl_ = new ctrl_t[cap + group_width - 1];
+        std::memset(ctrl_, static_cast<unsigned char>(swiss::empty), cap + group_width - 1);
+        keys_ = std::allocator<K>{}.allocate(cap);
+        vals_ = std::allocator<V>{}.allocate(cap);
+        growth_left_ = max_fill(cap);
     }
 
-    std::size_t probe(const K& key) const
+    void destroy_all() noexcept
     {
-        std::size_t mask = buckets_.size() - 1;
-        std::size_t i    = hasher_(key) & mask;
+        if constexpr (!std::is_trivially_destructible_v<K> || !std::is_trivially_destructible_v<V>)
+            for (std::size_t i = 0; i < cap_; ++i)
+                if (ctrl_[i] >= 0) { std::destroy_at(keys_ + i); std::destroy_at(vals_ + i); }
+    }
 
-        while (buckets_[i].st != BucketState::empty && (buckets_[i].st == BucketState::tomb || !eq_(buckets_[i].key, key))) {
-            i = (i + 1) & mask;
+    void release() noexcept
+    {
+        if (!ctrl_) return;
+        destroy_all();
+        std::allocator<K>{}.deallocate(keys_, cap_);
+        std::allocator<V>{}.deallocate(vals_, cap_);
+        delete[] ctrl_;
+        ctrl_ = nullptr;
+    }
+
+    /*
+    out of empty slots: grow, or if tombstones are what used them up, rebuild at the same size.
+    Growing once live entries pass 7/8 of the limit keeps in-place rebuilds from coming back too often.
+    */
+    void rehash_for_insert()
+    {
+        const std::size_t cap = size_ + 1 > max_fill(cap_) / 8 * 7 ? cap_ * 2 : cap_;
+        ctrl_t* const old_ctrl = ctrl_;
+        K* const      old_keys = keys_;
+        V* const      old_vals = vals_;
+        const std::size_t old_cap = cap_;
+
+        allocate(cap);
+        for (std::size_t i = 0; i < old_cap; ++i) {
+            if (old_ctrl[i] < 0) continue;
+            const std::size_t h = hash(old_keys[i]);
+            const std::size_t j = first_free(h); // no duplicates and no tombstones: skip the key compare
+            set_ctrl(j, h2(h));
+            std::construct_at(keys_ + j, std::move(old_keys[i]));
+            std::construct_at(vals_ + j, std::move(old_vals[i]));
+            std::destroy_at(old_keys + i);
+            std::destroy_at(old_vals + i);
         }
-        return i;
+        growth_left_ -= size_;
+        tombstones_ = 0;
+
+        std::allocator<K>{}.deallocate(old_keys, old_cap);
+        std::allocator<V>{}.deallocate(old_vals, old_cap);
+        delete[] old_ctrl;
     }
 };
 
@@ -0,0 +1,66 @@
+#pragma once
+#include "mmio_device.hpp"
+#include <cstdint>
+#include <functional>
+
+namespace rv {
+
+/*
+External interrupt controller: latches host-side events into one level-triggered line
+(the CPU's MEIP).
+
+Register map (word offsets from the device base):
+    0x00 PENDING   read: latched sources; write 1s to acknowledge
+    0x04 ENABLE    read/write: sources that drive the line
+
+The line is high while PENDING & ENABLE is non-zero. Sources are raised by the host
+(raise()), e.g. the frontend at each vsync and when button input changes, or the DMA
+engine's on_complete.
+*/
+class IrqController : public MmioDevice
+{
+  public:
+    static constexpr std::uint32_t default_base = 0x2000'5000;
+    static constexpr std::uint32_t window_size  = 0x08;
+
+    enum Reg : std::uint32_t { pending = 0x00, enable = 0x04 };
+    enum Source : std::uint32_t { vsync = 1u << 0, gpio = 1u << 1, dma = 1u << 2 };
+
+    /* called with the new level whenever the line changes */
+    std::function<void(bool)> on_line;
+
+    void raise(std::uint32_t sources)
+    {
+        pending_ |= sources;
+        update();
+    }
+
+    [[nodiscard]] bool line() const noexcept { return line_; }
+
+    std::uint32_t read(std::uint32_t offset) override
+    {
+        return offset == pending ? pending_ : offset == enable ? enable_ : 0;
+    }
+
+    void write(std::uint32_t offset, std::uint32_t v) override
+    {
+        if (offset == pending) pending_ &= ~v;
+        else if (offset == enable) enable_ = v;
+        update();
+    }
+
+  private:
+    std::uint32_t pending_ = 0;
+    std::uint32_t enable_  = 0;
+    bool          line_    = false;
+
+    void update()
+    {
+        const bool level = (pending_ & enable_) != 0;
+        if (level == line_) return;
+        line_ = level;
+        if (on_line) on_line(level);
+    }
+};
+
+} // namespace rv
@@ -1,89 +1,251 @@
 #pragma once
+#include "epoch.hpp"
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <optional>
+#include <type_traits>
 
 namespace rv {
 
-template <typename K, typename V>
+/*
+Lock-free unordered map as a singly linked list (Harris/Michael).
+
+Inserts push at the head; erase marks the victim's next link (logical delete) and then
+unlinks it. Unlinked nodes are handed to Epoch and freed only once no thread that could
+still be walking them is pinned, and every traversal runs under an Epoch guard, so
+find/for_each are safe against concurrent erase/clear. Values are std::atomic<V>:
+an update is a single store readers can't tear.
+Nodes come from `Alloc` (rebound to the node type), e.g. PoolAllocator; it must be
+stateless because Epoch frees nodes long after the list call that retired them.
+*/
+template <typename K, typename V, typename Alloc = std::allocator<std::byte>>
 class LockFreeList
 {
+    static_assert(std::is_trivially_copyable_v<V>, "LockFreeList values are updated atomically in place");
+
+    using Link = std::uintptr_t;              // Node* | tag bits
+    static constexpr Link mark_tag   = 1;     // on a node's next: that node is logically deleted
+    static constexpr Link frozen_tag = 2;     // on head_ and every node's next: no more inserts/erases (see freeze)
+    static constexpr Link tag_mask   = mark_tag | frozen_tag;
+
     struct Node {
-        K     key;
-        V     val;
-        Node* next;
-        Node(const K& k, const V& v, Node* n) : key{k}, val{v}, next{n} {}
-        Node(K&& k, V&& v, Node* n) noexcept
-            : key{std::move(k)}, val{std::move(v)}, next{n} {}
+        K                 key;
+        std::atomic<V>    val;
+        std::atomic<Link> next;
+        Node(const K& k, const V& v, Link n) : key{k}, val{v}, next{n} {}
     };
 
-    struct Head { Node* link; unsigned cnt; };
+    static_assert(alignof(Node) > tag_mask, "tag bits live in the low bits of node pointers");
+
+    using NodeAlloc  = typename std::allocator_traits<Alloc>::template rebind_alloc<Node>;
+    using NodeTraits = std::allocator_traits<NodeAlloc>;
+    static_assert(NodeTraits::is_always_equal::value, "LockFreeList needs a stateless allocator");
+
+    static Node* make_node(const K& k, const V& v, Link next)
+    {
+        NodeAlloc a;
+        Node* n = NodeTraits::allocate(a, 1);
+        NodeTraits::construct(a, n, k, v, next);
+        return n;
+    }
+
+    static void drop_node(Node* n) noexcept
+    {
+        NodeAlloc a;
+        NodeTraits::destroy(a, n);
+        NodeTraits::deallocate(a, n, 1);
+    }
+
+    static Node* ptr(Link l) noexcept { return reinterpret_cast<Node*>(l & ~tag_mask); }
+    static Link  link(Node* n) noexcept { return reinterpret_cast<Link>(n); }
 
-    std::atomic<Head> head_{ Head{nullptr,0} };
+    std::atomic<Link>        head_{0};
     std::atomic<std::size_t> sz_{0};
 
   public:
     LockFreeList() = default;
-    ~LockFreeList() { clear(); }
+    ~LockFreeList() { destroy(ptr(head_.load(std::memory_order_relaxed))); }
 
     /*
-    visit every node (read-only) - used by table rehash
+    visit every live entry; safe while other threads mutate the list.
+    Entries present for the whole call are visited exactly once; concurrent inserts/erases may or may not be seen.
     */
     template <typename Fn>
     void for_each(Fn&& fn) const
     {
-        for (Node* n = head_.load().link; n; n = n->next) {
-            fn(n->key, n->val);
+        auto guard = Epoch::pin();
+        for (Node* n = ptr(head_.load(std::memory_order_acquire)); n;) {
+            const Link nx = n->next.load(std::memory_order_acquire);
+            if (!(nx & mark_tag)) fn(n->key, n->val.load(std::memory_order_acquire));
+            n = ptr(nx);
         }
     }
 
     [[nodiscard]]
     std::optional<V> find(const K& key) const
     {
-        for (Node* n = head_.load().link; n; n = n->next)
-            if (n->key == key) return n->val;
+        auto guard = Epoch::pin();
+        for (Node* n = ptr(head_.load(std::memory_order_acquire)); n;) {
+            const Link nx = n->next.load(std::memory_order_acquire);
+            if (n->key == key && !(nx & mark_tag)) return n->val.load(std::memory_order_acquire);
+            n = ptr(nx);
+        }
         return std::nullopt;
     }
 
     /*
     insert-or-assign - lock-free
+    returns true if the key already existed
     */
     bool put(const K& key, const V& val)
     {
-        Head exp = head_.load();
-        Head nw;
+        return try_put(key, val) == PutResult::updated; // a list nobody freezes never reports frozen
+    }
+
+    /* lock-free; returns true if the key was there */
+    bool erase(const K& key) { return try_erase(key) == EraseResult::erased; }
 
+    /*
+    Freezing is how ConcurrentHashTable migrates a bucket: once frozen, inserts fail and an
+    update or erase that raced with the freeze reports `frozen`, so the caller redoes it elsewhere.
+    freeze() tags every node's next link as well, so a logical delete (a CAS on that link) either
+    lands before the node is frozen, and the migrator sees the mark and skips the node, or fails
+    and reports `frozen`: an erase that reports `erased` never leaves a copy behind.
+    */
+    enum class PutResult   { inserted, updated, frozen };
+    enum class EraseResult { erased, absent, frozen };
+
+    PutResult try_put(const K& key, const V& val) { return upsert(key, val, /*assign=*/true); }
+
+    /* insert only if absent (`updated` means the key was already there and is left alone) */
+    PutResult try_insert(const K& key, const V& val) { return upsert(key, val, /*assign=*/false); }
+
+    EraseResult try_erase(const K& key)
+    {
+        auto guard = Epoch::pin();
         for (;;) {
-            /* 1. search for existing key on read snapshot */
-            for (Node* n = exp.link; n; n = n->next)
-                if (n->key == key) { n->val = val; return true; }
-
-            /* 2. not found -> create new node & try to CAS */
-            Node* nn = new Node(key, val, exp.link);
-            nw.link  = nn;
-            nw.cnt   = exp.cnt + 1;
-
-            if (head_.compare_exchange_weak(exp, nw)) {
-                sz_.fetch_add(1);
-                return false; // inserted
+            Node* n = ptr(head_.load(std::memory_order_acquire));
+            Link  nx = 0;
+            for (; n; n = ptr(nx)) {
+                nx = n->next.load(std::memory_order_acquire);
+                if (n->key == key && !(nx & mark_tag)) break;
             }
-            /* CAS failed -> exp is updated, retry loop */
-            delete nn; // reclaim & retry
+            if (!n) return frozen() ? EraseResult::frozen : EraseResult::absent;
+            if (nx & frozen_tag) return EraseResult::frozen; // being (or been) copied: erase the copy instead
+
+            // logical delete; losing means another eraser, clear or freeze got there first: look again
+            if (!n->next.compare_exchange_strong(nx, nx | mark_tag, std::memory_order_acq_rel)) continue;
+            sz_.fetch_sub(1, std::memory_order_relaxed);
+            unlink_marked(); // gives up at once on a frozen list
+            return EraseResult::erased;
         }
     }
 
-    [[nodiscard]] std::size_t size() const noexcept { return sz_.load(); }
-
-    void clear() noexcept
+    /*
+    Stops inserts (head), then erases (each node's next). The closing seq_cst fence pairs with the
+    one in upsert: either the updater's re-check sees the freeze, or the values read after
+    freeze() returns (for_each) include its store.
+    */
+    void freeze()
     {
-        Head h = head_.exchange( Head{nullptr,0} );
-        Node* n = h.link;
-        while (n) { Node* d = n; n = n->next; delete d; }
-        sz_.store(0);
+        auto guard = Epoch::pin();   // the walk may meet nodes an eraser is unlinking
+        Link l = head_.fetch_or(frozen_tag, std::memory_order_acq_rel);
+        while (Node* n = ptr(l)) l = n->next.fetch_or(frozen_tag, std::memory_order_acq_rel);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
     }
 
+    [[nodiscard]] bool frozen() const noexcept { return head_.load(std::memory_order_acquire) & frozen_tag; }
+
+    /* empty a frozen list; its nodes go to the epoch collector since readers may still be walking them */
+    void retire_frozen() noexcept { retire_chain(head_.exchange(frozen_tag, std::memory_order_acq_rel)); }
+
+    [[nodiscard]] std::size_t size() const noexcept { return sz_.load(); }
+
+    /* unlink everything; safe against concurrent readers and writers */
+    void clear() noexcept { retire_chain(head_.exchange(0, std::memory_order_acq_rel)); }
+
     LockFreeList(const LockFreeList&)            = delete;
     LockFreeList& operator=(const LockFreeList&) = delete;
+
+  private:
+    PutResult upsert(const K& key, const V& val, bool assign)
+    {
+        auto guard = Epoch::pin();
+        Link exp = head_.load(std::memory_order_acquire);
+        Node* nn = nullptr;
+
+        for (;;) {
+            if (exp & frozen_tag) { if (nn) drop_node(nn); return PutResult::frozen; }
+
+            /* 1. search for a live node with the key */
+            for (Node* n = ptr(exp); n;) {
+                const Link nx = n->next.load(std::memory_order_acquire);
+                if (n->key == key && !(nx & mark_tag)) {
+                    if (nn) drop_node(nn);
+                    if (!assign) return PutResult::updated;
+                    n->val.store(val, std::memory_order_release);
+                    // store, then re-check: a store-buffering pair with freeze(), so both sides need the seq_cst fence
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    return frozen() ? PutResult::frozen : PutResult::updated;
+                }
+                n = ptr(nx);
+            }
+
+            /* 2. not found -> push a new node; the CAS fails if the head moved or the list was frozen */
+            if (!nn) nn = make_node(key, val, exp);
+            else     nn->next.store(exp, std::memory_order_relaxed);
+
+            if (head_.compare_exchange_weak(exp, link(nn), std::memory_order_acq_rel, std::memory_order_acquire)) {
+                sz_.fetch_add(1, std::memory_order_relaxed);
+                return PutResult::inserted;
+            }
+            /* CAS failed -> exp is updated, rescan (a concurrent insert may have added the key) */
+        }
+    }
+
+    /* physically unlink marked nodes and retire them; gives up on a frozen list (retire_frozen takes them) */
+    void unlink_marked() noexcept
+    {
+        for (bool again = true; again;) {
+            again = false;
+            std::atomic<Link>* prev = &head_;
+            Link cur = prev->load(std::memory_order_acquire);
+            if (cur & frozen_tag) return;
+            while (Node* n = ptr(cur)) {
+                if (cur & frozen_tag) return;
+                const Link nx = n->next.load(std::memory_order_acquire);
+                if (!(nx & mark_tag)) { prev = &n->next; cur = nx; continue; }
+                // succeeds only while prev is live (unmarked) and still points at n
+                if (!prev->compare_exchange_strong(cur, nx & ~mark_tag, std::memory_order_acq_rel)) {
+                    again = true;
+                    break;
+                }
+                Epoch::retire(n, [](void* p) { drop_node(static_cast<Node*>(p)); });
+                cur = nx & ~mark_tag;
+            }
+        }
+    }
+
+    /* take over a detached chain: mark every node (so late erasers see it gone), fix the size, defer the free */
+    void retire_chain(Link head) noexcept
+    {
+        std::size_t live = 0;
+        for (Node* n = ptr(head); n;) {
+            const Link nx = n->next.fetch_or(mark_tag, std::memory_order_acq_rel);
+            live += !(nx & mark_tag);
+            n = ptr(nx);
+        }
+        sz_.fetch_sub(live, std::memory_order_relaxed);
+        if (ptr(head))
+            Epoch::retire(ptr(head), [](void* p) { destroy(static_cast<Node*>(p)); });
+    }
+
+    static void destroy(Node* n) noexcept
+    {
+        while (n) { Node* d = n; n = ptr(n->next.load(std::memory_order_relaxed)); drop_node(d); }
+    }
 };
 
 } // namespace rv
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <format>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace rv {
+
+/*
+Read-only mapping of a whole file, advised for sequential reading.
+Throws std::runtime_error if the file can't be opened or mapped. An empty file maps to
+an empty span (mmap rejects zero lengths).
+*/
+class MappedFile
+{
+  public:
+    explicit MappedFile(const std::string& path)
+    {
+        fd_ = ::open(path.c_str(), O_RDONLY);
+        if (fd_ < 0) throw std::runtime_error(std::format("cannot open '{}'", path));
+        struct stat st{};
+        if (::fstat(fd_, &st) != 0) { ::close(fd_); throw std::runtime_error("fstat failed"); }
+        size_ = static_cast<std::size_t>(st.st_size);
+        if (size_ == 0) return;
+        data_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (data_ == MAP_FAILED) { ::close(fd_); throw std::runtime_error("mmap failed"); }
+        ::madvise(data_, size_, MADV_SEQUENTIAL);
+    }
+    ~MappedFile()
+    {
+        if (data_) ::munmap(data_, size_);
+        ::close(fd_);
+    }
+
+    MappedFile(const MappedFile&)            = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    [[nodiscard]] std::span<const std::byte> bytes() const noexcept
+    { return { static_cast<const std::byte*>(data_), size_ }; }
+
+    [[nodiscard]] std::string_view text() const noexcept
+    { return { static_cast<const char*>(data_), size_ }; }
+
+  private:
+    int         fd_   = -1;
+    void*       data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+} // namespace rv
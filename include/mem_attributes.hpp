@@ -0,0 +1,52 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <format>
+#include <stdexcept>
+#include <vector>
+
+namespace rv {
+
+/*
+Physical memory attributes, as a cache sees them:
+    cacheable        normal RAM: allocate, hit, write back
+    uncached         every access goes straight to the next level (device registers)
+    write_combining  loads are uncached; stores merge into a line-sized buffer that is
+                     flushed as one burst (framebuffers)
+*/
+enum class MemAttr : std::uint8_t { cacheable, uncached, write_combining };
+
+/* a handful of non-overlapping ranges; anything not covered is cacheable */
+class MemoryAttributes
+{
+  public:
+    void set(std::uint32_t base, std::uint32_t size, MemAttr attr)
+    {
+        if (size == 0 || base + (size - 1) < base)
+            throw std::invalid_argument(std::format("bad attribute range 0x{:08x}+{}", base, size));
+        if (std::ranges::any_of(ranges_, [&](const Range& r){ return r.base - base < size || base - r.base < r.size; }))
+            throw std::invalid_argument(std::format("attribute range 0x{:08x}+{} overlaps another", base, size));
+        ranges_.push_back({ base, size, attr });
+    }
+
+    [[nodiscard]] bool empty() const noexcept { return ranges_.empty(); }
+
+    [[nodiscard]] MemAttr operator()(std::uint32_t addr) const noexcept
+    {
+        for (const Range& r : ranges_)
+            if (addr - r.base < r.size) return r.attr;
+        return MemAttr::cacheable;
+    }
+
+  private:
+    struct Range
+    {
+        std::uint32_t base;
+        std::uint32_t size;
+        MemAttr       attr;
+    };
+
+    std::vector<Range> ranges_;
+};
+
+} // namespace rv
@@ -0,0 +1,251 @@
+#pragma once
+#include "memory_bus.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace rv {
+
+/*
+Guest memory-access trace.
+
+File layout:
+    header  : "RVTR" | u16 version | u16 reserved | u64 record count   (little endian)
+    records : tag byte | addr delta | [pc delta]
+The tag holds the kind (bits 0-1) and log2 of the access size (bits 2-3).
+Deltas are zigzag LEB128 varints against the previous record of the same stream:
+fetches against the previous fetch, loads/stores against the previous data access.
+Fetches carry no pc (it is the address), so a straight-line fetch costs two bytes.
+*/
+struct TraceRecord
+{
+    enum class Kind : std::uint8_t { fetch, load, store };
+
+    std::uint32_t addr;
+    std::uint32_t pc;   // == addr for fetches
+    Kind          kind;
+    std::uint8_t  size; // bytes (MemoryBus accesses are always 4)
+};
+
+namespace detail {
+
+inline constexpr std::array<char, 4> trace_magic{ 'R', 'V', 'T', 'R' };
+inline constexpr std::uint16_t       trace_version = 1;
+inline constexpr std::size_t         trace_header_size = 16;
+
+constexpr std::uint32_t zigzag(std::int32_t v) noexcept
+{ return (static_cast<std::uint32_t>(v) << 1) ^ static_cast<std::uint32_t>(v >> 31); }
+
+constexpr std::int32_t unzigzag(std::uint32_t v) noexcept
+{ return static_cast<std::int32_t>(v >> 1) ^ -static_cast<std::int32_t>(v & 1); }
+
+/* encoder/decoder delta state, shared so both sides stay in lock-step */
+struct TraceState
+{
+    std::uint32_t last_fetch = 0;
+    std::uint32_t last_data  = 0;
+    std::uint32_t last_pc    = 0;
+};
+
+} // namespace detail
+
+/*
+Streams records to disk through a fixed buffer; the record count in the header
+is patched on close().
+*/
+class TraceWriter
+{
+  public:
+    explicit TraceWriter(const std::string& path)
+        : out_{path, std::ios::binary | std::ios::trunc}
+    {
+        if (!out_) throw std::runtime_error(std::format("cannot open trace '{}'", path));
+        buf_.reserve(buffer_bytes + 16);
+        std::array<char, detail::trace_header_size> hdr{};
+        std::memcpy(hdr.data(), detail::trace_magic.data(), 4);
+        hdr[4] = static_cast<char>(detail::trace_version & 0xFF);
+        hdr[5] = static_cast<char>(detail::trace_version >> 8);
+        out_.write(hdr.data(), hdr.size());
+    }
+
+    ~TraceWriter()
+    {
+        try { close(); } catch (...) {}
+    }
+
+    TraceWriter(const TraceWriter&)            = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+
+    void write(const TraceRecord& r)
+    {
+        const auto size_log2 = static_cast<std::uint8_t>(r.size >= 4 ? 2 : r.size >> 1);
+        buf_.push_back(static_cast<std::uint8_t>(static_cast<std::uint8_t>(r.kind) | (size_log2 << 2)));
+
+        std::uint32_t& last = r.kind == TraceRecord::Kind::fetch ? st_.last_fetch : st_.last_data;
+        put_varint(detail::zigzag(static_cast<std::int32_t>(r.addr - last)));
+        last = r.addr;
+
+        if (r.kind != TraceRecord::Kind::fetch) {
+            put_varint(detail::zigzag(static_cast<std::int32_t>(r.pc - st_.last_pc)));
+            st_.last_pc = r.pc;
+        }
+
+        ++count_;
+        if (buf_.size() >= buffer_bytes) flush();
+    }
+
+    [[nodiscard]] std::uint64_t count() const noexcept { return count_; }
+
+    void close()
+    {
+        if (!out_.is_open()) return;
+        flush();
+        std::array<char, 8> n{};
+        for (std::size_t i = 0; i < 8; ++i) n[i] = static_cast<char>((count_ >> (8 * i)) & 0xFF);
+        out_.seekp(8);
+        out_.write(n.data(), n.size());
+        out_.close();
+        if (out_.fail()) throw std::runtime_error("trace write failed");
+    }
+
+  private:
+    static constexpr std::size_t buffer_bytes = 1 << 16;
+
+    std::ofstream             out_;
+    std::vector<std::uint8_t> buf_;
+    detail::TraceState        st_;
+    std::uint64_t             count_ = 0;
+
+    void put_varint(std::uint32_t v)
+    {
+        while (v >= 0x80) { buf_.push_back(static_cast<std::uint8_t>(v | 0x80)); v >>= 7; }
+        buf_.push_back(static_cast<std::uint8_t>(v));
+    }
+
+    void flush()
+    {
+        out_.write(reinterpret_cast<const char*>(buf_.data()), static_cast<std::streamsize>(buf_.size()));
+        buf_.clear();
+    }
+};
+
+/*
+Decodes a trace held in memory (e.g. an mmapped file). Cheap to copy, so each
+replay thread can walk the same bytes with its own reader.
+*/
+class TraceReader
+{
+  public:
+    explicit TraceReader(std::span<const std::byte> bytes)
+        : bytes_{bytes}
+    {
+        if (bytes.size() < detail::trace_header_size ||
+            std::memcmp(bytes.data(), detail::trace_magic.data(), 4) != 0)
+            throw std::runtime_error("not an RVTR trace");
+        const auto version = static_cast<std::uint16_t>(byte(4) | (byte(5) << 8));
+        if (version != detail::trace_version)
+            throw std::runtime_error(std::format("unsupported trace version {}", version));
+        for (std::size_t i = 0; i < 8; ++i) count_ |= std::uint64_t{byte(8 + i)} << (8 * i);
+        pos_ = detail::trace_header_size;
+    }
+
+    [[nodiscard]] std::uint64_t count() const noexcept { return count_; }
+
+    [[nodiscard]] std::optional<TraceRecord> next()
+    {
+        if (pos_ >= bytes_.size()) return std::nullopt;
+        const auto tg = static_cast<std::uint8_t>(byte(pos_++));
+
+        TraceRecord r{};
+        r.kind = static_cast<TraceRecord::Kind>(tg & 0x3);
+        r.size = static_cast<std::uint8_t>(1u << ((tg >> 2) & 0x3));
+
+        std::uint32_t& last = r.kind == TraceRecord::Kind::fetch ? st_.last_fetch : st_.last_data;
+        last  += static_cast<std::uint32_t>(detail::unzigzag(get_varint()));
+        r.addr = last;
+
+        if (r.kind == TraceRecord::Kind::fetch) {
+            r.pc = r.addr;
+        } else {
+            st_.last_pc += static_cast<std::uint32_t>(detail::unzigzag(get_varint()));
+            r.pc = st_.last_pc;
+        }
+        return r;
+    }
+
+  private:
+    std::span<const std::byte> bytes_;
+    std::size_t                pos_   = 0;
+    std::uint64_t              count_ = 0;
+    detail::TraceState         st_;
+
+    [[nodiscard]] std::uint32_t byte(std::size_t i) const noexcept
+    { return std::to_integer<std::uint32_t>(bytes_[i]); }
+
+    std::uint32_t get_varint()
+    {
+        std::uint32_t v = 0;
+        for (unsigned shift = 0; pos_ < bytes_.size() && shift < 35; shift += 7) {
+            const std::uint32_t b = byte(pos_++);
+            v |= (b & 0x7F) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        throw std::runtime_error("truncated trace record");
+    }
+};
+
+/*
+MemoryBus decorator that records every access passing through it.
+Put it between the CPU and the first cache: loads/stores are told apart from
+instruction fetches by the one-shot MemoryBus::set_pc() hint.
+*/
+class TraceRecorder : public MemoryBus
+{
+  public:
+    TraceRecorder(std::unique_ptr<MemoryBus> next, const std::string& path)
+        : next_{std::move(next)}, writer_{path} {}
+
+    std::optional<std::uint32_t> load_word(std::uint32_t addr) override
+    {
+        const bool fetch = pc_ == no_pc;
+        writer_.write({ addr, fetch ? addr : pc_, fetch ? TraceRecord::Kind::fetch : TraceRecord::Kind::load, 4 });
+        forward_pc();
+        return next_->load_word(addr);
+    }
+
+    bool store_word(std::uint32_t addr, std::uint32_t v) override
+    {
+        writer_.write({ addr, pc_ == no_pc ? 0 : pc_, TraceRecord::Kind::store, 4 });
+        forward_pc();
+        return next_->store_word(addr, v);
+    }
+
+    void set_pc(std::uint32_t pc) noexcept override { pc_ = pc; }
+    void fence() override { next_->fence(); }
+
+    [[nodiscard]] MemoryBus&      next()  noexcept { return *next_; }
+    [[nodiscard]] std::uint64_t   count() const noexcept { return writer_.count(); }
+    void                          close() { writer_.close(); }
+
+  private:
+    std::unique_ptr<MemoryBus> next_;
+    TraceWriter                writer_;
+    std::uint32_t              pc_ = no_pc;
+
+    void forward_pc() noexcept
+    {
+        if (pc_ != no_pc) next_->set_pc(pc_);
+        pc_ = no_pc;
+    }
+};
+
+} // namespace rv
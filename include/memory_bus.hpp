@@ -1,6 +1,7 @@
 #pragma once
 #include <cstdint>
 #include <optional>
+#include <span>
 
 namespace rv {
 
@@ -11,6 +12,29 @@ struct MemoryBus
 {
     virtual std::optional<std::uint32_t> load_word(std::uint32_t addr) = 0;
     virtual bool store_word(std::uint32_t addr, std::uint32_t value) = 0;
+
+    /*
+    Burst write of consecutive words from `addr`; bit i of `mask` enables words[i].
+    Counts as one transaction. The default splits it into store_word calls.
+    */
+    virtual bool store_block(std::uint32_t addr, std::span<const std::uint32_t> words, std::uint32_t mask = ~0u)
+    {
+        bool ok = true;
+        for (std::size_t i = 0; i < words.size(); ++i)
+            if (mask & (1u << i)) ok &= store_word(addr + static_cast<std::uint32_t>(i * 4), words[i]);
+        return ok;
+    }
+
+    /* memory fence: buffered writes below this point must become visible (FENCE instruction) */
+    virtual void fence() {}
+
+    /*
+    Side-channel from the CPU: pc of the load/store about to access the bus.
+    It applies to the next access only; accesses without one (instruction fetch,
+    host-side pokes) see no_pc. Buses that care (prefetchers, tracers) override it.
+    */
+    static constexpr std::uint32_t no_pc = 0xFFFF'FFFF;
+    virtual void set_pc(std::uint32_t /*pc*/) noexcept {}
     virtual ~MemoryBus() = default;
 };
 
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+
+namespace rv {
+
+/*
+Fully-associative LRU shadow of a cache with the same number of lines.
+Used to split real misses into the 3C classes:
+    compulsory - the line has never been touched before
+    capacity   - the shadow misses too (working set larger than the cache)
+    conflict   - the shadow hits, so only the set mapping caused the miss
+Also reports how many accesses went by since the line was last touched (reuse distance).
+Not thread-safe; the owning Cache serialises calls.
+*/
+class MissClassifier
+{
+  public:
+    explicit MissClassifier(std::size_t lines) : capacity_{lines} {}
+
+    struct Observation
+    {
+        bool          first_touch; // never seen before
+        bool          shadow_hit;  // resident in the fully-associative shadow
+        std::uint64_t reuse;       // accesses since last touch (0 if first_touch)
+    };
+
+    Observation observe(std::uint32_t line_addr)
+    {
+        const std::uint64_t now = clock_++;
+        auto [it, inserted] = seen_.try_emplace(line_addr);
+        Entry& e = it->second;
+
+        Observation obs{ inserted, e.resident, inserted ? 0 : now - e.last - 1 };
+        e.last = now;
+
+        if (e.resident) {
+            lru_.splice(lru_.begin(), lru_, e.pos); // move to MRU
+            return obs;
+        }
+
+        if (lru_.size() == capacity_) {           // evict shadow LRU
+            seen_[lru_.back()].resident = false;
+            lru_.pop_back();
+        }
+        lru_.push_front(line_addr);
+        e.pos      = lru_.begin();
+        e.resident = true;
+        return obs;
+    }
+
+    enum class Kind : std::uint8_t { compulsory, capacity, conflict };
+
+    [[nodiscard]] static constexpr Kind classify(const Observation& o) noexcept
+    {
+        if (o.first_touch) return Kind::compulsory;
+        return o.shadow_hit ? Kind::conflict : Kind::capacity;
+    }
+
+  private:
+    struct Entry
+    {
+        std::list<std::uint32_t>::iterator pos{};
+        std::uint64_t                      last{0};
+        bool                               resident{false};
+    };
+
+    std::size_t                                 capacity_;
+    std::uint64_t                               clock_{0};
+    std::list<std::uint32_t>                    lru_; // front = MRU
+    std::unordered_map<std::uint32_t, Entry>    seen_;
+};
+
+} // namespace rv
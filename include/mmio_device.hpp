@@ -0,0 +1,68 @@
+#pragma once
+#include "dirty_tiles.hpp"
+#include <cstdint>
+
+namespace rv {
+
+/*
+A memory-mapped device. MmioWindow::map() gives it an address range and calls
+read/write with the word offset into that range (offset = addr - base).
+*/
+struct MmioDevice
+{
+    virtual std::uint32_t read(std::uint32_t /*offset*/) { return 0; }
+    virtual void          write(std::uint32_t offset, std::uint32_t value) = 0;
+    virtual ~MmioDevice() = default;
+};
+
+/*
+128-by-128 byte-per-pixel framebuffer; one pixel per byte address, the low byte of a store.
+Stores that change a pixel mark its tile in `dirty`.
+*/
+class FramebufferDevice : public MmioDevice
+{
+  public:
+    FramebufferDevice(std::uint8_t* const& pixels, DirtyTiles& dirty) : pixels_{pixels}, dirty_{dirty} {}
+
+    std::uint32_t read(std::uint32_t offset) override { return pixels_ ? pixels_[offset] : 0; }
+    void write(std::uint32_t offset, std::uint32_t v) override
+    {
+        if (!pixels_) return;
+        const auto px = static_cast<std::uint8_t>(v);
+        if (pixels_[offset] != px) {
+            pixels_[offset] = px;
+            dirty_.mark(offset);
+        }
+    }
+
+  private:
+    std::uint8_t* const& pixels_; // the window's framebuffer pointer, which the host may set later
+    DirtyTiles&          dirty_;
+};
+
+/* read-only input register (buttons) */
+class GpioDevice : public MmioDevice
+{
+  public:
+    explicit GpioDevice(const std::uint8_t& in) : in_{in} {}
+
+    std::uint32_t read(std::uint32_t) override { return in_; }
+    void write(std::uint32_t, std::uint32_t) override {}
+
+  private:
+    const std::uint8_t& in_;
+};
+
+/* write-only tone register */
+class AudioDevice : public MmioDevice
+{
+  public:
+    explicit AudioDevice(std::uint8_t& note) : note_{note} {}
+
+    void write(std::uint32_t, std::uint32_t v) override { note_ = static_cast<std::uint8_t>(v); }
+
+  private:
+    std::uint8_t& note_;
+};
+
+} // namespace rv
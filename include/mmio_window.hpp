@@ -1,26 +1,89 @@
 #pragma once
+#include "dirty_tiles.hpp"
 #include "memory_bus.hpp"
+#include "mmio_device.hpp"
+#include <array>
 #include <cstdint>
 #include <optional>
 #include <memory>
+#include <span>
+#include <string>
+#include <vector>
 
 namespace rv {
 
-/* host-side memory-mapped I/O window */
+/*
+host-side memory-mapped I/O window
+
+Devices claim address ranges with map(); everything else falls through to `next_`.
+Dispatch goes through a two-level page table (4 KiB pages): a RAM access costs one
+null check on the top-level directory, however many devices are mapped.
+*/
 class MmioWindow : public MemoryBus
 {
   public:
-    explicit MmioWindow(std::unique_ptr<MemoryBus> next)   // <- ctor
-        : next_{std::move(next)} {}
+    static constexpr std::uint32_t fb_base    = 0x2000'0000;
+    static constexpr std::uint32_t fb_size    = 0x2000;
+    static constexpr std::uint32_t gpio_addr  = 0x2000'2000;
+    static constexpr std::uint32_t audio_addr = 0x2000'2004;
+
+    /* a mapped device and its access counters */
+    struct Region
+    {
+        std::string                 name;
+        std::uint32_t               base;
+        std::uint32_t               size;
+        std::unique_ptr<MmioDevice> device;
+        std::uint64_t               reads  = 0;
+        std::uint64_t               writes = 0;
+
+        [[nodiscard]] bool contains(std::uint32_t a) const noexcept { return a - base < size; }
+    };
+
+    explicit MmioWindow(std::unique_ptr<MemoryBus> next);   // <- ctor, maps framebuffer, GPIO and audio
 
     std::uint8_t* framebuffer = nullptr;   // 128-by-128 byte-indexed FB
+    DirtyTiles    fb_dirty;                // FB tiles changed by the guest; the host clears it when it takes a frame
     std::uint8_t  gpio_in     = 0;         // buttons
     std::uint8_t  audio_note  = 0;         // tone id
 
     std::optional<std::uint32_t> load_word(std::uint32_t) override;
     bool                         store_word(std::uint32_t, std::uint32_t) override;
+    void                         fence() override { next_->fence(); }
+
+    /*
+    Map `dev` at [base, base+size). Throws std::invalid_argument on an empty range,
+    wrap-around or overlap with an existing device. Returns the device.
+    */
+    MmioDevice& map(std::string name, std::uint32_t base, std::uint32_t size, std::unique_ptr<MmioDevice> dev);
+
+    /* mapped devices, sorted by base address */
+    [[nodiscard]] std::span<const Region> regions() const noexcept { return regions_; }
+
   private:
-    std::unique_ptr<MemoryBus> next_;      // DRAM or next cache
+    static constexpr unsigned page_shift = 12;
+    static constexpr unsigned leaf_bits  = 10; // 2^10 pages per leaf, 2^10 leaves
+
+    // entry = 1 + index of the first region overlapping the page, 0 = no device
+    using Leaf = std::array<std::uint16_t, 1u << leaf_bits>;
+
+    std::unique_ptr<MemoryBus>                         next_;      // DRAM or next cache
+    std::vector<Region>                                regions_;
+    std::array<std::unique_ptr<Leaf>, 1u << leaf_bits> directory_;
+
+    void rebuild_pages();
+
+    [[nodiscard]] Region* find(std::uint32_t a) noexcept
+    {
+        const auto& leaf = directory_[a >> (page_shift + leaf_bits)];
+        if (!leaf) [[likely]] return nullptr;
+        const std::uint16_t e = (*leaf)[(a >> page_shift) & ((1u << leaf_bits) - 1)];
+        if (!e) return nullptr;
+        // sub-page devices share a page: scan the (sorted) regions that start at or before `a`
+        for (std::size_t i = e - 1u; i < regions_.size() && regions_[i].base <= a; ++i)
+            if (regions_[i].contains(a)) return &regions_[i];
+        return nullptr;
+    }
 };
 
 } // namespace rv
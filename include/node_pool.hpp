@@ -0,0 +1,250 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <mutex>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace rv {
+
+/* process-wide counters for every PoolAllocator size class */
+struct PoolStats
+{
+    std::uint64_t allocations    = 0; // nodes handed out
+    std::uint64_t deallocations  = 0;
+    std::uint64_t recycled       = 0; // allocations served from a free list rather than fresh slab space
+    std::uint64_t slabs          = 0;
+    std::uint64_t bytes_reserved = 0; // slab memory taken from the system; never given back, so also the peak
+    std::uint64_t peak_live      = 0; // high-water mark of allocations - deallocations (sampled every few hundred ops)
+
+    [[nodiscard]] std::uint64_t live() const noexcept { return allocations - deallocations; }
+
+    [[nodiscard]] double recycle_rate() const noexcept
+    {
+        return allocations ? static_cast<double>(recycled) / static_cast<double>(allocations) : 0.0;
+    }
+
+    [[nodiscard]] std::string pretty() const
+    {
+        return std::format("allocs={} frees={} live={} peak_live={} recycled={:.1f}% slabs={} reserved={:.2f} MiB",
+                           allocations, deallocations, live(), peak_live, recycle_rate() * 100.0,
+                           slabs, static_cast<double>(bytes_reserved) / (1024.0 * 1024.0));
+    }
+};
+
+namespace detail {
+
+struct PoolCounters
+{
+    std::atomic<std::uint64_t> allocations{0}, deallocations{0}, recycled{0}, slabs{0}, bytes{0}, peak_live{0};
+};
+
+/* trivially destructible, so frees that run during static/thread teardown can still count */
+inline PoolCounters pool_counters;
+
+} // namespace detail
+
+/*
+Per-thread slab allocator for fixed-size nodes.
+
+Each thread carves blocks out of its own 64 KiB, cache-line-aligned slabs (so nodes
+allocated by different threads don't share lines) and keeps a private free list that
+deallocate() pushes onto; allocation is a pointer pop with no atomics.
+A thread whose free list grows past `max_local` (e.g. the one running Epoch collection
+for everybody) donates it to a shared pool the others refill from, and an exiting thread
+donates everything it holds. Slabs are never returned to the system.
+*/
+template <std::size_t Block, std::size_t Align>
+class NodePool
+{
+    static_assert(Block >= sizeof(void*) && Block % Align == 0);
+
+  public:
+    static constexpr std::size_t slab_bytes  = 64 * 1024;
+    static constexpr std::size_t line_bytes  = 64;
+    static constexpr std::size_t max_local   = 4096; // free nodes a thread keeps before donating
+    static constexpr std::size_t flush_every = 256;  // ops between folding thread counters into PoolStats
+
+    [[nodiscard]] static void* allocate()
+    {
+        Local& l = local_;
+        void* p;
+        if (l.free) {
+            p = l.free;
+            l.free = l.free->next;
+            --l.n_free;
+            ++l.recycled;
+        } else {
+            if (l.bump == l.end) refill(l);
+            if (l.free) return allocate(); // refill handed us a donated chain
+            p = l.bump;
+            l.bump += Block;
+        }
+        ++l.allocs;
+        if (++l.ops == flush_every) flush(l);
+        return p;
+    }
+
+    static void deallocate(void* p) noexcept
+    {
+        Local& l = local_;
+        if (l.dead) { // thread already torn down: hand the block straight to the shared pool
+            auto* n = static_cast<FreeNode*>(p);
+            n->next = nullptr;
+            donate(n, 1);
+            detail::pool_counters.deallocations.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        auto* n = static_cast<FreeNode*>(p);
+        n->next = l.free;
+        l.free  = n;
+        ++l.frees;
+        if (++l.n_free > max_local) {
+            donate(l.free, l.n_free);
+            l.free   = nullptr;
+            l.n_free = 0;
+        }
+        if (++l.ops == flush_every) flush(l);
+    }
+
+  private:
+    struct FreeNode { FreeNode* next; };
+
+    /* constant-initialised and trivially destructible: valid for the whole life of the thread */
+    struct Local
+    {
+        FreeNode*     free   = nullptr;
+        std::size_t   n_free = 0;
+        std::byte*    bump   = nullptr;
+        std::byte*    end    = nullptr;
+        std::uint64_t allocs = 0, frees = 0, recycled = 0;
+        std::uint32_t ops    = 0;
+        bool          registered = false, dead = false;
+    };
+
+    /* gives the thread's blocks away when it exits */
+    struct Teardown
+    {
+        ~Teardown()
+        {
+            Local& l = local_;
+            for (; l.bump != l.end; l.bump += Block) { // unused tail of the current slab
+                auto* n = reinterpret_cast<FreeNode*>(l.bump);
+                n->next = l.free;
+                l.free  = n;
+                ++l.n_free;
+            }
+            if (l.free) donate(l.free, l.n_free);
+            l.free   = nullptr;
+            l.n_free = 0;
+            flush(l);
+            l.dead = true;
+        }
+    };
+
+    struct Chain { FreeNode* head; std::size_t n; };
+    struct Shared
+    {
+        std::mutex         mtx;
+        std::vector<Chain> chains;
+    };
+
+    inline static constinit thread_local Local local_{};
+    inline static thread_local Teardown        teardown_;
+
+    /* never destroyed: blocks may still be freed by Epoch's exit-time cleanup */
+    static Shared& shared()
+    {
+        static Shared& s = *new Shared;
+        return s;
+    }
+
+    static void donate(FreeNode* head, std::size_t n)
+    {
+        std::scoped_lock lk(shared().mtx);
+        shared().chains.push_back({ head, n });
+    }
+
+    static void refill(Local& l)
+    {
+        if (!l.registered) { (void)&teardown_; l.registered = true; }
+        {
+            std::scoped_lock lk(shared().mtx);
+            if (!shared().chains.empty()) {
+                l.free   = shared().chains.back().head;
+                l.n_free = shared().chains.back().n;
+                shared().chains.pop_back();
+                return;
+            }
+        }
+        auto* slab = static_cast<std::byte*>(::operator new(slab_bytes, std::align_val_t{line_bytes}));
+        l.bump = slab;
+        l.end  = slab + slab_bytes / Block * Block;
+        detail::pool_counters.slabs.fetch_add(1, std::memory_order_relaxed);
+        detail::pool_counters.bytes.fetch_add(slab_bytes, std::memory_order_relaxed);
+    }
+
+    static void flush(Local& l) noexcept
+    {
+        auto& c = detail::pool_counters;
+        const std::uint64_t a = c.allocations.fetch_add(l.allocs, std::memory_order_relaxed) + l.allocs;
+        const std::uint64_t f = c.deallocations.fetch_add(l.frees, std::memory_order_relaxed) + l.frees;
+        c.recycled.fetch_add(l.recycled, std::memory_order_relaxed);
+        l.allocs = l.frees = l.recycled = 0;
+        l.ops = 0;
+
+        const std::uint64_t live = a > f ? a - f : 0;
+        std::uint64_t peak = c.peak_live.load(std::memory_order_relaxed);
+        while (live > peak && !c.peak_live.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+    }
+};
+
+/*
+Stateless allocator over NodePool: single-object allocations come from the calling
+thread's slabs, arrays go to operator new. Plug into LockFreeList / ConcurrentHashTable as
+the Alloc parameter.
+*/
+template <typename T>
+class PoolAllocator
+{
+    static constexpr std::size_t align = std::max(alignof(T), alignof(void*));
+    static constexpr std::size_t block = (std::max(sizeof(T), sizeof(void*)) + align - 1) / align * align;
+    using Pool = NodePool<block, align>;
+
+  public:
+    using value_type      = T;
+    using is_always_equal = std::true_type;
+
+    PoolAllocator() noexcept = default;
+    template <typename U> PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+    [[nodiscard]] T* allocate(std::size_t n)
+    {
+        if (n == 1) return static_cast<T*>(Pool::allocate());
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{alignof(T)}));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        if (n == 1) Pool::deallocate(p);
+        else        ::operator delete(p, std::align_val_t{alignof(T)});
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>&) const noexcept { return true; }
+};
+
+/* counters for all pools; exact once the threads that used them have exited (otherwise up to flush_every ops behind each) */
+[[nodiscard]] inline PoolStats node_pool_stats() noexcept
+{
+    auto& c = detail::pool_counters;
+    return { c.allocations.load(), c.deallocations.load(), c.recycled.load(),
+             c.slabs.load(), c.bytes.load(), c.peak_live.load() };
+}
+
+} // namespace rv
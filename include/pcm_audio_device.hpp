@@ -0,0 +1,95 @@
+#pragma once
+#include "mmio_device.hpp"
+#include "spsc_queue.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace rv {
+
+/*
+Memory-mapped PCM output: the guest streams signed 16-bit mono samples into a FIFO and
+the host's audio callback drains it on its own thread. The FIFO is a lock-free SPSC
+ring, so neither side ever waits for the other: a full FIFO drops the guest's samples
+(OVERRUNS), an empty one plays silence (UNDERRUNS).
+
+Register map (word offsets from the device base):
+    0x00 DATA       write: two samples, low half first (a zero high half still counts)
+    0x04 DATA1      write: one sample (low half)
+    0x08 LEVEL      read: samples queued
+    0x0C SPACE      read: samples that fit before the FIFO overruns
+    0x10 STATUS     read: bit0 low water (at most half full), bit1 full, bit2 playing
+    0x14 UNDERRUNS  read: callbacks that ran dry while playing
+    0x18 OVERRUNS   read: samples dropped because the FIFO was full
+    0x1C RATE       read: samples per second
+
+A guest paces itself by topping the FIFO up whenever STATUS.low is set (or SPACE is
+large), which keeps latency between half and one FIFO's worth of audio.
+*/
+class PcmAudioDevice : public MmioDevice
+{
+  public:
+    static constexpr std::uint32_t default_base = 0x2000'4000;
+    static constexpr std::uint32_t window_size  = 0x20;
+    static constexpr std::uint32_t sample_rate  = 22'050;
+    static constexpr std::size_t   fifo_size    = 4096;   // ~186 ms at 22.05 kHz
+
+    enum Reg : std::uint32_t {
+        data = 0x00, data1 = 0x04, level = 0x08, space = 0x0C,
+        status = 0x10, underruns = 0x14, overruns = 0x18, rate = 0x1C
+    };
+    static constexpr std::uint32_t status_low = 1u << 0, status_full = 1u << 1, status_playing = 1u << 2;
+
+    std::uint32_t read(std::uint32_t offset) override
+    {
+        const auto queued = static_cast<std::uint32_t>(fifo_.size());
+        switch (offset) {
+          case level:     return queued;
+          case space:     return static_cast<std::uint32_t>(fifo_size) - queued;
+          case status:    return (queued <= fifo_size / 2 ? status_low : 0) | (queued == fifo_size ? status_full : 0) |
+                                 (playing_.load(std::memory_order_relaxed) ? status_playing : 0);
+          case underruns: return underruns_.load(std::memory_order_relaxed);
+          case overruns:  return overruns_.load(std::memory_order_relaxed);
+          case rate:      return sample_rate;
+          default:        return 0;
+        }
+    }
+
+    void write(std::uint32_t offset, std::uint32_t v) override
+    {
+        if (offset != data && offset != data1) return;
+        const std::array<std::int16_t, 2> s{ static_cast<std::int16_t>(v & 0xFFFF), static_cast<std::int16_t>(v >> 16) };
+        const std::size_t n = offset == data ? 2 : 1;
+        if (const std::size_t pushed = fifo_.try_push(std::span{ s }.first(n)); pushed < n)
+            overruns_.fetch_add(static_cast<std::uint32_t>(n - pushed), std::memory_order_relaxed);
+    }
+
+    /*
+    Audio thread: fill `out` from the FIFO and pad with silence. A short fill counts as
+    an underrun only while the guest is playing, i.e. the last callback got samples, so
+    a guest that never plays (or stopped) doesn't count against itself.
+    */
+    void drain(std::span<std::int16_t> out) noexcept
+    {
+        const std::size_t n = fifo_.try_pop(out);
+        std::fill(out.begin() + static_cast<std::ptrdiff_t>(n), out.end(), std::int16_t{ 0 });
+        if (n < out.size() && playing_.load(std::memory_order_relaxed))
+            underruns_.fetch_add(1, std::memory_order_relaxed);
+        playing_.store(n != 0, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] std::size_t   queued() const noexcept { return fifo_.size(); }
+    [[nodiscard]] std::uint32_t underrun_count() const noexcept { return underruns_.load(std::memory_order_relaxed); }
+    [[nodiscard]] std::uint32_t overrun_count() const noexcept { return overruns_.load(std::memory_order_relaxed); }
+
+  private:
+    SpscQueue<std::int16_t, fifo_size> fifo_;      // guest (CPU thread) -> audio callback
+    std::atomic<std::uint32_t>         underruns_{ 0 };
+    std::atomic<std::uint32_t>         overruns_{ 0 };
+    std::atomic<bool>                  playing_{ false };
+};
+
+} // namespace rv
@@ -0,0 +1,186 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "memory_bus.hpp"
+
+namespace rv {
+
+/*
+Hardware prefetcher model, attached to a Cache with Cache::attach_prefetcher().
+The cache calls on_access() after every demand access; the prefetcher appends the
+addresses it wants brought in to `out` and the cache fills their lines (marked as
+prefetched). Candidates falling in the demand line itself are ignored.
+*/
+struct Prefetcher
+{
+    enum class Outcome : std::uint8_t {
+        miss,          // demand miss
+        hit,           // demand hit on a line the program brought in itself
+        prefetch_hit   // first demand hit on a prefetched line
+    };
+
+    struct Access
+    {
+        std::uint32_t addr;
+        std::uint32_t pc;         // issuing load/store, MemoryBus::no_pc for fetches
+        std::uint32_t line_bytes;
+        Outcome       outcome;
+    };
+
+    virtual void on_access(const Access& a, std::vector<std::uint32_t>& out) = 0;
+    virtual ~Prefetcher() = default;
+};
+
+/*
+Next-N-line (tagged) prefetcher: on a miss, or on the first use of a prefetched
+line, fetch the following `degree` lines.
+*/
+class NextLinePrefetcher : public Prefetcher
+{
+  public:
+    explicit NextLinePrefetcher(std::size_t degree = 1) : degree_{degree} {}
+
+    void on_access(const Access& a, std::vector<std::uint32_t>& out) override
+    {
+        if (a.outcome == Outcome::hit) return;
+        for (std::size_t i = 1; i <= degree_; ++i)
+            out.push_back(a.addr + static_cast<std::uint32_t>(i) * a.line_bytes);
+    }
+
+  private:
+    std::size_t degree_;
+};
+
+/*
+PC-indexed stride prefetcher (Chen & Baer reference prediction table).
+Each load/store pc owns one entry tracking its last address and stride; once the
+same stride is seen twice in a row the entry is steady and prefetches `degree`
+steps ahead, where a step is the stride rounded up to at least one line.
+Instruction fetches (no pc) are ignored.
+*/
+class StridePrefetcher : public Prefetcher
+{
+  public:
+    explicit StridePrefetcher(std::size_t degree = 2) : degree_{degree} {}
+
+    void on_access(const Access& a, std::vector<std::uint32_t>& out) override
+    {
+        if (a.pc == MemoryBus::no_pc) return;
+        Entry& e = table_[(a.pc >> 2) & (table_size - 1)];
+        if (!e.valid || e.pc != a.pc) {
+            e = Entry{ a.pc, a.addr, 0, State::initial, true };
+            return;
+        }
+
+        const auto stride  = static_cast<std::int32_t>(a.addr - e.last);
+        const bool correct = stride == e.stride;
+        switch (e.state) {
+          case State::initial:   e.state = correct ? State::steady    : State::transient; break;
+          case State::transient: e.state = correct ? State::steady    : State::no_pred;   break;
+          case State::steady:    e.state = correct ? State::steady    : State::initial;   break;
+          case State::no_pred:   e.state = correct ? State::transient : State::no_pred;   break;
+        }
+        if (!correct && e.state != State::initial) e.stride = stride; // steady keeps its stride once
+        e.last = a.addr;
+
+        if (e.state != State::steady || e.stride == 0) return;
+        const auto mag  = static_cast<std::uint32_t>(e.stride < 0 ? -e.stride : e.stride);
+        const auto step = e.stride * static_cast<std::int32_t>(mag < a.line_bytes ? (a.line_bytes + mag - 1) / mag : 1);
+        for (std::size_t i = 1; i <= degree_; ++i)
+            out.push_back(a.addr + static_cast<std::uint32_t>(step * static_cast<std::int32_t>(i)));
+    }
+
+  private:
+    enum class State : std::uint8_t { initial, transient, steady, no_pred };
+
+    struct Entry
+    {
+        std::uint32_t pc{0};
+        std::uint32_t last{0};
+        std::int32_t  stride{0};
+        State         state{State::initial};
+        bool          valid{false};
+    };
+
+    static constexpr std::size_t table_size = 64;
+
+    std::size_t                      degree_;
+    std::array<Entry, table_size>    table_{};
+};
+
+/*
+Stream prefetcher: a handful of stream trackers, each allocated on a miss.
+A second miss next to a tracker confirms its direction; from then on the tracker
+keeps `depth` lines ahead of the demand stream, advancing as the program consumes them.
+(Lines are installed straight into the cache rather than held in side buffers.)
+*/
+class StreamPrefetcher : public Prefetcher
+{
+  public:
+    explicit StreamPrefetcher(std::size_t streams = 4, std::size_t depth = 4)
+        : streams_(streams), depth_{static_cast<std::int64_t>(depth)} {}
+
+    void on_access(const Access& a, std::vector<std::uint32_t>& out) override
+    {
+        ++clock_;
+        const auto o = a.outcome;
+        const auto l = static_cast<std::int64_t>(a.addr / a.line_bytes);
+
+        for (auto& s : streams_) {
+            if (!s.valid) continue;
+
+            if (s.dir != 0) { // active: is the demand line inside [last, front]?
+                const auto ahead = (s.front - l) * s.dir;
+                if (ahead < 0 || ahead > depth_) continue;
+                s.last  = l;
+                s.stamp = clock_;
+                advance(s, a.line_bytes, out);
+                return;
+            }
+            if (o != Outcome::miss) continue;
+            if (const auto d = l - s.last; d == 1 || d == -1) { // training: confirm direction
+                s.dir   = d;
+                s.last  = l;
+                s.front = l;
+                s.stamp = clock_;
+                advance(s, a.line_bytes, out);
+                return;
+            }
+        }
+
+        if (o != Outcome::miss || streams_.empty()) return;
+        Stream* victim = &streams_.front(); // allocate over the least recently used tracker
+        for (auto& s : streams_) {
+            if (!s.valid) { victim = &s; break; }
+            if (s.stamp < victim->stamp) victim = &s;
+        }
+        *victim = Stream{ l, l, 0, clock_, true };
+    }
+
+  private:
+    struct Stream
+    {
+        std::int64_t  last{0};   // most recent demand line
+        std::int64_t  front{0};  // furthest line already prefetched
+        std::int64_t  dir{0};    // +1 / -1 once confirmed, 0 while training
+        std::uint64_t stamp{0};
+        bool          valid{false};
+    };
+
+    void advance(Stream& s, std::uint32_t line_bytes, std::vector<std::uint32_t>& out) const
+    {
+        const auto target = s.last + s.dir * depth_;
+        while ((target - s.front) * s.dir > 0) {
+            s.front += s.dir;
+            if (s.front >= 0) out.push_back(static_cast<std::uint32_t>(s.front) * line_bytes);
+        }
+    }
+
+    std::vector<Stream> streams_;
+    std::int64_t        depth_;
+    std::uint64_t       clock_{0};
+};
+
+} // namespace rv
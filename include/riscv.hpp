@@ -9,6 +9,9 @@
 
 namespace rv {
 
+class FlightRecorder;
+class ExecTraceWriter;
+
 /*
 Instruction decoder
 */
@@ -21,21 +24,90 @@ Instruction decoder
 
 /*
 CPU core
+
+RV32I plus Zicsr and the machine-mode interrupt architecture: mstatus.MIE/MPIE, mie/mip
+with the software (3), timer (7) and external (11) lines, mtvec (direct or vectored),
+mepc/mcause, MRET and WFI. Devices drive the lines through set_timer_compare() and
+set_*_irq(); all of these, like step(), belong to the thread that runs the CPU.
+
+Interrupts cost the fast path one compare: step() only looks at them once instret()
+reaches check_at_, which is "now" when something may be deliverable, the cycle the
+timer fires otherwise, and never when nothing is armed.
 */
 class RiscV
 {
   public:
+    /* mip/mie bits and mstatus bits */
+    static constexpr std::uint32_t mip_msip = 1u << 3, mip_mtip = 1u << 7, mip_meip = 1u << 11;
+    static constexpr std::uint32_t mstatus_mie = 1u << 3, mstatus_mpie = 1u << 7;
+
     explicit RiscV(MemoryBus& m) : mem_{m} {}
 
     void step();
     [[nodiscard]] std::uint32_t pc() const noexcept { return pc_; }
     [[nodiscard]] std::uint32_t reg(std::size_t i) const noexcept { return regs_[i]; }
     [[nodiscard]] MemoryBus& mem() noexcept { return mem_; }
+    /* instructions retired so far (a step that throws does not count) */
+    [[nodiscard]] std::uint64_t instret() const noexcept { return instret_; }
+    /* emulated cycles: one per retired instruction plus those let pass by idle(); mtime reads this */
+    [[nodiscard]] std::uint64_t cycle() const noexcept { return instret_ + idle_; }
+
+    /* CSR as the guest would read it; throws std::runtime_error for CSRs the core lacks */
+    [[nodiscard]] std::uint32_t read_csr(std::uint16_t num) const;
+
+    /* the timer interrupt is pending while cycle() >= compare (CLINT mtimecmp) */
+    void set_timer_compare(std::uint64_t compare) noexcept;
+    [[nodiscard]] std::uint64_t timer_compare() const noexcept { return mtimecmp_; }
+    /* levels of the external and software interrupt lines */
+    void set_external_irq(bool level) noexcept;
+    void set_software_irq(bool level) noexcept;
+
+    /* stopped in WFI with no enabled interrupt pending: step() does nothing until one is */
+    [[nodiscard]] bool waiting() const noexcept { return waiting_ && !(mip() & mie_); }
+    /* cycles until the timer interrupt could wake the hart (UINT64_MAX if it can't) */
+    [[nodiscard]] std::uint64_t cycles_to_timer() const noexcept;
+    /* let `n` cycles pass without executing, e.g. while waiting() */
+    void idle(std::uint64_t n) noexcept;
+
+    /*
+    Execute until `max_instructions` retire or cycle() reaches `deadline`. While waiting(),
+    time skips to the timer interrupt (or the deadline) instead of spinning, so an idle
+    guest costs the host nothing. Returns the instructions retired; step()'s exceptions
+    propagate.
+    */
+    std::uint64_t run(std::uint64_t max_instructions, std::uint64_t deadline);
+
+    /* record each retired instruction into a ring / stream it to disk (not owned; nullptr detaches) */
+    void attach_flight_recorder(FlightRecorder* fr) noexcept { flight_ = fr; }
+    void attach_trace_writer(ExecTraceWriter* tw) noexcept { stream_ = tw; }
 
   private:
+    static constexpr std::uint64_t never = ~std::uint64_t{ 0 };
+
     std::array<std::uint32_t,32> regs_{};
     std::uint32_t pc_{0};
+    std::uint64_t instret_{0};
+    std::uint64_t idle_{0};
     MemoryBus& mem_;
+    FlightRecorder*  flight_{nullptr};
+    ExecTraceWriter* stream_{nullptr};
+
+    // machine-mode state
+    std::uint32_t mstatus_{0}, mie_{0}, lines_{0}; // lines_: MSIP/MEIP as driven by devices
+    std::uint32_t mtvec_{0}, mscratch_{0}, mepc_{0}, mcause_{0}, mtval_{0};
+    std::uint64_t mtimecmp_{never};
+    std::uint64_t check_at_{never};
+    bool          waiting_{false};
+
+    [[nodiscard]] std::uint32_t mip() const noexcept
+    { return lines_ | (cycle() >= mtimecmp_ ? mip_mtip : 0); }
+
+    bool poll_interrupts();
+    void rearm() noexcept;
+    void system(const IType& d);
+    void write_csr(std::uint16_t num, std::uint32_t v);
+
+    void retire(std::uint32_t pc, std::uint32_t raw, std::uint32_t addr);
 
     void write_reg(std::uint8_t rd, std::uint32_t v) noexcept
     { if (rd) regs_[rd]=v; }
@@ -52,6 +52,12 @@ struct Decoder<Opcode::LOAD> : Decoder<Opcode::OP_IMM> {}; // same layout
 template <>
 struct Decoder<Opcode::JALR> : Decoder<Opcode::OP_IMM> {}; // same layout
 
+template <>
+struct Decoder<Opcode::MISC_MEM> : Decoder<Opcode::OP_IMM> {}; // FENCE: pred/succ live in imm
+
+template <>
+struct Decoder<Opcode::SYSTEM> : Decoder<Opcode::OP_IMM> {}; // CSR number (or MRET/WFI) in imm[11:0]
+
 template <>
 struct Decoder<Opcode::STORE>
 {
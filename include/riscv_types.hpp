@@ -20,6 +20,18 @@ enum class Opcode : std::uint8_t {
     AUIPC  = 0b0010111,
     JAL    = 0b1101111,
     JALR   = 0b1100111,
+    MISC_MEM = 0b0001111, // FENCE
+    SYSTEM = 0b1110011,   // CSR access, MRET, WFI
+};
+
+/* machine-mode CSRs the CPU implements (Zicsr numbering) */
+enum class Csr : std::uint16_t {
+    mstatus  = 0x300, misa    = 0x301, mie      = 0x304, mtvec    = 0x305,
+    mscratch = 0x340, mepc    = 0x341, mcause   = 0x342, mtval    = 0x343, mip = 0x344,
+    mcycle   = 0xB00, minstret = 0xB02, mcycleh = 0xB80, minstreth = 0xB82,
+    cycle    = 0xC00, time    = 0xC01, instret  = 0xC02,
+    cycleh   = 0xC80, timeh   = 0xC81, instreth = 0xC82,
+    mhartid  = 0xF14,
 };
 
 struct RType { std::uint8_t rd, rs1, rs2, funct3, funct7; };
@@ -2,15 +2,20 @@
 #pragma once
 #include <algorithm>
 #include <array>
+#include <charconv>
 #include <cstdint>
+#include <exception>
 #include <format>
+#include <optional>
+#include <stdexcept>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
-#define CTRE_ENABLE_LITERALS
-#include <ctre.hpp>           // CTRE v3.10.4 single header   
+#include "mapped_file.hpp"
 #include "riscv_types.hpp"
 
 namespace rv {
@@ -18,26 +23,57 @@ namespace rv {
 /* ------------------------------------------------------------------ */
 /* 1. helpers                                                         */
 /* ------------------------------------------------------------------ */
-constexpr std::array reg_names{
+inline constexpr std::array reg_names{
     "x0","x1","x2","x3","x4","x5","x6","x7",
     "x8","x9","x10","x11","x12","x13","x14","x15",
     "x16","x17","x18","x19","x20","x21","x22","x23",
     "x24","x25","x26","x27","x28","x29","x30","x31"
 };
 
+/* index of "x0".."x31" in reg_names, parsed rather than searched */
 constexpr std::uint8_t regnum(std::string_view s)
 {
-    auto it = std::find(reg_names.begin(), reg_names.end(), s);
-    if (it == reg_names.end())
-        throw std::invalid_argument(std::format("bad reg '{}'", s));
-    return static_cast<std::uint8_t>(it - reg_names.begin());
+    const bool digits = s.size() >= 2 && s.size() <= 3 && s[0] == 'x' &&
+                        std::all_of(s.begin() + 1, s.end(), [](char c){ return c >= '0' && c <= '9'; });
+    if (digits && (s.size() == 2 || s[1] != '0')) {
+        const int n = s.size() == 2 ? s[1] - '0' : (s[1] - '0') * 10 + (s[2] - '0');
+        if (n < 32) return static_cast<std::uint8_t>(n);
+    }
+    throw std::invalid_argument(std::format("bad reg '{}'", s));
+}
+
+/* CSR names the assembler accepts in place of a number */
+struct CsrName { std::string_view name; Csr num; };
+inline constexpr std::array csr_names{
+    CsrName{"mstatus", Csr::mstatus},   CsrName{"misa", Csr::misa},         CsrName{"mie", Csr::mie},
+    CsrName{"mtvec", Csr::mtvec},       CsrName{"mscratch", Csr::mscratch}, CsrName{"mepc", Csr::mepc},
+    CsrName{"mcause", Csr::mcause},     CsrName{"mtval", Csr::mtval},       CsrName{"mip", Csr::mip},
+    CsrName{"mcycle", Csr::mcycle},     CsrName{"minstret", Csr::minstret}, CsrName{"mcycleh", Csr::mcycleh},
+    CsrName{"minstreth", Csr::minstreth}, CsrName{"cycle", Csr::cycle},     CsrName{"time", Csr::time},
+    CsrName{"instret", Csr::instret},   CsrName{"cycleh", Csr::cycleh},     CsrName{"timeh", Csr::timeh},
+    CsrName{"instreth", Csr::instreth}, CsrName{"mhartid", Csr::mhartid},
+};
+
+/* a CSR by name or by decimal number below 4096 */
+constexpr std::int32_t csrnum(std::string_view s)
+{
+    for (const auto& c : csr_names)
+        if (c.name == s) return static_cast<std::int32_t>(c.num);
+    if (!s.empty() && s.size() <= 4 && std::all_of(s.begin(), s.end(), [](char c){ return c >= '0' && c <= '9'; })) {
+        std::int32_t n = 0;
+        for (char c : s) n = n * 10 + (c - '0');
+        if (n < 4096) return n;
+    }
+    throw std::invalid_argument(std::format("bad csr '{}'", s));
 }
 
-/* RISC-V bit-pack helpers (R/I/S/B) --------------------------------- */
+/* RISC-V bit-pack helpers (R/I/S/B/U/J) ----------------------------- */
 struct EncR { std::uint8_t rd, rs1, rs2, f3, f7; };
 struct EncI { std::uint8_t rd, rs1, f3; std::int32_t imm; };
 struct EncS { std::uint8_t rs2, rs1, f3; std::int32_t imm; };
 struct EncB { std::uint8_t rs2, rs1, f3; std::int32_t imm; };
+struct EncU { std::uint8_t rd; std::int32_t imm20; };
+struct EncJ { std::uint8_t rd; std::int32_t imm; };
 
 constexpr std::uint32_t R(const EncR& e, Opcode opc) noexcept
 {
@@ -64,126 +100,475 @@ constexpr std::uint32_t B(const EncB& e, Opcode opc) noexcept
            (static_cast<std::uint32_t>(e.f3 << 12)) | static_cast<std::uint32_t>(opc);
 }
 
+constexpr std::uint32_t U(const EncU& e, Opcode opc) noexcept
+{
+    return (static_cast<std::uint32_t>(e.imm20) << 12) | (static_cast<std::uint32_t>(e.rd << 7)) |
+           static_cast<std::uint32_t>(opc);
+}
+
+constexpr std::uint32_t J(const EncJ& e, Opcode opc) noexcept
+{
+    const std::uint32_t imm = static_cast<std::uint32_t>(e.imm) & 0x1FFFFF;
+    return ((imm & 0x100000) << 11) | ((imm & 0x7FE) << 20) |
+           ((imm & 0x800) << 9)     | (imm & 0xFF000)       |
+           (static_cast<std::uint32_t>(e.rd << 7)) | static_cast<std::uint32_t>(opc);
+}
+
 /* ------------------------------------------------------------------ */
-/* 2.  assemble a single line                                         */
+/* 2. mnemonic table and its compile-time perfect hash                */
 /* ------------------------------------------------------------------ */
-inline std::optional<std::uint32_t>
-assemble_line(std::string_view ln,
-              std::size_t       pc,
-              const std::unordered_map<std::string,std::size_t>& labels)
-{
-    /* ---- R-type: add / sub ------------------------------------- */
-    if (auto m = ctre::match<"add\\s+(\\w+),\\s*(\\w+),\\s*(\\w+)">(ln))
-        return R({ regnum(m.get<1>()), regnum(m.get<2>()), regnum(m.get<3>()),
-                   0b000, 0b0000000 }, Opcode::OP);
-
-    if (auto m = ctre::match<"sub\\s+(\\w+),\\s*(\\w+),\\s*(\\w+)">(ln))
-        return R({ regnum(m.get<1>()), regnum(m.get<2>()), regnum(m.get<3>()),
-                   0b000, 0b0100000 }, Opcode::OP);
-
-    /* ---- I-type ------------------------------------------------- */
-    if (auto m = ctre::match<"addi\\s+(\\w+),\\s*(\\w+),\\s*(-?\\d+)">(ln))
-        return I({ regnum(m.get<1>()), regnum(m.get<2>()), 0b000,
-                   std::stoi(std::string{m.get<3>()}) }, Opcode::OP_IMM);
-    
-    // jalr rd, rs1, imm
-    if (auto m = ctre::match<"jalr\\s+(\\w+),\\s*(\\w+),\\s*(-?\\d+)">(ln))
-        return I({ regnum(m.get<1>()), regnum(m.get<2>()), 0b000,
-                   std::stoi(std::string{m.get<3>()}) },
-                Opcode::JALR);
-
-    if (auto m = ctre::match<"lw\\s+(\\w+),\\s*(-?\\d+)\\(\\s*(\\w+)\\s*\\)">(ln))
-        return I({ regnum(m.get<1>()), regnum(m.get<3>()), 0b010,
-                   std::stoi(std::string{m.get<2>()}) }, Opcode::LOAD);
-
-    if (auto m = ctre::match<"jalr\\s+(\\w+),\\s*(-?\\d+)\\(\\s*(\\w+)\\s*\\)">(ln))
-        return I({ regnum(m.get<1>()), regnum(m.get<3>()), 0b000,
-                   std::stoi(std::string{m.get<2>()}) }, Opcode::JALR);
-
-    /* ---- S-type ------------------------------------------------- */
-    if (auto m = ctre::match<"sw\\s+(\\w+),\\s*(-?\\d+)\\(\\s*(\\w+)\\s*\\)">(ln))
-        return S({ regnum(m.get<1>()), regnum(m.get<3>()), 0b010,
-                   std::stoi(std::string{m.get<2>()}) }, Opcode::STORE);
-
-    /* ---- B-type ------------------------------------------------- */
-    if (auto m = ctre::match<"bne\\s+(\\w+),\\s*(\\w+),\\s*(\\w+)">(ln)) {
-        auto tgt = labels.at(std::string{m.get<3>()});
-        std::int32_t off = static_cast<std::int32_t>(tgt) -
-                           static_cast<std::int32_t>(pc);
-        return B({ regnum(m.get<2>()), regnum(m.get<1>()), 0b001, off },
-                 Opcode::BRANCH);
+/* operand shapes: which operands follow the mnemonic */
+enum class Form : std::uint8_t {
+    rrr,        // rd, rs1, rs2
+    rri,        // rd, rs1, imm        (signed)
+    shift,      // rd, rs1, shamt      (unsigned, funct7 in imm[11:5])
+    jalr,       // rd, rs1, imm   or   rd, imm(rs1)
+    mem_load,   // rd, imm(rs1)
+    mem_store,  // rs2, imm(rs1)
+    upper,      // rd, imm20           (unsigned)
+    branch,     // rs1, rs2, label
+    jump,       // rd, label
+    csr,        // rd, csr, rs1        (csr: name or number)
+    csri,       // rd, csr, uimm5
+    bare,       // no operands; the whole imm[11:0] is fixed
+};
+
+struct Mnemonic { std::string_view name; Form form; Opcode opc; std::uint8_t f3, f7; std::uint16_t imm = 0; };
+
+inline constexpr std::array mnemonics{
+    Mnemonic{"add",  Form::rrr,   Opcode::OP,     0b000, 0b0000000}, Mnemonic{"sub",   Form::rrr,   Opcode::OP,     0b000, 0b0100000},
+    Mnemonic{"sll",  Form::rrr,   Opcode::OP,     0b001, 0b0000000}, Mnemonic{"slt",   Form::rrr,   Opcode::OP,     0b010, 0b0000000},
+    Mnemonic{"sltu", Form::rrr,   Opcode::OP,     0b011, 0b0000000}, Mnemonic{"xor",   Form::rrr,   Opcode::OP,     0b100, 0b0000000},
+    Mnemonic{"srl",  Form::rrr,   Opcode::OP,     0b101, 0b0000000}, Mnemonic{"sra",   Form::rrr,   Opcode::OP,     0b101, 0b0100000},
+    Mnemonic{"or",   Form::rrr,   Opcode::OP,     0b110, 0b0000000}, Mnemonic{"and",   Form::rrr,   Opcode::OP,     0b111, 0b0000000},
+    Mnemonic{"addi", Form::rri,   Opcode::OP_IMM, 0b000, 0},         Mnemonic{"slti",  Form::rri,   Opcode::OP_IMM, 0b010, 0},
+    Mnemonic{"sltiu",Form::rri,   Opcode::OP_IMM, 0b011, 0},         Mnemonic{"xori",  Form::rri,   Opcode::OP_IMM, 0b100, 0},
+    Mnemonic{"ori",  Form::rri,   Opcode::OP_IMM, 0b110, 0},         Mnemonic{"andi",  Form::rri,   Opcode::OP_IMM, 0b111, 0},
+    Mnemonic{"slli", Form::shift, Opcode::OP_IMM, 0b001, 0b0000000}, Mnemonic{"srli",  Form::shift, Opcode::OP_IMM, 0b101, 0b0000000},
+    Mnemonic{"srai", Form::shift, Opcode::OP_IMM, 0b101, 0b0100000}, Mnemonic{"jalr",  Form::jalr,  Opcode::JALR,   0b000, 0},
+    Mnemonic{"lw",   Form::mem_load,  Opcode::LOAD,  0b010, 0},      Mnemonic{"sw",    Form::mem_store, Opcode::STORE, 0b010, 0},
+    Mnemonic{"sb",   Form::mem_store, Opcode::STORE, 0b000, 0},      Mnemonic{"lui",   Form::upper, Opcode::LUI,    0, 0},
+    Mnemonic{"beq",  Form::branch, Opcode::BRANCH, 0b000, 0},        Mnemonic{"bne",   Form::branch, Opcode::BRANCH, 0b001, 0},
+    Mnemonic{"blt",  Form::branch, Opcode::BRANCH, 0b100, 0},        Mnemonic{"bge",   Form::branch, Opcode::BRANCH, 0b101, 0},
+    Mnemonic{"bltu", Form::branch, Opcode::BRANCH, 0b110, 0},        Mnemonic{"bgeu",  Form::branch, Opcode::BRANCH, 0b111, 0},
+    Mnemonic{"jal",  Form::jump,  Opcode::JAL,    0, 0},             Mnemonic{"fence", Form::bare,  Opcode::MISC_MEM, 0, 0, 0x0FF},
+    Mnemonic{"csrrw",  Form::csr,  Opcode::SYSTEM, 0b001, 0},        Mnemonic{"csrrs",  Form::csr,  Opcode::SYSTEM, 0b010, 0},
+    Mnemonic{"csrrc",  Form::csr,  Opcode::SYSTEM, 0b011, 0},        Mnemonic{"csrrwi", Form::csri, Opcode::SYSTEM, 0b101, 0},
+    Mnemonic{"csrrsi", Form::csri, Opcode::SYSTEM, 0b110, 0},        Mnemonic{"csrrci", Form::csri, Opcode::SYSTEM, 0b111, 0},
+    Mnemonic{"mret",   Form::bare, Opcode::SYSTEM, 0, 0, 0x302},     Mnemonic{"wfi",    Form::bare, Opcode::SYSTEM, 0, 0, 0x105},
+};
+
+namespace detail {
+
+inline constexpr std::size_t mnemonic_slots = 256;
+inline constexpr std::size_t max_mnemonic   = 6;
+
+/* FNV-1a from `seed`; the top 8 bits pick the slot */
+constexpr std::size_t mnemonic_slot(std::string_view s, std::uint32_t seed) noexcept
+{
+    std::uint32_t h = seed;
+    for (char c : s) h = (h ^ static_cast<unsigned char>(c)) * 16777619u;
+    return h >> 24;
+}
+
+/* first seed that puts every mnemonic in its own slot */
+consteval std::uint32_t perfect_seed()
+{
+    for (std::uint32_t seed = 2166136261u;; ++seed) {
+        std::array<bool, mnemonic_slots> used{};
+        bool ok = true;
+        for (const auto& m : mnemonics) ok = ok && !std::exchange(used[mnemonic_slot(m.name, seed)], true);
+        if (ok) return seed;
     }
+}
+inline constexpr std::uint32_t mnemonic_seed = perfect_seed();
+
+/* slot -> index into mnemonics + 1 (0 = empty) */
+consteval std::array<std::uint8_t, mnemonic_slots> build_mnemonic_table()
+{
+    std::array<std::uint8_t, mnemonic_slots> t{};
+    for (std::size_t i = 0; i < mnemonics.size(); ++i)
+        t[mnemonic_slot(mnemonics[i].name, mnemonic_seed)] = static_cast<std::uint8_t>(i + 1);
+    return t;
+}
+inline constexpr auto mnemonic_table = build_mnemonic_table();
+
+} // namespace detail
+
+/* one hash, one table load, one compare */
+[[nodiscard]] constexpr const Mnemonic* find_mnemonic(std::string_view s) noexcept
+{
+    if (s.empty() || s.size() > detail::max_mnemonic) return nullptr;
+    const std::uint8_t i = detail::mnemonic_table[detail::mnemonic_slot(s, detail::mnemonic_seed)];
+    return i && mnemonics[i - 1].name == s ? &mnemonics[i - 1] : nullptr;
+}
 
-    if (auto m = ctre::match<"beq\\s+(\\w+),\\s*(\\w+),\\s*(\\w+)">(ln)) {
-        auto tgt = labels.at(std::string{m.get<3>()});
-        std::int32_t off = static_cast<std::int32_t>(tgt) -
-                           static_cast<std::int32_t>(pc);
-        return B({ regnum(m.get<2>()), regnum(m.get<1>()), 0b000, off },
-                 Opcode::BRANCH);
+/* ------------------------------------------------------------------ */
+/* 3. tokenizer                                                       */
+/* ------------------------------------------------------------------ */
+namespace detail {
+
+constexpr bool is_word(char c) noexcept
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+constexpr bool is_space(char c) noexcept { return c == ' ' || c == '\t' || c == '\v' || c == '\f'; }
+constexpr bool is_digit(char c) noexcept { return c >= '0' && c <= '9'; }
+
+/* cursor over one trimmed, comment-free line; every take_* returns false on a shape mismatch */
+struct Tokens
+{
+    std::string_view s;
+    std::size_t      p = 0;
+
+    constexpr bool at_end() const noexcept { return p == s.size(); }
+
+    constexpr std::size_t spaces() noexcept
+    {
+        const std::size_t b = p;
+        while (p < s.size() && is_space(s[p])) ++p;
+        return p - b;
+    }
+    constexpr bool take(char c) noexcept
+    {
+        if (p < s.size() && s[p] == c) { ++p; return true; }
+        return false;
+    }
+    constexpr bool word(std::string_view& out) noexcept
+    {
+        const std::size_t b = p;
+        while (p < s.size() && is_word(s[p])) ++p;
+        out = s.substr(b, p - b);
+        return p != b;
+    }
+    /* -?\d+ (or \d+ when !sign) */
+    constexpr bool number(std::string_view& out, bool sign) noexcept
+    {
+        const std::size_t b = p;
+        if (sign && p < s.size() && s[p] == '-') ++p;
+        const std::size_t d = p;
+        while (p < s.size() && is_digit(s[p])) ++p;
+        out = s.substr(b, p - b);
+        if (p == d) { p = b; return false; }
+        return true;
     }
+    /* ",\s*" between operands */
+    constexpr bool comma() noexcept
+    {
+        if (!take(',')) return false;
+        spaces();
+        return true;
+    }
+    /* imm(reg) with optional spaces inside the parentheses */
+    constexpr bool mem(std::string_view& imm, std::string_view& reg) noexcept
+    {
+        if (!number(imm, true) || !take('(')) return false;
+        spaces();
+        if (!word(reg)) return false;
+        spaces();
+        return take(')');
+    }
+};
+
+constexpr std::int32_t to_int(std::string_view s)
+{
+    if consteval {
+        // std::from_chars is not constexpr everywhere yet
+        const bool neg = s.front() == '-';
+        std::int64_t v = 0;
+        for (char c : s.substr(neg ? 1 : 0)) {
+            v = v * 10 + (c - '0');
+            if (v > std::int64_t{1} << 31) throw std::out_of_range("immediate out of range");
+        }
+        v = neg ? -v : v;
+        if (v > 0x7FFF'FFFF) throw std::out_of_range("immediate out of range");
+        return static_cast<std::int32_t>(v);
+    } else {
+        std::int32_t v = 0;
+        const auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), v);
+        if (ec != std::errc{} || end != s.data() + s.size())
+            throw std::out_of_range(std::format("immediate '{}' out of range", s));
+        return v;
+    }
+}
+
+} // namespace detail
+
+/* ------------------------------------------------------------------ */
+/* 4.  assemble a single line                                         */
+/* ------------------------------------------------------------------ */
+/*
+Encode one trimmed, comment-free instruction line at `pc`. `label(name)` returns a
+label's address (and throws if there is none). Returns nullopt if the line has no
+instruction shape; bad registers and immediates throw.
+*/
+template <class LabelFn>
+constexpr std::optional<std::uint32_t> assemble_line(std::string_view ln, std::size_t pc, LabelFn&& label)
+{
+    detail::Tokens t{ ln };
+    std::string_view mn, a, b, c;
+    if (!t.word(mn)) return std::nullopt;
+    const Mnemonic* m = find_mnemonic(mn);
+    if (!m) return std::nullopt;
+    if (m->form == Form::bare) {
+        if (!t.at_end()) return std::nullopt;
+        return I({ 0, 0, 0b000, m->imm }, m->opc); // fence iorw,iorw / mret / wfi
+    }
+    if (!t.spaces() || !t.word(a) || !t.comma()) return std::nullopt;
+
+    const auto offset = [&](std::string_view name) {
+        return static_cast<std::int32_t>(label(name)) - static_cast<std::int32_t>(pc);
+    };
+
+    switch (m->form) {
+      case Form::rrr:
+        if (!t.word(b) || !t.comma() || !t.word(c) || !t.at_end()) return std::nullopt;
+        return R({ regnum(a), regnum(b), regnum(c), m->f3, m->f7 }, m->opc);
+
+      case Form::rri:
+        if (!t.word(b) || !t.comma() || !t.number(c, true) || !t.at_end()) return std::nullopt;
+        return I({ regnum(a), regnum(b), m->f3, detail::to_int(c) }, m->opc);
+
+      case Form::shift:
+        if (!t.word(b) || !t.comma() || !t.number(c, false) || !t.at_end()) return std::nullopt;
+        return I({ regnum(a), regnum(b), m->f3, (detail::to_int(c) & 31) | (m->f7 << 5) }, m->opc);
+
+      case Form::jalr: {
+        const std::size_t mark = t.p;
+        if (t.mem(c, b) && t.at_end()) // jalr rd, imm(rs1)
+            return I({ regnum(a), regnum(b), m->f3, detail::to_int(c) }, m->opc);
+        t.p = mark;                    // jalr rd, rs1, imm
+        if (!t.word(b) || !t.comma() || !t.number(c, true) || !t.at_end()) return std::nullopt;
+        return I({ regnum(a), regnum(b), m->f3, detail::to_int(c) }, m->opc);
+      }
 
-    /* ---- no pattern matched ------------------------------------ */
+      case Form::mem_load:
+        if (!t.mem(c, b) || !t.at_end()) return std::nullopt;
+        return I({ regnum(a), regnum(b), m->f3, detail::to_int(c) }, m->opc);
+
+      case Form::mem_store:
+        if (!t.mem(c, b) || !t.at_end()) return std::nullopt;
+        return S({ regnum(a), regnum(b), m->f3, detail::to_int(c) }, m->opc);
+
+      case Form::upper:
+        if (!t.number(c, false) || !t.at_end()) return std::nullopt;
+        return U({ regnum(a), detail::to_int(c) & 0xFFFFF }, m->opc);
+
+      case Form::branch:
+        if (!t.word(b) || !t.comma() || !t.word(c) || !t.at_end()) return std::nullopt;
+        return B({ regnum(b), regnum(a), m->f3, offset(c) }, m->opc);
+
+      case Form::jump:
+        if (!t.word(b) || !t.at_end()) return std::nullopt;
+        return J({ regnum(a), offset(b) }, m->opc);
+
+      case Form::csr:
+        if (!t.word(b) || !t.comma() || !t.word(c) || !t.at_end()) return std::nullopt;
+        return I({ regnum(a), regnum(c), m->f3, csrnum(b) }, m->opc);
+
+      case Form::csri: {
+        if (!t.word(b) || !t.comma() || !t.number(c, false) || !t.at_end()) return std::nullopt;
+        const std::int32_t uimm = detail::to_int(c);
+        if (uimm > 31) throw std::out_of_range(std::format("csr immediate '{}' out of range", c));
+        return I({ regnum(a), static_cast<std::uint8_t>(uimm), m->f3, csrnum(b) }, m->opc);
+      }
+
+      case Form::bare:
+        break;
+    }
     return std::nullopt;
 }
 
 /* ------------------------------------------------------------------ */
-/* 3.  public driver                                                  */
+/* 5.  public driver                                                  */
 /* ------------------------------------------------------------------ */
-[[nodiscard]]
-inline std::vector<std::uint32_t>
-assemble(std::string_view src)
+namespace detail {
+
+/*
+Pass 1: split lines, strip comments and blanks, record labels (the first definition
+of a name wins). `on_label(name, pc)` and `on_instr(line)` see them in source order.
+*/
+template <class OnLabel, class OnInstr>
+constexpr void scan_lines(std::string_view src, OnLabel&& on_label, OnInstr&& on_instr)
 {
-    /* split lines & strip comments -------------------------------------- */
-    std::vector<std::string_view> lines;
+    std::size_t pc = 0;
     for (std::size_t b = 0, e; b < src.size(); b = e + 1) {
-        e = src.find_first_of("\r\n", b);
-        if (e == std::string_view::npos) e = src.size();
+        e = b;
+        while (e < src.size() && src[e] != '\n' && src[e] != '\r') ++e;
         auto ln = src.substr(b, e - b);
 
         if (auto c = ln.find('#'); c != std::string_view::npos) ln = ln.substr(0, c);
 
         auto first = ln.find_first_not_of(" \t");
-        if (first == std::string_view::npos) { lines.emplace_back(); continue; }
+        if (first == std::string_view::npos) continue;
         auto last = ln.find_last_not_of(" \t");
-        lines.push_back(ln.substr(first, last - first + 1));
+        ln = ln.substr(first, last - first + 1);
+
+        // a label stands alone on its line: \w+:
+        if (ln.size() > 1 && ln.back() == ':' &&
+            std::all_of(ln.begin(), ln.end() - 1, is_word)) {
+            on_label(ln.substr(0, ln.size() - 1), pc);
+            continue;
+        }
+        on_instr(ln);
+        pc += 4;
     }
+}
 
-    /* pass 1: label table ------------------------------------------------ */
-    std::unordered_map<std::string,std::size_t> labels;
-    std::size_t pc = 0;
-    for (auto& ln : lines) {
-        if (ln.empty()) continue;
-
-        if (auto m = ctre::match<R"(^(\w+):)">(ln)) {
-            labels.emplace(std::string{m.get<1>()}, pc);
-            ln.remove_prefix(m.get<0>().to_view().size());
-
-            // set ln to empty if label only
-            if (auto pos = ln.find_first_not_of(" \t");
-                pos != std::string_view::npos)
-                ln.remove_prefix(pos);
-            else
-                ln = {};
+inline constexpr std::size_t parallel_min_lines = 1 << 14; // below this, threads cost more than they save
+
+} // namespace detail
+
+/*
+Assemble `src` into instruction words. Pass 2 encodes chunks of lines on up to
+`threads` threads (0 = hardware concurrency); the result and the error thrown for a
+bad line are the same as a sequential run: the first bad line in source order wins.
+Throws std::runtime_error("syntax error: '<line>'") for lines of no known shape,
+std::invalid_argument for bad registers, std::out_of_range for unknown labels and
+immediates that don't fit 32 bits.
+*/
+[[nodiscard]]
+inline std::vector<std::uint32_t>
+assemble(std::string_view src, unsigned threads)
+{
+    /* pass 1: instruction lines and label table -------------------------- */
+    std::vector<std::string_view> lines;
+    std::unordered_map<std::string_view, std::size_t> labels;
+    detail::scan_lines(src,
+        [&](std::string_view name, std::size_t pc) { labels.emplace(name, pc); },
+        [&](std::string_view ln) { lines.push_back(ln); });
+
+    const auto label = [&](std::string_view name) {
+        auto it = labels.find(name);
+        if (it == labels.end()) throw std::out_of_range(std::format("unknown label '{}'", name));
+        return it->second;
+    };
+
+    /* pass 2: encode lines [b, e); stops at the first bad line and keeps its error */
+    std::vector<std::uint32_t> words(lines.size());
+    const auto encode = [&](std::size_t b, std::size_t e, std::exception_ptr& err) {
+        try {
+            for (std::size_t i = b; i < e; ++i) {
+                auto word = assemble_line(lines[i], i * 4, label);
+                if (!word)
+                    throw std::runtime_error(std::format("syntax error: '{}'", lines[i]));
+                words[i] = *word;
+            }
+        } catch (...) {
+            err = std::current_exception();
         }
-        if (!ln.empty()) pc += 4;
+    };
+
+#ifdef __EMSCRIPTEN__
+    threads = 1;
+#else
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+#endif
+    const std::size_t chunks = std::min<std::size_t>(threads, std::max<std::size_t>(1, lines.size() / detail::parallel_min_lines));
+
+    std::exception_ptr err;
+    if (chunks <= 1) {
+        encode(0, lines.size(), err);
+    } else {
+        std::vector<std::exception_ptr> errs(chunks);
+        {
+            std::vector<std::jthread> pool;
+            for (std::size_t k = 0; k < chunks; ++k)
+                pool.emplace_back([&, k] {
+                    encode(lines.size() * k / chunks, lines.size() * (k + 1) / chunks, errs[k]);
+                });
+        }
+        for (std::size_t k = 0; k < chunks && !err; ++k) err = errs[k]; // chunks are in source order
     }
+    if (err) std::rethrow_exception(err);
+    return words;
+}
+
+[[nodiscard]]
+inline std::vector<std::uint32_t>
+assemble(std::string_view src)
+{
+    return assemble(src, 0);
+}
 
-    /* pass 2: encode ----------------------------------------------------- */
-    std::vector<std::uint32_t> words;
-    words.reserve(pc / 4);
+/* assemble a source file, mapped rather than read */
+[[nodiscard]]
+inline std::vector<std::uint32_t>
+assemble_file(const std::string& path, unsigned threads = 0)
+{
+    const MappedFile f{ path };
+    return assemble(f.text(), threads);
+}
 
-    pc = 0;
-    for (auto const& ln : lines) {
-        if (ln.empty()) continue;
+/* ------------------------------------------------------------------ */
+/* 6.  compile-time assembly                                          */
+/* ------------------------------------------------------------------ */
+/* assembly text usable as a template argument */
+template <std::size_t N>
+struct AsmText
+{
+    char str[N]{};
 
-        auto word = assemble_line(ln, pc, labels);
-        if (!word)
-            throw std::runtime_error(std::format("syntax error: '{}'", ln));
+    consteval AsmText(const char (&s)[N]) { std::copy_n(s, N, str); }
+    constexpr std::string_view view() const noexcept { return { str, N - 1 }; }
+};
 
-        words.push_back(*word);
-        pc += 4;
+namespace detail {
+
+struct LineCounts { std::size_t instrs = 0, labels = 0; };
+
+consteval LineCounts count_lines(std::string_view src)
+{
+    LineCounts n;
+    scan_lines(src, [&](std::string_view, std::size_t) { ++n.labels; },
+                    [&](std::string_view) { ++n.instrs; });
+    return n;
+}
+
+} // namespace detail
+
+/*
+Assemble `Src` during compilation into a std::array of its words, with the same grammar
+and encodings as assemble(). A bad line makes the program ill-formed; the diagnostic
+points at the failing check (syntax, register, label or immediate).
+*/
+template <AsmText Src>
+consteval auto assemble_static()
+{
+    constexpr auto n = detail::count_lines(Src.view());
+
+    std::array<std::pair<std::string_view, std::size_t>, n.labels> labels{};
+    std::array<std::string_view, n.instrs>                           lines{};
+    std::size_t nl = 0, ni = 0;
+    detail::scan_lines(Src.view(),
+        [&](std::string_view name, std::size_t pc) { labels[nl++] = { name, pc }; },
+        [&](std::string_view ln) { lines[ni++] = ln; });
+
+    // first definition wins, as in assemble()
+    const auto label = [&](std::string_view name) {
+        for (const auto& [l, pc] : labels)
+            if (l == name) return pc;
+        throw std::out_of_range("unknown label in _rvasm literal");
+    };
+
+    std::array<std::uint32_t, n.instrs> words{};
+    for (std::size_t i = 0; i < n.instrs; ++i) {
+        const auto word = assemble_line(lines[i], i * 4, label);
+        if (!word) throw std::runtime_error("syntax error in _rvasm literal");
+        words[i] = *word;
     }
     return words;
 }
 
+namespace literals {
+
+/* R"( ... )"_rvasm: a constexpr std::array<std::uint32_t, N> program image */
+template <AsmText Src>
+consteval auto operator""_rvasm()
+{
+    return assemble_static<Src>();
+}
+
+} // namespace literals
+
 } // namespace rv
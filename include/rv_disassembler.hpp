@@ -0,0 +1,122 @@
+// include/rv_disassembler.hpp
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <format>
+#include <string>
+#include <string_view>
+#include <variant>
+
+#include "riscv.hpp"
+#include "rv_assembler.hpp"
+
+namespace rv {
+
+namespace detail {
+
+/* mnemonics the CPU decodes but the assembler doesn't write */
+struct ExtraMnemonic { std::string_view name; Opcode opc; std::uint8_t f3; };
+inline constexpr std::array extra_mnemonics{
+    ExtraMnemonic{"lb",  Opcode::LOAD,  0b000}, ExtraMnemonic{"lh",  Opcode::LOAD, 0b001},
+    ExtraMnemonic{"lbu", Opcode::LOAD,  0b100}, ExtraMnemonic{"lhu", Opcode::LOAD, 0b101},
+    ExtraMnemonic{"sh",  Opcode::STORE, 0b001}, ExtraMnemonic{"auipc", Opcode::AUIPC, 0},
+};
+
+constexpr std::string_view mnemonic_name(Opcode opc, std::uint8_t f3, std::uint8_t f7) noexcept
+{
+    const bool has_f7 = opc == Opcode::OP || (opc == Opcode::OP_IMM && (f3 == 0b001 || f3 == 0b101));
+    const bool has_f3 = opc != Opcode::LUI && opc != Opcode::AUIPC && opc != Opcode::JAL && opc != Opcode::MISC_MEM;
+    for (const auto& m : mnemonics)
+        if (m.opc == opc && (!has_f3 || m.f3 == f3) && (!has_f7 || m.f7 == f7)) return m.name;
+    for (const auto& m : extra_mnemonics)
+        if (m.opc == opc && (!has_f3 || m.f3 == f3)) return m.name;
+    return {};
+}
+
+constexpr bool known_opcode(std::uint32_t opc) noexcept
+{
+    switch (static_cast<Opcode>(opc)) {
+      case Opcode::OP: case Opcode::OP_IMM: case Opcode::LOAD: case Opcode::STORE: case Opcode::BRANCH:
+      case Opcode::LUI: case Opcode::AUIPC: case Opcode::JAL: case Opcode::JALR: case Opcode::MISC_MEM:
+      case Opcode::SYSTEM:
+        return true;
+    }
+    return false;
+}
+
+/* "mstatus" for a named CSR, the decimal number otherwise (both assemble back) */
+inline std::string csr_operand(std::int32_t imm)
+{
+    const auto num = static_cast<std::uint16_t>(imm & 0xFFF);
+    for (const auto& c : csr_names)
+        if (static_cast<std::uint16_t>(c.num) == num) return std::string{ c.name };
+    return std::to_string(num);
+}
+
+} // namespace detail
+
+/*
+One instruction word back in rv_assembler syntax ("addi x1, x0, 11", "sw x2, 32(x0)",
+"jalr x0, x0, 0"). Branch and jal targets, which the assembler takes as labels, print as
+pc-relative byte offsets ("bne x3, x1, -8"). Words that don't decode print as ".word 0x...".
+Never throws on a bad word.
+*/
+[[nodiscard]] inline std::string disassemble(std::uint32_t word)
+{
+    const auto opc  = static_cast<Opcode>(word & 0x7F);
+    const auto word_directive = [&] { return std::format(".word 0x{:08x}", word); };
+    if (!detail::known_opcode(word & 0x7F)) return word_directive();
+
+    const auto r = [](std::uint8_t i) { return std::string_view{ reg_names[i] }; };
+
+    return std::visit([&](const auto& d) -> std::string {
+        using T = std::decay_t<decltype(d)>;
+
+        if constexpr (std::is_same_v<T, RType>) {
+            const auto name = detail::mnemonic_name(opc, d.funct3, d.funct7);
+            if (name.empty()) return word_directive();
+            return std::format("{} {}, {}, {}", name, r(d.rd), r(d.rs1), r(d.rs2));
+        }
+        else if constexpr (std::is_same_v<T, IType>) {
+            if (opc == Opcode::MISC_MEM) return "fence";
+            if (opc == Opcode::SYSTEM) {
+                if (d.funct3 == 0) {
+                    for (const auto& m : mnemonics)
+                        if (m.opc == opc && m.form == Form::bare && m.imm == (d.imm & 0xFFF) && !d.rd && !d.rs1)
+                            return std::string{ m.name };
+                    return word_directive();
+                }
+                const auto name = detail::mnemonic_name(opc, d.funct3, 0);
+                if (name.empty()) return word_directive();
+                if (d.funct3 & 0b100) return std::format("{} {}, {}, {}", name, r(d.rd), detail::csr_operand(d.imm), d.rs1);
+                return std::format("{} {}, {}, {}", name, r(d.rd), detail::csr_operand(d.imm), r(d.rs1));
+            }
+            const bool shift = opc == Opcode::OP_IMM && (d.funct3 == 0b001 || d.funct3 == 0b101);
+            const auto f7    = static_cast<std::uint8_t>(shift ? (d.imm >> 5) & 0x7F : 0);
+            const auto name  = detail::mnemonic_name(opc, d.funct3, f7);
+            if (name.empty()) return word_directive();
+            if (shift)                return std::format("{} {}, {}, {}", name, r(d.rd), r(d.rs1), d.imm & 31);
+            if (opc == Opcode::LOAD)  return std::format("{} {}, {}({})", name, r(d.rd), d.imm, r(d.rs1));
+            return std::format("{} {}, {}, {}", name, r(d.rd), r(d.rs1), d.imm);
+        }
+        else if constexpr (std::is_same_v<T, SType>) {
+            const auto name = detail::mnemonic_name(opc, d.funct3, 0);
+            if (name.empty()) return word_directive();
+            return std::format("{} {}, {}({})", name, r(d.rs2), d.imm, r(d.rs1));
+        }
+        else if constexpr (std::is_same_v<T, BType>) {
+            const auto name = detail::mnemonic_name(opc, d.funct3, 0);
+            if (name.empty()) return word_directive();
+            return std::format("{} {}, {}, {}", name, r(d.rs1), r(d.rs2), d.imm);
+        }
+        else if constexpr (std::is_same_v<T, UType>) {
+            return std::format("{} {}, {}", detail::mnemonic_name(opc, 0, 0), r(d.rd),
+                               static_cast<std::uint32_t>(d.imm) >> 12);
+        }
+        else { // UJType
+            return std::format("jal {}, {}", r(d.rd), d.imm);
+        }
+    }, decode(word));
+}
+
+} // namespace rv
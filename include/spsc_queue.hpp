@@ -0,0 +1,95 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <new>
+#include <optional>
+#include <span>
+#include <type_traits>
+
+namespace rv {
+
+/*
+Bounded lock-free single-producer/single-consumer ring of `N` (a power of two) values.
+One thread may push, one other thread may pop; neither ever blocks or allocates. Each
+side keeps a private copy of the other side's index and reloads it only when the ring
+looks full (producer) or empty (consumer), so the indices' cache lines bounce only then.
+*/
+template <class T, std::size_t N>
+class SpscQueue
+{
+    static_assert(std::has_single_bit(N), "capacity must be a power of two");
+    static_assert(std::is_trivially_copyable_v<T>);
+
+  public:
+    /* producer: false (and nothing stored) if the ring is full */
+    bool try_push(const T& v) noexcept
+    {
+        const std::size_t t = tail_.load(std::memory_order_relaxed);
+        if (t - head_cache_ == N) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (t - head_cache_ == N) return false;
+        }
+        buf_[t & (N - 1)] = v;
+        tail_.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /* consumer: the oldest value, or nullopt if the ring is empty */
+    std::optional<T> try_pop() noexcept
+    {
+        const std::size_t h = head_.load(std::memory_order_relaxed);
+        if (h == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (h == tail_cache_) return std::nullopt;
+        }
+        T v = buf_[h & (N - 1)];
+        head_.store(h + 1, std::memory_order_release);
+        return v;
+    }
+
+    /* producer: push as many of `vs` as fit, in order; returns how many */
+    std::size_t try_push(std::span<const T> vs) noexcept
+    {
+        const std::size_t t = tail_.load(std::memory_order_relaxed);
+        if (N - (t - head_cache_) < vs.size()) head_cache_ = head_.load(std::memory_order_acquire);
+        const std::size_t n = std::min(vs.size(), N - (t - head_cache_));
+        const std::size_t i = t & (N - 1), first = std::min(n, N - i);
+        std::copy_n(vs.begin(), first, buf_.begin() + i);
+        std::copy_n(vs.begin() + first, n - first, buf_.begin());
+        tail_.store(t + n, std::memory_order_release);
+        return n;
+    }
+
+    /* consumer: pop up to out.size() values into `out`, oldest first; returns how many */
+    std::size_t try_pop(std::span<T> out) noexcept
+    {
+        const std::size_t h = head_.load(std::memory_order_relaxed);
+        if (tail_cache_ - h < out.size()) tail_cache_ = tail_.load(std::memory_order_acquire);
+        const std::size_t n = std::min(out.size(), tail_cache_ - h);
+        const std::size_t i = h & (N - 1), first = std::min(n, N - i);
+        std::copy_n(buf_.begin() + i, first, out.begin());
+        std::copy_n(buf_.begin(), n - first, out.begin() + first);
+        head_.store(h + n, std::memory_order_release);
+        return n;
+    }
+
+    /* a snapshot; exact only when called from one of the two sides with the other idle */
+    [[nodiscard]] std::size_t size() const noexcept
+    { return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire); }
+
+    [[nodiscard]] static constexpr std::size_t capacity() noexcept { return N; }
+
+  private:
+    static constexpr std::size_t line = 64;
+
+    alignas(line) std::atomic<std::size_t> head_{ 0 }; // next slot to pop (written by the consumer)
+    std::size_t                            tail_cache_ = 0;
+    alignas(line) std::atomic<std::size_t> tail_{ 0 }; // next slot to fill (written by the producer)
+    std::size_t                            head_cache_ = 0;
+    alignas(line) std::array<T, N>         buf_{};
+};
+
+} // namespace rv
@@ -0,0 +1,309 @@
+#pragma once
+#include "hash_table.hpp"
+#include "memory_bus.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <format>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace rv {
+
+/*
+One-pass LRU stack-distance analyzer (Mattson): the miss count of every cache size from a
+single walk over the access stream.
+
+Fully associative: a line's stack distance is the number of distinct lines touched since
+its previous access. Lines are kept at their last-access time slot in a Fenwick tree, so
+the distance is one prefix count (Bennett-Kruskal), O(log n). Only the `max_lines` most
+recent lines are tracked; a deeper one is dropped (it misses in every cache of interest),
+and time slots are renumbered when the window fills, so memory is bounded by `max_lines`,
+not by trace length or footprint. This gives the exact LRU miss count for 1..max_lines lines.
+
+Set associative: LRU inclusion holds per set, so for each set count (1, 2, 4 .. max_sets)
+every set keeps its `max_ways` most recent lines in move-to-front order; the hit depth
+gives the misses for 1..max_ways ways at once.
+
+Use it in front of a MemoryBus (it counts, then forwards) or feed it with observe().
+Lines are `line_bytes` long (Cache uses 16). Not thread-safe.
+*/
+class StackDistanceAnalyzer : public MemoryBus
+{
+  public:
+    struct Options
+    {
+        std::uint32_t line_bytes = 16;
+        std::size_t   max_lines  = 1 << 14; // deepest fully-associative size
+        std::size_t   max_sets   = 1024;    // set counts 1, 2, 4 .. max_sets (power of two)
+        std::size_t   max_ways   = 16;
+    };
+
+    /* one point of a miss-ratio curve */
+    struct CurvePoint
+    {
+        std::size_t   sets;
+        std::size_t   ways;
+        std::uint64_t bytes;
+        std::uint64_t misses;
+        double        miss_ratio;
+    };
+
+    StackDistanceAnalyzer() : StackDistanceAnalyzer(nullptr, Options{}) {}
+    explicit StackDistanceAnalyzer(Options opt) : StackDistanceAnalyzer(nullptr, opt) {}
+
+    /* `next` may be null: then loads read 0 and only the analysis runs */
+    StackDistanceAnalyzer(std::unique_ptr<MemoryBus> next, Options opt)
+        : opt_{opt},
+          line_shift_{static_cast<unsigned>(std::countr_zero(opt.line_bytes))},
+          window_{std::max<std::size_t>(4 * opt.max_lines, 1024)},
+          tree_(window_ + 1, 0),
+          owner_(window_, no_line),
+          id_slot_(opt.max_lines, 0),
+          id_line_(opt.max_lines, 0),
+          id_of_(2 * opt.max_lines),
+          fa_hist_(opt.max_lines, 0),
+          next_{std::move(next)}
+    {
+        if (!std::has_single_bit(opt.line_bytes) || opt.line_bytes < 4)
+            throw std::invalid_argument(std::format("line size {} is not a power of two >= 4", opt.line_bytes));
+        if (!std::has_single_bit(opt.max_sets) || opt.max_lines == 0 || opt.max_ways == 0)
+            throw std::invalid_argument("StackDistanceAnalyzer: max_sets must be a power of two, max_lines/max_ways > 0");
+
+        for (std::size_t sets = 1; sets <= opt.max_sets; sets *= 2)
+            levels_.push_back({ sets, std::vector<std::uint32_t>(sets * opt.max_ways, no_line),
+                                std::vector<std::uint64_t>(opt.max_ways, 0) });
+    }
+
+    /*
+    MemoryBus
+    */
+    std::optional<std::uint32_t> load_word(std::uint32_t addr) override
+    {
+        observe(addr);
+        return next_ ? next_->load_word(addr) : std::optional<std::uint32_t>{0};
+    }
+    bool store_word(std::uint32_t addr, std::uint32_t v) override
+    {
+        observe(addr);
+        return next_ ? next_->store_word(addr, v) : true;
+    }
+    bool store_block(std::uint32_t addr, std::span<const std::uint32_t> words, std::uint32_t mask = ~0u) override
+    {
+        for (std::size_t i = 0; i < words.size(); ++i)
+            if (mask & (1u << i)) observe(addr + static_cast<std::uint32_t>(i * 4));
+        return next_ ? next_->store_block(addr, words, mask) : true;
+    }
+    void set_pc(std::uint32_t pc) noexcept override { if (next_) next_->set_pc(pc); }
+    void fence() override { if (next_) next_->fence(); }
+
+    /* count one access to the line holding `addr` */
+    void observe(std::uint32_t addr)
+    {
+        const std::uint32_t line = addr >> line_shift_;
+        ++accesses_;
+        observe_fa(line);
+        for (auto& lv : levels_) observe_set(lv, line);
+    }
+
+    /*
+    results
+    */
+    [[nodiscard]] std::uint64_t accesses() const noexcept { return accesses_; }
+
+    /* first touches plus reuses deeper than max_lines: misses in every fully-associative size */
+    [[nodiscard]] std::uint64_t deep_misses() const noexcept { return deep_; }
+
+    /* misses of a fully-associative LRU cache of `lines` lines (1..max_lines) */
+    [[nodiscard]] std::uint64_t fa_misses(std::size_t lines) const
+    {
+        if (lines == 0 || lines > opt_.max_lines)
+            throw std::out_of_range(std::format("fully-associative size {} outside 1..{}", lines, opt_.max_lines));
+        std::uint64_t hits = 0;
+        for (std::size_t d = 0; d < lines; ++d) hits += fa_hist_[d];
+        return accesses_ - hits;
+    }
+
+    /* misses of a `sets` x `ways` LRU cache (sets a power of two <= max_sets, ways <= max_ways) */
+    [[nodiscard]] std::uint64_t misses(std::size_t sets, std::size_t ways) const
+    {
+        if (!std::has_single_bit(sets) || sets > opt_.max_sets || ways == 0 || ways > opt_.max_ways)
+            throw std::out_of_range(std::format("no curve for {} sets x {} ways", sets, ways));
+        const auto& hist = levels_[static_cast<std::size_t>(std::countr_zero(sets))].hist;
+        std::uint64_t hits = 0;
+        for (std::size_t d = 0; d < ways; ++d) hits += hist[d];
+        return accesses_ - hits;
+    }
+
+    /* fully-associative curve, one point per size 1..max_lines */
+    [[nodiscard]] std::vector<CurvePoint> fa_curve() const
+    {
+        std::vector<CurvePoint> out;
+        out.reserve(opt_.max_lines);
+        std::uint64_t hits = 0;
+        for (std::size_t lines = 1; lines <= opt_.max_lines; ++lines) {
+            hits += fa_hist_[lines - 1];
+            out.push_back(point(1, lines, accesses_ - hits));
+        }
+        return out;
+    }
+
+    /* set-associative curve for `sets` sets, one point per way count 1..max_ways */
+    [[nodiscard]] std::vector<CurvePoint> set_curve(std::size_t sets) const
+    {
+        std::vector<CurvePoint> out;
+        for (std::size_t ways = 1; ways <= opt_.max_ways; ++ways) out.push_back(point(sets, ways, misses(sets, ways)));
+        return out;
+    }
+
+    /* every curve as CSV: organization,sets,ways,bytes,misses,miss_ratio ("fa" rows have sets = 1) */
+    void write_csv(std::ostream& os) const
+    {
+        os << "organization,sets,ways,bytes,misses,miss_ratio\n";
+        auto row = [&](const char* org, const CurvePoint& p) {
+            os << std::format("{},{},{},{},{},{:.6f}\n", org, p.sets, p.ways, p.bytes, p.misses, p.miss_ratio);
+        };
+        for (const auto& p : fa_curve()) row("fa", p);
+        for (const auto& lv : levels_)
+            for (const auto& p : set_curve(lv.sets)) row("sa", p);
+    }
+
+    /* bytes held by the analysis state; fixed by Options, whatever the stream length */
+    [[nodiscard]] std::size_t memory_bytes() const noexcept
+    {
+        std::size_t n = (tree_.size() + owner_.size() + id_slot_.size() + id_line_.size()) * sizeof(std::uint32_t) +
+                        fa_hist_.size() * sizeof(std::uint64_t) +
+                        id_of_.capacity() * (1 + 2 * sizeof(std::uint32_t));
+        for (const auto& lv : levels_)
+            n += lv.stack.size() * sizeof(std::uint32_t) + lv.hist.size() * sizeof(std::uint64_t);
+        return n;
+    }
+
+    [[nodiscard]] const Options& options() const noexcept { return opt_; }
+
+  private:
+    static constexpr std::uint32_t no_line = ~std::uint32_t{0};
+
+    /* per-set move-to-front stacks for one set count; hist[d] = hits at depth d */
+    struct SetLevel
+    {
+        std::size_t                sets;
+        std::vector<std::uint32_t> stack; // [set * max_ways + depth], MRU first
+        std::vector<std::uint64_t> hist;
+    };
+
+    Options        opt_;
+    unsigned       line_shift_;
+
+    // fully associative: Fenwick tree over time slots, one marker per tracked line at its last access
+    std::size_t                          window_;
+    std::vector<std::uint32_t>           tree_;    // 1-based Fenwick array
+    std::vector<std::uint32_t>           owner_;   // slot -> tracked-line id (no_line if free)
+    std::vector<std::uint32_t>           id_slot_; // id -> slot of the line's last access
+    std::vector<std::uint32_t>           id_line_; // id -> line
+    HashTable<std::uint32_t, std::uint32_t> id_of_; // line -> id; ids are stable while a line is tracked, so hits don't write it
+    std::size_t                          now_  = 0;  // next free slot
+    std::size_t                          live_ = 0;  // tracked lines (= markers in the tree)
+    std::vector<std::uint64_t>           fa_hist_;   // [d] = reuses at stack distance d
+    std::uint64_t                        deep_ = 0;
+
+    std::vector<SetLevel>                levels_;
+    std::uint64_t                        accesses_ = 0;
+    std::unique_ptr<MemoryBus>           next_;
+
+    [[nodiscard]] CurvePoint point(std::size_t sets, std::size_t ways, std::uint64_t misses) const noexcept
+    {
+        return { sets, ways, static_cast<std::uint64_t>(sets) * ways * opt_.line_bytes, misses,
+                 accesses_ ? static_cast<double>(misses) / static_cast<double>(accesses_) : 0.0 };
+    }
+
+    void tree_add(std::size_t slot, std::int32_t delta) noexcept
+    {
+        for (std::size_t i = slot + 1; i < tree_.size(); i += i & (~i + 1))
+            tree_[i] = static_cast<std::uint32_t>(static_cast<std::int64_t>(tree_[i]) + delta);
+    }
+
+    /* markers in slots [0, slot] */
+    [[nodiscard]] std::size_t tree_prefix(std::size_t slot) const noexcept
+    {
+        std::size_t n = 0;
+        for (std::size_t i = slot + 1; i > 0; i &= i - 1) n += tree_[i];
+        return n;
+    }
+
+    /* lowest marked slot, i.e. the LRU line */
+    [[nodiscard]] std::size_t tree_first() const noexcept
+    {
+        std::size_t pos = 0;
+        for (std::size_t step = std::bit_floor(tree_.size() - 1); step; step >>= 1)
+            if (pos + step < tree_.size() && tree_[pos + step] == 0) pos += step;
+        return pos; // 1-based index pos + 1 -> slot pos
+    }
+
+    void observe_fa(std::uint32_t line)
+    {
+        std::uint32_t id;
+        if (auto known = id_of_.get(line)) {
+            id = *known;
+            const std::size_t s = id_slot_[id];
+            ++fa_hist_[live_ - tree_prefix(s)]; // lines touched after it
+            tree_add(s, -1);
+            owner_[s] = no_line;
+        } else {
+            ++deep_;
+            if (live_ < opt_.max_lines) {
+                id = static_cast<std::uint32_t>(live_++);
+            } else { // forget the LRU line, it is deeper than any size we report; the newcomer takes its id
+                const std::size_t lru = tree_first();
+                id = owner_[lru];
+                tree_add(lru, -1);
+                owner_[lru] = no_line;
+                id_of_.erase(id_line_[id]);
+            }
+            id_line_[id] = line;
+            id_of_.put(line, id);
+        }
+        if (now_ == window_) compact();
+        tree_add(now_, +1);
+        owner_[now_]  = id;
+        id_slot_[id] = static_cast<std::uint32_t>(now_++);
+    }
+
+    /* renumber the tracked lines into slots 0..live-1, keeping their order, and rebuild the tree */
+    void compact()
+    {
+        std::size_t k = 0;
+        for (std::size_t s = 0; s < now_; ++s) {
+            if (owner_[s] == no_line) continue;
+            owner_[k] = owner_[s];
+            id_slot_[owner_[k]] = static_cast<std::uint32_t>(k);
+            ++k;
+        }
+        std::fill(owner_.begin() + static_cast<std::ptrdiff_t>(k), owner_.end(), no_line);
+        now_ = k;
+
+        // linear-time build for ones in [0, k)
+        std::fill(tree_.begin(), tree_.end(), 0);
+        for (std::size_t i = 1; i < tree_.size(); ++i) {
+            if (i <= k) ++tree_[i];
+            if (const std::size_t j = i + (i & (~i + 1)); j < tree_.size()) tree_[j] += tree_[i];
+        }
+    }
+
+    void observe_set(SetLevel& lv, std::uint32_t line) noexcept
+    {
+        const std::size_t ways = opt_.max_ways;
+        std::uint32_t* st = lv.stack.data() + (line & (lv.sets - 1)) * ways;
+        std::size_t d = static_cast<std::size_t>(std::find(st, st + ways, line) - st);
+        if (d < ways) ++lv.hist[d];
+        else          d = ways - 1; // miss: the LRU entry falls off
+        for (; d > 0; --d) st[d] = st[d - 1];
+        st[0] = line;
+    }
+};
+
+} // namespace rv
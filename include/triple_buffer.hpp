@@ -0,0 +1,55 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace rv {
+
+/*
+Lock-free triple buffer: one producer hands complete values to one consumer, and neither
+waits for the other. The producer fills back() and publish()es it; the consumer calls
+acquire() and reads front(). The third slot sits between them, so the producer can start
+on the next value while the consumer still holds the previous one, and the consumer
+always gets the newest published value (older unread ones are dropped).
+*/
+template <class T>
+class TripleBuffer
+{
+  public:
+    /* producer: the slot to fill */
+    [[nodiscard]] T& back() noexcept { return slots_[back_]; }
+
+    /* producer: make back() the newest value and take over the middle slot */
+    void publish() noexcept
+    {
+        back_ = middle_.exchange(static_cast<std::uint8_t>(back_ | fresh), std::memory_order_acq_rel) & index;
+    }
+
+    /*
+    producer: the last published value hasn't been acquired yet, so publishing again
+    may replace it unseen (a producer sending deltas must fold this one into the next)
+    */
+    [[nodiscard]] bool pending() const noexcept { return middle_.load(std::memory_order_acquire) & fresh; }
+
+    /* consumer: switch front() to the newest value; false if nothing was published since */
+    bool acquire() noexcept
+    {
+        if (!(middle_.load(std::memory_order_relaxed) & fresh)) return false;
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & index;
+        return true;
+    }
+
+    /* consumer: the value from the last successful acquire() */
+    [[nodiscard]] const T& front() const noexcept { return slots_[front_]; }
+
+  private:
+    static constexpr std::uint8_t index = 0x3;
+    static constexpr std::uint8_t fresh = 0x4; // middle holds a value the consumer hasn't seen
+
+    std::array<T, 3>          slots_{};
+    std::atomic<std::uint8_t> middle_{ 1 };
+    std::uint8_t              back_  = 0;    // producer-owned
+    std::uint8_t              front_ = 2;    // consumer-owned
+};
+
+} // namespace rv
@@ -0,0 +1,73 @@
+#pragma once
+#include "cache_line.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace rv {
+
+/*
+Small fully-associative buffer of lines recently evicted from a Cache (Jouppi's victim cache).
+Entries are keyed by line number (address >> line_shift) and replaced LRU.
+A line lives either in the owning Cache or here, never both: take() removes it.
+*/
+class VictimCache
+{
+  public:
+    struct Entry
+    {
+        std::uint32_t line;  // address >> line_shift
+        CacheLine     data;
+    };
+
+    explicit VictimCache(std::size_t entries)
+        : entries_(entries), stamp_(entries, 0) {}
+
+    [[nodiscard]] std::size_t capacity() const noexcept { return entries_.size(); }
+
+    /* remove and return the line if it is held here */
+    [[nodiscard]] std::optional<CacheLine> take(std::uint32_t line) noexcept
+    {
+        for (auto& e : entries_) {
+            if (!e.data.valid || e.line != line) continue;
+            CacheLine out = e.data;
+            e.data.reset();
+            return out;
+        }
+        return std::nullopt;
+    }
+
+    /* insert an evicted line; returns the entry it displaced, if that one was valid */
+    std::optional<Entry> insert(std::uint32_t line, const CacheLine& data) noexcept
+    {
+        const auto it = std::ranges::find_if(entries_, [](const Entry& e){ return !e.data.valid; });
+        const std::size_t i = it != entries_.end()
+            ? static_cast<std::size_t>(it - entries_.begin())
+            : static_cast<std::size_t>(std::ranges::min_element(stamp_) - stamp_.begin());
+
+        std::optional<Entry> displaced;
+        if (entries_[i].data.valid) displaced = entries_[i];
+        entries_[i] = { line, data };
+        stamp_[i]   = ++clock_;
+        return displaced;
+    }
+
+    /* hand every held line to `f` (e.g. to write dirty ones back) and empty the buffer */
+    template <class F>
+    void drain(F&& f)
+    {
+        for (auto& e : entries_) {
+            if (e.data.valid) f(std::as_const(e));
+            e.data.reset();
+        }
+    }
+
+  private:
+    std::vector<Entry>         entries_;
+    std::vector<std::uint64_t> stamp_; // insertion time; a hit removes the entry, so this is LRU
+    std::uint64_t              clock_ = 0;
+};
+
+} // namespace rv
@@ -0,0 +1,139 @@
+#pragma once
+#include "memory_bus.hpp"
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <format>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace rv {
+
+struct WriteBufferStats
+{
+    std::uint64_t stores          = 0; // store_word calls accepted
+    std::uint64_t coalesced       = 0; // stores merged into an existing entry
+    std::uint64_t drained         = 0; // entries written below (one store_block each)
+    std::uint64_t capacity_stalls = 0; // store had to wait for the oldest entry to drain
+    std::uint64_t raw_stalls      = 0; // load hit a buffered line and forced a drain
+    std::uint64_t fences          = 0;
+    std::uint64_t passed          = 0; // sub-word stores sent straight below
+
+    /* stores per downstream transaction (1.0 = no coalescing) */
+    [[nodiscard]] double coalescing_ratio() const noexcept
+    { return drained ? static_cast<double>(stores) / static_cast<double>(drained) : 0.0; }
+
+    std::string pretty() const
+    {
+        return std::format("Stores {:8}, drains {:8} ({:5.2f} stores/drain), stalls: capacity {}, RAW {}, fences {}, sub-word {}",
+                           stores, drained, coalescing_ratio(), capacity_stalls, raw_stalls, fences, passed);
+    }
+};
+
+/*
+Coalescing write buffer, meant to sit under a write-through Cache:
+    Cache(sets, ways, std::make_unique<WriteBuffer>(std::move(next)), WritePolicy::write_through)
+Stores to the same 16-byte line merge into one entry; entries leave in FIFO order as a
+single store_block when the buffer is full, on fence(), or when a load touches a buffered
+line (the entry and everything older drain first, so loads never see stale data).
+Sub-word (byte-addressed) stores don't fit a word slot: they drain their line's entry, then
+pass straight through, the same as Cache::device_store does.
+Not thread-safe.
+*/
+class WriteBuffer : public MemoryBus
+{
+  public:
+    explicit WriteBuffer(std::unique_ptr<MemoryBus> next, std::size_t entries = 8)
+        : next_{std::move(next)}, capacity_{entries} {}
+
+    std::optional<std::uint32_t> load_word(std::uint32_t addr) override
+    {
+        if (auto it = find(line_of(addr)); it != fifo_.end()) {
+            ++stats_.raw_stalls;
+            drain_through(it);
+        }
+        return next_->load_word(addr);
+    }
+
+    bool store_word(std::uint32_t addr, std::uint32_t v) override
+    {
+        ++stats_.stores;
+        const std::uint32_t line = line_of(addr);
+        const auto          w    = (addr >> 2) & (line_words - 1);
+
+        if (addr & 3) {
+            if (auto it = find(line); it != fifo_.end()) drain_through(it);
+            ++stats_.passed;
+            return next_->store_word(addr, v);
+        }
+
+        if (auto it = find(line); it != fifo_.end()) {
+            ++stats_.coalesced;
+            it->words[w] = v;
+            it->mask    |= 1u << w;
+            return true;
+        }
+
+        if (fifo_.size() >= capacity_) {
+            ++stats_.capacity_stalls;
+            drain_through(fifo_.begin());
+        }
+        Entry e{ line, {}, 1u << w };
+        e.words[w] = v;
+        fifo_.push_back(e);
+        return true;
+    }
+
+    void fence() override
+    {
+        ++stats_.fences;
+        if (!fifo_.empty()) drain_through(std::prev(fifo_.end()));
+        next_->fence();
+    }
+
+    void set_pc(std::uint32_t pc) noexcept override { next_->set_pc(pc); }
+
+    [[nodiscard]] WriteBufferStats const& stats()     const noexcept { return stats_; }
+    [[nodiscard]] std::size_t             occupancy() const noexcept { return fifo_.size(); }
+
+  private:
+    static constexpr std::size_t line_words = 4;
+    static constexpr unsigned    line_shift = 4; // 16-byte line, same as Cache
+
+    struct Entry
+    {
+        std::uint32_t                           line;
+        std::array<std::uint32_t, line_words>   words;
+        std::uint32_t                           mask;
+    };
+
+    std::unique_ptr<MemoryBus> next_;
+    std::size_t                capacity_;
+    std::deque<Entry>          fifo_; // front = oldest
+    WriteBufferStats           stats_;
+
+    [[nodiscard]] static std::uint32_t line_of(std::uint32_t addr) noexcept { return addr >> line_shift; }
+
+    std::deque<Entry>::iterator find(std::uint32_t line)
+    {
+        for (auto it = fifo_.begin(); it != fifo_.end(); ++it)
+            if (it->line == line) return it;
+        return fifo_.end();
+    }
+
+    /* write out every entry up to and including `last`, oldest first */
+    void drain_through(std::deque<Entry>::iterator last)
+    {
+        const auto n = std::distance(fifo_.begin(), last) + 1;
+        for (auto i = 0; i < n; ++i) {
+            const Entry& e = fifo_.front();
+            next_->store_block(e.line << line_shift, e.words, e.mask);
+            ++stats_.drained;
+            fifo_.pop_front();
+        }
+    }
+};
+
+} // namespace rv
@@ -1,5 +1,5 @@
 #include "concurrent_hash_table.hpp"
-#include "cache.hpp"
+#include "concurrent_cache.hpp"
 #include "riscv.hpp"
 #include "rv_assembler.hpp"
 #include "cache_stats_formatter.hpp"
@@ -16,18 +16,19 @@
 #endif
 #include <chrono>
 
-using rv::Cache;
+using rv::ConcurrentCache;
 using rv::ConcurrentHashTable;
 using rv::RiscV;
 using namespace std::chrono;
+using namespace rv::literals;
 int main()
 {
     auto dram = std::make_unique<ConcurrentHashTable<std::uint32_t,std::uint32_t>>();
-    auto l1   = std::make_unique<Cache>(64, 2, std::move(dram));
+    auto l1   = std::make_unique<ConcurrentCache>(64, 2, std::move(dram)); // shared by the parallel loader below
     RiscV cpu{ *l1 };
 
-    // load program
-    constexpr std::string_view asm_src = R"(
+    // load program, assembled at compile time (a bad line is a compile error)
+    static constexpr auto words = R"(
 start:
     addi x1, x0, 11       # loop upper-bound (exclusive)
     addi x2, x0, 0        # sum
@@ -38,9 +39,7 @@ loop:
     bne  x3, x1, loop
     sw   x2, 32(x0)
     jalr x0, x0, 0        # halt
-)";
-
-    auto words = rv::assemble(asm_src); // assemble the program (throws on error)
+)"_rvasm;
     std::uint32_t base = 0;
     auto t_load_start = high_resolution_clock::now();
 
@@ -51,7 +50,7 @@ loop:
 #else
     auto first = oneapi::dpl::counting_iterator<std::size_t>(0);
     auto last  = first + static_cast<std::uint32_t>(words.size());
-    oneapi::dpl::for_each(oneapi::dpl::execution::par_unseq,
+    oneapi::dpl::for_each(oneapi::dpl::execution::par, // not par_unseq: stores take per-set locks
         first, last,
         [&](std::size_t i) {
             l1->store_word(base + static_cast<std::uint32_t>(i * 4), words[i]);
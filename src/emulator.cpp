@@ -1,6 +1,10 @@
 #include "mmio_window.hpp"
 #include "concurrent_hash_table.hpp"
 #include "cache.hpp"
+#include "clint.hpp"
+#include "dma_device.hpp"
+#include "irq_controller.hpp"
+#include "pcm_audio_device.hpp"
 #include "riscv.hpp"
 #include "text/bitmap_font.hpp"
 #include <memory>
@@ -22,16 +26,43 @@ void build_system(MmioWindow*& io_out, RiscV*& cpu_out)
     MmioWindow* mmio_raw = mmio_ptr.get();
 
     cache_up = std::make_unique<Cache>(64, 2, std::move(mmio_ptr));
+    // device memory must not be cached: pixels are combined per line, registers go straight through
+    cache_up->set_attribute(MmioWindow::fb_base,   MmioWindow::fb_size, MemAttr::write_combining);
+    cache_up->set_attribute(MmioWindow::gpio_addr, 8,                   MemAttr::uncached); // GPIO + audio
+    cache_up->set_attribute(DmaDevice::default_base, DmaDevice::window_size, MemAttr::uncached);
+    cache_up->set_attribute(PcmAudioDevice::default_base, PcmAudioDevice::window_size, MemAttr::uncached);
+    cache_up->set_attribute(Clint::default_base, Clint::window_size, MemAttr::uncached);
+    cache_up->set_attribute(IrqController::default_base, IrqController::window_size, MemAttr::uncached);
+
+    // DMA masters the cache (coherent with the CPU) and blits straight into the framebuffer
+    auto dma = std::make_unique<DmaDevice>(*cache_up);
+    DmaDevice* dma_raw = dma.get();
+    dma->map_direct(MmioWindow::fb_base, MmioWindow::fb_size, mmio_raw->framebuffer,
+                    [mmio_raw](std::uint32_t off, std::uint32_t n) { mmio_raw->fb_dirty.mark_span(off, n); });
+    mmio_raw->map("dma", DmaDevice::default_base, DmaDevice::window_size, std::move(dma));
+
+    // PCM samples for the host's audio callback (see PcmAudioDevice)
+    mmio_raw->map("pcm", PcmAudioDevice::default_base, PcmAudioDevice::window_size, std::make_unique<PcmAudioDevice>());
+
     cpu_up   = std::make_unique<RiscV>(*cache_up);
 
+    // interrupts: CLINT timer/software lines, and one external line fed by vsync, GPIO and DMA
+    mmio_raw->map("clint", Clint::default_base, Clint::window_size, std::make_unique<Clint>(*cpu_up));
+    auto& irq = static_cast<IrqController&>(mmio_raw->map("irq", IrqController::default_base, IrqController::window_size,
+                                                          std::make_unique<IrqController>()));
+    irq.on_line          = [cpu = cpu_up.get()](bool level) { cpu->set_external_irq(level); };
+    dma_raw->on_complete = [&irq] { irq.raise(IrqController::dma); };
+
     io_out  = mmio_raw;
     cpu_out = cpu_up.get();
 
-    // seed ROM: NOP + self-halt
+    // seed ROM: NOP, then sleep in WFI (no interrupt is enabled, so for good, at no host cost)
     constexpr std::uint32_t nop  = 0x00000013;
-    constexpr std::uint32_t halt = 0x0000006F;
+    constexpr std::uint32_t wfi  = 0x10500073;
+    constexpr std::uint32_t back = 0xFFDFF06F; // jal x0, -4
     cache_up->store_word(0, nop);
-    cache_up->store_word(4, halt);
+    cache_up->store_word(4, wfi);
+    cache_up->store_word(8, back);
 
     // vertical blue-green gradient 
     for (int y = 0; y < 128; ++y) {
@@ -1,25 +1,76 @@
 #include "mmio_window.hpp"
+#include <algorithm>
+#include <format>
+#include <limits>
+#include <stdexcept>
 
 namespace rv {
 
+MmioWindow::MmioWindow(std::unique_ptr<MemoryBus> next)
+    : next_{std::move(next)}
+{
+    map("framebuffer", fb_base,    fb_size, std::make_unique<FramebufferDevice>(framebuffer, fb_dirty));
+    map("gpio",        gpio_addr,  4,       std::make_unique<GpioDevice>(gpio_in));
+    map("audio",       audio_addr, 4,       std::make_unique<AudioDevice>(audio_note));
+}
+
 std::optional<std::uint32_t>
 MmioWindow::load_word(std::uint32_t a)
 {
-    if (a == 0x2000'2000) return gpio_in;
+    if (Region* r = find(a)) {
+        ++r->reads;
+        return r->device->read(a - r->base);
+    }
     return next_->load_word(a); // delegate
 }
 
 bool MmioWindow::store_word(std::uint32_t a, std::uint32_t v)
 {
-    if (a >= 0x2000'0000 && a < 0x2000'2000) { // frame-buffer
-        framebuffer[a - 0x2000'0000] = static_cast<std::uint8_t>(v);
-        return true;
-    }
-    if (a == 0x2000'2004) { // audio
-        audio_note = static_cast<std::uint8_t>(v);
+    if (Region* r = find(a)) {
+        ++r->writes;
+        r->device->write(a - r->base, v);
         return true;
     }
     return next_->store_word(a, v); // delegate
 }
 
+MmioDevice& MmioWindow::map(std::string name, std::uint32_t base, std::uint32_t size, std::unique_ptr<MmioDevice> dev)
+{
+    if (!dev || size == 0 || base + (size - 1) < base)
+        throw std::invalid_argument(std::format("bad MMIO range for '{}'", name));
+    if (regions_.size() >= std::numeric_limits<std::uint16_t>::max())
+        throw std::invalid_argument("too many MMIO devices");
+
+    auto pos = std::ranges::lower_bound(regions_, base, {}, &Region::base);
+    const bool clash_next = pos != regions_.end() && pos->base - base < size;
+    const bool clash_prev = pos != regions_.begin() && std::prev(pos)->contains(base);
+    if (clash_next || clash_prev)
+        throw std::invalid_argument(std::format("MMIO device '{}' at 0x{:08x} overlaps '{}'", name, base,
+                                                (clash_next ? *pos : *std::prev(pos)).name));
+
+    MmioDevice& d = *dev;
+    regions_.insert(pos, Region{ std::move(name), base, size, std::move(dev) });
+    rebuild_pages();
+    return d;
+}
+
+void MmioWindow::rebuild_pages()
+{
+    for (auto& leaf : directory_)
+        if (leaf) leaf->fill(0);
+
+    // highest base first, so each page ends up pointing at the lowest region touching it
+    for (std::size_t i = regions_.size(); i-- > 0;) {
+        const Region& r = regions_[i];
+        const std::uint32_t first = r.base >> page_shift;
+        const std::uint32_t last  = (r.base + (r.size - 1)) >> page_shift;
+        for (std::uint32_t p = first;; ++p) {
+            auto& leaf = directory_[p >> leaf_bits];
+            if (!leaf) leaf = std::make_unique<Leaf>();
+            (*leaf)[p & ((1u << leaf_bits) - 1)] = static_cast<std::uint16_t>(i + 1);
+            if (p == last) break;
+        }
+    }
+}
+
 } // namespace rv
@@ -1,6 +1,8 @@
 // src/riscv.cpp
 #include "riscv.hpp"
 #include "riscv_types.hpp"
+#include "exec_trace.hpp"
+#include <algorithm>
 #include <format>
 #include <stdexcept>
 
@@ -8,20 +10,34 @@ namespace rv {
 
 void RiscV::step()
 {
+    if (instret_ >= check_at_) [[unlikely]]
+        if (!poll_interrupts()) return; // asleep in WFI
+
     auto word_opt = mem_.load_word(pc_);
     if (!word_opt) throw std::runtime_error("Fetch fault");
     uint32_t raw = *word_opt;
 
     auto inst = decode(raw);
+    const uint32_t pc = pc_;
+    uint32_t mem_addr = RetiredInstr::no_addr;
 
     std::visit([&](auto&& d){
         using T = std::decay_t<decltype(d)>;
 
         if constexpr (std::is_same_v<T, RType>) {
-            // … existing R-type (add/sub) …
+            // RV32I register-register ALU ops
+            const uint32_t a = regs_[d.rs1], b = regs_[d.rs2];
             switch ((d.funct7 << 3) | d.funct3) {
-              case 0b000'0000000: write_reg(d.rd, regs_[d.rs1] + regs_[d.rs2]); break; // ADD
-              case 0b000'0100000: write_reg(d.rd, regs_[d.rs1] - regs_[d.rs2]); break; // SUB
+              case 0b0000000'000: write_reg(d.rd, a + b); break;                                   // ADD
+              case 0b0100000'000: write_reg(d.rd, a - b); break;                                   // SUB
+              case 0b0000000'001: write_reg(d.rd, a << (b & 31)); break;                           // SLL
+              case 0b0000000'010: write_reg(d.rd, int32_t(a) < int32_t(b)); break;                 // SLT
+              case 0b0000000'011: write_reg(d.rd, a < b); break;                                   // SLTU
+              case 0b0000000'100: write_reg(d.rd, a ^ b); break;                                   // XOR
+              case 0b0000000'101: write_reg(d.rd, a >> (b & 31)); break;                           // SRL
+              case 0b0100000'101: write_reg(d.rd, uint32_t(int32_t(a) >> (b & 31))); break;        // SRA
+              case 0b0000000'110: write_reg(d.rd, a | b); break;                                   // OR
+              case 0b0000000'111: write_reg(d.rd, a & b); break;                                   // AND
               default: throw std::runtime_error("Unimpl R-type");
             }
             pc_ += 4;
@@ -29,20 +45,41 @@ void RiscV::step()
         else if constexpr (std::is_same_v<T, IType>) {
             // … existing I-type (ADDI, LOAD, JALR) …
             switch (static_cast<Opcode>(raw & 0x7F)) {
-              case Opcode::OP_IMM:
-                if (d.funct3 == 0) {
-                  write_reg(d.rd, regs_[d.rs1] + static_cast<uint32_t>(d.imm)); // ADDI
-                } else throw std::runtime_error("Unimpl OP-IMM");
+              case Opcode::OP_IMM: {
+                const uint32_t a = regs_[d.rs1], imm = static_cast<uint32_t>(d.imm), sh = imm & 31;
+                switch (d.funct3) {
+                  case 0: write_reg(d.rd, a + imm); break;                           // ADDI
+                  case 1: write_reg(d.rd, a << sh); break;                           // SLLI
+                  case 2: write_reg(d.rd, int32_t(a) < d.imm); break;                // SLTI
+                  case 3: write_reg(d.rd, a < imm); break;                           // SLTIU
+                  case 4: write_reg(d.rd, a ^ imm); break;                           // XORI
+                  case 5: write_reg(d.rd, (imm & 0x400) ? uint32_t(int32_t(a) >> sh) // SRAI
+                                                        : a >> sh); break;           // SRLI
+                  case 6: write_reg(d.rd, a | imm); break;                           // ORI
+                  case 7: write_reg(d.rd, a & imm); break;                           // ANDI
+                }
                 pc_ += 4;
                 break;
+              }
 
               case Opcode::LOAD: {
                 auto addr = regs_[d.rs1] + static_cast<uint32_t>(d.imm);
+                mem_addr = addr;
+                mem_.set_pc(pc_);
                 write_reg(d.rd, mem_.load_word(addr).value_or(0));
                 pc_ += 4;
                 break;
               }
 
+              case Opcode::MISC_MEM: // FENCE: drain buffered writes
+                mem_.fence();
+                pc_ += 4;
+                break;
+
+              case Opcode::SYSTEM:
+                system(d);
+                break;
+
               case Opcode::JALR: {
                 uint32_t link   = pc_ + 4;
                 uint32_t target = regs_[d.rs1] + static_cast<uint32_t>(d.imm);
@@ -58,6 +95,8 @@ void RiscV::step()
         else if constexpr (std::is_same_v<T, SType>) {
             // … existing S-type (stores) …
             uint32_t addr = regs_[d.rs1] + static_cast<uint32_t>(d.imm);
+            mem_addr = addr;
+            mem_.set_pc(pc_);
             switch (d.funct3) {
               case 0: mem_.store_word(addr, regs_[d.rs2] & 0xFF);      break; // SB
               case 1: mem_.store_word(addr, regs_[d.rs2] & 0xFFFF);    break; // SH
@@ -98,6 +137,163 @@ void RiscV::step()
         }
 
     }, inst);
+    ++instret_;
+    if (flight_ || stream_) [[unlikely]] retire(pc, raw, mem_addr);
+}
+
+std::uint64_t RiscV::run(std::uint64_t max_instructions, std::uint64_t deadline)
+{
+    const std::uint64_t start = instret_;
+    while (instret_ - start < max_instructions && cycle() < deadline) {
+        if (waiting()) [[unlikely]] {
+            idle(std::min(deadline - cycle(), cycles_to_timer()));
+            continue;
+        }
+        step();
+    }
+    return instret_ - start;
+}
+
+/* CSRRW/CSRRS/CSRRC (and their immediate forms), MRET, WFI */
+void RiscV::system(const IType& d)
+{
+    const auto num = static_cast<std::uint16_t>(d.imm & 0xFFF);
+    if (d.funct3 == 0) {
+        switch (num) {
+          case 0x302:                                                   // MRET
+            pc_      = mepc_;
+            mstatus_ = (mstatus_ & mstatus_mpie ? mstatus_mie : 0) | mstatus_mpie;
+            rearm();
+            return;
+          case 0x105:                                                   // WFI
+            pc_ += 4;
+            waiting_ = true;
+            rearm();
+            return;
+          default:
+            throw std::runtime_error(std::format("Unimpl SYSTEM 0x{:03x}", num));
+        }
+    }
+
+    const std::uint32_t src = d.funct3 & 0b100 ? d.rs1 : regs_[d.rs1]; // immediate forms: rs1 is the value
+    const std::uint32_t old = read_csr(num);
+    switch (d.funct3 & 0b011) {
+      case 1: write_csr(num, src); break;                              // CSRRW(I)
+      case 2: if (d.rs1) write_csr(num, old | src); break;             // CSRRS(I): x0/0 only reads
+      case 3: if (d.rs1) write_csr(num, old & ~src); break;            // CSRRC(I)
+      default: throw std::runtime_error("Unimpl SYSTEM");
+    }
+    write_reg(d.rd, old);
+    pc_ += 4;
+}
+
+std::uint32_t RiscV::read_csr(std::uint16_t num) const
+{
+    const auto lo = [](std::uint64_t v) { return static_cast<std::uint32_t>(v); };
+    const auto hi = [](std::uint64_t v) { return static_cast<std::uint32_t>(v >> 32); };
+    switch (static_cast<Csr>(num)) {
+      case Csr::mstatus:  return mstatus_ | (3u << 11);                // MPP: only M-mode exists
+      case Csr::misa:     return (1u << 30) | (1u << 8);               // RV32I
+      case Csr::mie:      return mie_;
+      case Csr::mtvec:    return mtvec_;
+      case Csr::mscratch: return mscratch_;
+      case Csr::mepc:     return mepc_;
+      case Csr::mcause:   return mcause_;
+      case Csr::mtval:    return mtval_;
+      case Csr::mip:      return mip();
+      case Csr::mcycle:   case Csr::cycle:  case Csr::time:  return lo(cycle());
+      case Csr::mcycleh:  case Csr::cycleh: case Csr::timeh: return hi(cycle());
+      case Csr::minstret: case Csr::instret:   return lo(instret_);
+      case Csr::minstreth: case Csr::instreth: return hi(instret_);
+      case Csr::mhartid:  return 0;
+    }
+    throw std::runtime_error(std::format("Unimpl CSR 0x{:03x}", num));
+}
+
+void RiscV::write_csr(std::uint16_t num, std::uint32_t v)
+{
+    switch (static_cast<Csr>(num)) {
+      case Csr::mstatus:  mstatus_  = v & (mstatus_mie | mstatus_mpie); break;
+      case Csr::mie:      mie_      = v & (mip_msip | mip_mtip | mip_meip); break;
+      case Csr::mtvec:    mtvec_    = v & ~2u; break;                  // mode 0 direct, 1 vectored
+      case Csr::mscratch: mscratch_ = v; break;
+      case Csr::mepc:     mepc_     = v & ~3u; break;
+      case Csr::mcause:   mcause_   = v; break;
+      case Csr::mtval:    mtval_    = v; break;
+      case Csr::mip:      break;                                       // lines are driven by devices
+      default:            (void)read_csr(num); return;                 // counters are read-only here; unknown CSRs throw
+    }
+    rearm();
+}
+
+void RiscV::set_timer_compare(std::uint64_t compare) noexcept
+{
+    mtimecmp_ = compare;
+    rearm();
+}
+
+void RiscV::set_external_irq(bool level) noexcept
+{
+    lines_ = level ? lines_ | mip_meip : lines_ & ~mip_meip;
+    rearm();
+}
+
+void RiscV::set_software_irq(bool level) noexcept
+{
+    lines_ = level ? lines_ | mip_msip : lines_ & ~mip_msip;
+    rearm();
+}
+
+std::uint64_t RiscV::cycles_to_timer() const noexcept
+{
+    if (!(mie_ & mip_mtip) || mtimecmp_ == never) return never;
+    return mtimecmp_ > cycle() ? mtimecmp_ - cycle() : 0;
+}
+
+void RiscV::idle(std::uint64_t n) noexcept
+{
+    idle_ += n;
+    rearm();
+}
+
+/*
+Slow path of step(): wake from WFI and take the highest-priority enabled interrupt
+(external, then software, then timer). Returns false while there is nothing to wake for.
+*/
+bool RiscV::poll_interrupts()
+{
+    const std::uint32_t pending = mip() & mie_;
+    if (waiting_) {
+        if (!pending) return false;      // WFI wakes on an enabled interrupt even with mstatus.MIE clear
+        waiting_ = false;
+    }
+    if (pending && (mstatus_ & mstatus_mie)) {
+        const std::uint32_t cause = pending & mip_meip ? 11 : pending & mip_msip ? 3 : 7;
+        mepc_    = pc_;
+        mcause_  = 0x8000'0000u | cause;
+        mstatus_ = mstatus_ & mstatus_mie ? mstatus_mpie : 0;  // MPIE = MIE, MIE = 0
+        pc_      = (mtvec_ & ~3u) + (mtvec_ & 1 ? 4 * cause : 0);
+    }
+    rearm();
+    return true;
+}
+
+/* when step() must next call poll_interrupts() */
+void RiscV::rearm() noexcept
+{
+    const bool deliverable = (mip() & mie_) && (mstatus_ & mstatus_mie);
+    if (waiting_ || deliverable) { check_at_ = 0; return; }
+    // a timer already pending but masked by mstatus.MIE waits for the mstatus write that unmasks it
+    const std::uint64_t wait = cycles_to_timer();
+    check_at_ = wait == 0 || wait > never - instret_ ? never : instret_ + wait;
+}
+
+void RiscV::retire(std::uint32_t pc, std::uint32_t raw, std::uint32_t addr)
+{
+    const auto reg = traced_reg(raw);
+    const RetiredInstr r{ pc, raw, reg ? regs_[*reg] : 0, addr };
+    if (flight_) flight_->record(r);
+    if (stream_) stream_->write(r);
 }
 
 } // namespace rv
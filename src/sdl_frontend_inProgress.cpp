@@ -4,39 +4,394 @@
 #ifdef __EMSCRIPTEN__
 #  include <emscripten.h>
 #endif
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <format>
 #include <iostream>
+#include <span>
+#include <string>
+#include <thread>
+#include "cache.hpp"
 #include "emulator.hpp"
+#include "frame_pacer.hpp"
+#include "irq_controller.hpp"
+#include "pcm_audio_device.hpp"
+#include "spsc_queue.hpp"
+#include "text/bitmap_font.hpp"
+#include "triple_buffer.hpp"
+
+/*
+SDL frontend: the guest runs a paced number of instructions per frame, and the screen
+shows the newest frame it finished.
+
+    rv_game [clock MHz]      (default 20)
+
+With threads (native, or wasm built with pthreads) the CPU runs on its own thread and
+never waits for rendering: each finished frame is copied into a triple buffer, and the
+render thread uploads only the newest one, and of that only the 8x8 tiles the guest
+changed (MmioWindow::fb_dirty); a frame with no changes costs no upload at all. Input goes the other way through a lock-free
+queue and reaches MmioWindow::gpio_in at the start of the next emulated frame. Without
+threads both halves run in turn inside the browser's frame callback. Each emulated frame
+raises the vsync interrupt, and so does a button change (IrqController); a guest that
+waits for them in WFI sleeps through the rest of the frame at no host cost. Sound is a third
+party: SDL's audio callback drains the guest's PCM FIFO (PcmAudioDevice) on the audio
+thread, again without locks.
+
+The per-frame budget comes from FramePacer: the configured emulated clock, cut back
+whenever the host needs more than 3/4 of a frame for it. F1 toggles an overlay with host
+MIPS, frame time and L1 hit rate; the same numbers go to the console once a second.
+*/
+
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+#  define RV_GAME_CPU_THREAD 1
+#else
+#  define RV_GAME_CPU_THREAD 0
+#endif
 
 using namespace rv;
+using steady = std::chrono::steady_clock;
 
 static MmioWindow* io   = nullptr;
 static RiscV*      cpu  = nullptr;
 
-#ifdef __EMSCRIPTEN__
-static SDL_Renderer* g_renderer = nullptr;
-static SDL_Texture*  g_texture  = nullptr;
+static SDL_Renderer*      g_renderer = nullptr;
+static SDL_Texture*       g_texture  = nullptr;
+static PcmAudioDevice*    g_pcm      = nullptr;
+static IrqController*     g_irq      = nullptr;
+static SDL_AudioDeviceID  g_audio    = 0;
+
+/* ------------------------------------------------------------------ */
+/* emulation -> rendering: finished frames                            */
+/* ------------------------------------------------------------------ */
+struct FrameStats
+{
+    double        mips = 0, frame_ms = 0, cpu_ms = 0, clock_ratio = 0, hit_rate = 0;
+    std::uint64_t budget = 0, target = 0;
+    bool          halted = false;
+};
+
+struct Frame
+{
+    std::array<std::uint8_t, 128 * 128> pixels{};
+    DirtyTiles                          dirty{};   // changed since the last frame the renderer took
+    FrameStats                          stats{};
+};
+
+static TripleBuffer<Frame> g_frames;
+
+/* texture upload volume, written by the renderer and reported by the CPU thread */
+static std::atomic<std::uint64_t> g_upload_bytes{ 0 };
+static std::atomic<std::uint64_t> g_upload_frames{ 0 };
+
+/* ------------------------------------------------------------------ */
+/* rendering -> emulation: button edges                               */
+/* ------------------------------------------------------------------ */
+struct InputEvent
+{
+    std::uint8_t button; // gpio_in bit
+    bool         down;
+};
+
+static SpscQueue<InputEvent, 64> g_input;
+
+/* gpio_in bits, in the order guests test them */
+static std::uint8_t button_for(SDL_Keycode k) noexcept
+{
+    switch (k) {
+      case SDLK_UP:     return 1u << 0;
+      case SDLK_DOWN:   return 1u << 1;
+      case SDLK_LEFT:   return 1u << 2;
+      case SDLK_RIGHT:  return 1u << 3;
+      case SDLK_z:      return 1u << 4;
+      case SDLK_x:      return 1u << 5;
+      case SDLK_RETURN: return 1u << 6;
+      case SDLK_SPACE:  return 1u << 7;
+      default:          return 0;
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/* emulation side (CPU thread)                                        */
+/* ------------------------------------------------------------------ */
+static FramePacer*        g_pacer  = nullptr;
+static bool               g_halted = false;   // the guest trapped; keep showing its last frame
+static steady::time_point g_last_frame{};
+static DirtyTiles         g_published_dirty;  // dirty set of the last published frame
+
+/* once-a-second report, and the hit rate the overlay shows */
+struct Report
+{
+    steady::time_point since{};
+    std::uint64_t      l1_accesses = 0, l1_hits = 0;
+    std::uint64_t      upload_bytes = 0, upload_frames = 0;
+    double             hit_rate = 0;
+};
+static Report g_report;
+
+static void apply_input()
+{
+    const std::uint8_t before = io->gpio_in;
+    while (auto ev = g_input.try_pop())
+        io->gpio_in = static_cast<std::uint8_t>(ev->down ? io->gpio_in | ev->button : io->gpio_in & ~ev->button);
+    if (g_irq && io->gpio_in != before) g_irq->raise(IrqController::gpio);
+}
+
+struct FrameRun
+{
+    std::uint64_t executed = 0;   // instructions retired
+    std::uint64_t idle     = 0;   // cycles slept through in WFI
+};
 
-static void frame()            // called ~60 fps by browser
+/* one frame of guest time: at most `budget` instructions, and WFI sleeps through the rest */
+static FrameRun run_cpu(std::uint64_t budget)
 {
-    /* FUTURE GOALS: cpu->step() N times per frame if you want live emulation */
+    if (g_halted) return {};
+    const std::uint64_t start = cpu->instret(), start_cycle = cpu->cycle();
+    try {
+        cpu->run(budget, start_cycle + g_pacer->target());
+    } catch (const std::exception& ex) {
+        std::cerr << std::format("guest trapped at pc 0x{:08x}: {}\n", cpu->pc(), ex.what());
+        g_halted = true;
+    }
+    cpu->mem().fence();   // drain the framebuffer's write-combining buffer before the frame is copied
+    const std::uint64_t executed = cpu->instret() - start;
+    return { executed, cpu->cycle() - start_cycle - executed };
+}
+
+static void update_report(steady::time_point now)
+{
+    if (now - g_report.since < std::chrono::seconds{ 1 }) return;
+
+    // the CPU's bus is the L1 (see build_system)
+    std::uint64_t acc = 0, hits = 0;
+    if (auto* l1 = dynamic_cast<Cache*>(&cpu->mem())) {
+        acc  = l1->stats().cpu_accesses();
+        hits = l1->stats().hits();
+    }
+    const std::uint64_t d_acc = acc - g_report.l1_accesses;
+    g_report.hit_rate    = d_acc ? static_cast<double>(hits - g_report.l1_hits) / static_cast<double>(d_acc) : 0.0;
+    g_report.l1_accesses = acc;
+    g_report.l1_hits     = hits;
+    g_report.since       = now;
+
+    const std::uint64_t up_bytes  = g_upload_bytes.load(std::memory_order_relaxed);
+    const std::uint64_t up_frames = g_upload_frames.load(std::memory_order_relaxed);
+    const std::uint64_t d_frames  = up_frames - g_report.upload_frames;
+    const std::uint64_t per_frame = d_frames ? (up_bytes - g_report.upload_bytes) / d_frames : 0;
+    g_report.upload_bytes  = up_bytes;
+    g_report.upload_frames = up_frames;
+
+    const std::string audio = g_audio ? std::format(" | audio fifo {:>4}, {} underruns, {} overruns", g_pcm->queued(),
+                                                    g_pcm->underrun_count(), g_pcm->overrun_count())
+                                      : std::string{};
+    std::cout << std::format("{:6.1f} MIPS host | budget {:>9} of {:>9} instr/frame ({:5.1f}% clock) | "
+                             "cpu {:5.2f} ms, frame {:5.2f} ms, idle {:5.1f}% | L1 hit {:5.1f}% | upload {:>5} B/frame{}{}\n",
+                             g_pacer->mips(), g_pacer->budget(), g_pacer->target(), g_pacer->clock_ratio() * 100,
+                             g_pacer->cpu_ms(), g_pacer->frame_ms(), g_pacer->idle_ratio() * 100, g_report.hit_rate * 100, per_frame, audio,
+                             g_halted ? " | HALTED" : "");
+}
 
-    SDL_UpdateTexture(g_texture, nullptr, io->framebuffer, 128);
+/* one emulated frame: vsync, take input, run the budget, publish the picture */
+static void emulate_frame()
+{
+    const auto t0 = steady::now();
+    if (g_irq) g_irq->raise(IrqController::vsync);
+    apply_input();
+    const FrameRun ran = run_cpu(g_pacer->budget());
+    const auto t1 = steady::now();
+
+    const double frame_s = g_last_frame == steady::time_point{} ? 0.0
+                         : std::chrono::duration<double>(t0 - g_last_frame).count();
+    g_last_frame = t0;
+    g_pacer->end_frame(ran.executed, std::chrono::duration<double>(t1 - t0).count(), frame_s, ran.idle);
+    update_report(t0);
+
+    Frame& f = g_frames.back();
+    std::memcpy(f.pixels.data(), io->framebuffer, f.pixels.size());
+    // the renderer only knows the frames it takes: if the last one is still unread it
+    // may be replaced unseen, so this frame must carry its changes as well
+    f.dirty = io->fb_dirty;
+    io->fb_dirty.clear();
+    if (g_frames.pending()) f.dirty |= g_published_dirty;
+    g_published_dirty = f.dirty;
+    f.stats = { g_pacer->mips(), g_pacer->frame_ms(), g_pacer->cpu_ms(), g_pacer->clock_ratio(),
+                g_report.hit_rate, g_pacer->budget(), g_pacer->target(), g_halted };
+    g_frames.publish();
+}
+
+#if RV_GAME_CPU_THREAD
+/* emulate at the pacer's frame rate until asked to stop */
+static void cpu_thread(std::stop_token stop)
+{
+    const auto period = std::chrono::duration_cast<steady::duration>(std::chrono::duration<double>(g_pacer->period()));
+    auto next = steady::now();
+    while (!stop.stop_requested()) {
+        emulate_frame();
+        next += period;
+        const auto now = steady::now();
+        if (next > now) std::this_thread::sleep_until(next);
+        else            next = now;   // fell behind: don't try to catch up with a burst
+    }
+}
+
+static std::jthread g_cpu_thread;
+#endif
+
+/* ------------------------------------------------------------------ */
+/* audio side (SDL's audio thread)                                    */
+/* ------------------------------------------------------------------ */
+static void audio_callback(void* user, Uint8* stream, int len)
+{
+    auto* pcm = static_cast<PcmAudioDevice*>(user);
+    pcm->drain({ reinterpret_cast<std::int16_t*>(stream), static_cast<std::size_t>(len) / sizeof(std::int16_t) });
+}
+
+/* start playback of the guest's PCM device; silent (but running) if either is missing */
+static void open_audio()
+{
+    if (!g_pcm) return;
+
+    SDL_AudioSpec want{}, have{};
+    want.freq     = PcmAudioDevice::sample_rate;
+    want.format   = AUDIO_S16SYS;
+    want.channels = 1;
+    want.samples  = 512;   // ~23 ms per callback
+    want.callback = audio_callback;
+    want.userdata = g_pcm;
+    g_audio = SDL_OpenAudioDevice(nullptr, 0, &want, &have, 0);
+    if (!g_audio) {
+        std::cerr << "no audio: " << SDL_GetError() << '\n';
+        return;
+    }
+    SDL_PauseAudioDevice(g_audio, 0);
+}
+
+/* ------------------------------------------------------------------ */
+/* render side (main thread)                                          */
+/* ------------------------------------------------------------------ */
+static bool g_overlay = true;
+static bool g_quit    = false;
+static bool g_redraw  = true;    // present even without new pixels (first frame, window exposed)
+
+/* what the texture holds: the frame plus the overlay, kept so partial uploads have a source */
+static std::array<std::uint8_t, 128 * 128> g_display{};
+static bool                                g_texture_valid = false;
+
+constexpr int overlay_line   = text::BitmapFont::charHeight + 1;
+constexpr int overlay_height = 3 * overlay_line + 1;
+static bool        g_overlay_shown = false;   // as of the last upload
+static std::string g_overlay_text;
+
+static void handle_events()
+{
+    SDL_Event e;
+    while (SDL_PollEvent(&e)) {
+        if (e.type == SDL_QUIT) g_quit = true;
+        if (e.type == SDL_WINDOWEVENT) g_redraw = true;
+        if ((e.type == SDL_KEYDOWN || e.type == SDL_KEYUP) && !e.key.repeat) {
+            if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_F1) g_overlay = !g_overlay;
+            if (const std::uint8_t b = button_for(e.key.keysym.sym))
+                (void)g_input.try_push({ b, e.type == SDL_KEYDOWN }); // a full queue drops the edge rather than block
+        }
+    }
+}
+
+static std::array<std::string, 3> overlay_lines(const FrameStats& s)
+{
+    return { std::format("MIPS {:.1f}", s.mips),
+             std::format("FRAME {:.1f}", s.frame_ms),
+             std::format("HIT {:.1f}%", s.hit_rate * 100) };
+}
+
+static void draw_overlay(const std::array<std::string, 3>& lines)
+{
+    std::memset(g_display.data(), 0x00, 128 * overlay_height); // dark band behind the text
+    for (int i = 0; i < 3; ++i)
+        text::BitmapFont::drawText(g_display.data(), 128, 128, 1, 1 + i * overlay_line, lines[i], 0xFF);
+}
+
+/*
+Bring the texture up to date with `f`: copy its dirty tiles into g_display, redraw the
+overlay if it or anything under it changed, and upload only those rectangles.
+*/
+static void upload(const Frame& f)
+{
+    DirtyTiles dirty = g_texture_valid ? f.dirty : DirtyTiles{};
+    if (!g_texture_valid) dirty.mark_all();
+
+    std::array<std::string, 3> lines;
+    if (g_overlay) {
+        lines = overlay_lines(f.stats);
+        const std::string text = lines[0] + lines[1] + lines[2];
+        if (!g_overlay_shown || text != g_overlay_text || dirty.any_in_rows(0, overlay_height))
+            dirty.mark_rect(0, 0, 128, overlay_height);
+        g_overlay_text = text;
+    } else if (g_overlay_shown) {
+        dirty.mark_rect(0, 0, 128, overlay_height); // uncover the frame
+    }
+    g_overlay_shown = g_overlay;
+    if (!dirty.any()) return;
+
+    dirty.for_each_rect([&](const DirtyTiles::Rect& r) {
+        for (int y = r.y; y < r.y + r.h; ++y)
+            std::memcpy(&g_display[static_cast<std::size_t>(y * 128 + r.x)], &f.pixels[static_cast<std::size_t>(y * 128 + r.x)],
+                        static_cast<std::size_t>(r.w));
+    });
+    if (g_overlay) draw_overlay(lines);
+
+    std::uint64_t bytes = 0;
+    dirty.for_each_rect([&](const DirtyTiles::Rect& r) {
+        const SDL_Rect rect{ r.x, r.y, r.w, r.h };
+        SDL_UpdateTexture(g_texture, &rect, &g_display[static_cast<std::size_t>(r.y * 128 + r.x)], 128);
+        bytes += static_cast<std::uint64_t>(r.w * r.h);
+    });
+    g_upload_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    g_texture_valid = true;
+    g_redraw        = true;
+}
+
+static void render_frame()            // called ~60 fps by the browser, or by the native loop below
+{
+    handle_events();
+#ifdef __EMSCRIPTEN__
+    if (g_quit) {
+#  if RV_GAME_CPU_THREAD
+        g_cpu_thread.request_stop();
+        g_cpu_thread.join();
+#  endif
+        emscripten_cancel_main_loop();
+        return;
+    }
+#endif
+#if !RV_GAME_CPU_THREAD
+    emulate_frame();
+#endif
+
+    // upload only when the CPU finished a new frame, and present only when something changed
+    if (g_frames.acquire()) {
+        upload(g_frames.front());
+        g_upload_frames.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (!g_redraw) return;
+    g_redraw = false;
     SDL_RenderClear(g_renderer);
     SDL_RenderCopy(g_renderer, g_texture, nullptr, nullptr);
     SDL_RenderPresent(g_renderer);
-
-    /* basic quit handling: if user closed tab → main loop auto-ends       */
 }
-#endif
 
-int main() {
+int main(int argc, char** argv) {
+    const double clock_mhz = argc > 1 ? std::atof(argv[1]) : 20.0;
+
     build_system(io, cpu);
     if (!io || !io->framebuffer) {
         std::cerr << "Failed to initialise RISC-V system\n";
         return EXIT_FAILURE;
     }
-    if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) != 0) {
         std::cerr << "SDL_Init error: " << SDL_GetError() << '\n';
         return EXIT_FAILURE;
     }
@@ -52,34 +407,47 @@ int main() {
                                          SDL_PIXELFORMAT_RGB332,
                                          SDL_TEXTUREACCESS_STREAMING,
                                          128, 128);
-
-    // 3. Main loop – blit FB to the screen every ~16 ms
-#ifdef __EMSCRIPTEN__
-    /* hand control to the browser */
     g_renderer = ren;
     g_texture  = tex;
-    emscripten_set_main_loop(frame, 0, /*simulate_infinite_loop=*/true);
+
+    FramePacer pacer{ { .clock_hz = (clock_mhz > 0 ? clock_mhz : 20.0) * 1e6 } };
+    g_pacer         = &pacer;
+    g_report.since  = steady::now();
+    for (const auto& r : io->regions()) {
+        if (auto* pcm = dynamic_cast<PcmAudioDevice*>(r.device.get())) g_pcm = pcm;
+        if (auto* irq = dynamic_cast<IrqController*>(r.device.get())) g_irq = irq;
+    }
+    open_audio();
+
+    // 3. Start the CPU, then show its frames as they come
+#if RV_GAME_CPU_THREAD
+    g_cpu_thread = std::jthread{ cpu_thread };
+#endif
+#ifdef __EMSCRIPTEN__
+    /* hand control to the browser (requestAnimationFrame paces us) */
+    emscripten_set_main_loop(render_frame, 0, /*simulate_infinite_loop=*/true);
 #else
-    /* native desktop: traditional loop                                   */
-    bool quit = false;
-    SDL_Event e;
-    while (!quit) {
-        while (SDL_PollEvent(&e)) {
-            if (e.type == SDL_QUIT) quit = true;
-        }
-        /* render */
-        SDL_UpdateTexture(tex, nullptr, io->framebuffer, 128);
-        SDL_RenderClear(ren);
-        SDL_RenderCopy(ren, tex, nullptr, nullptr);
-        SDL_RenderPresent(ren);
-        SDL_Delay(16);          // ~60 fps
+    /* native desktop: render at the display rate; the CPU thread keeps its own pace */
+    const auto period = std::chrono::duration_cast<steady::duration>(std::chrono::duration<double>(pacer.period()));
+    auto next = steady::now();
+    while (!g_quit) {
+        render_frame();
+        next += period;
+        const auto now = steady::now();
+        if (next > now)
+            SDL_Delay(static_cast<Uint32>(std::chrono::duration_cast<std::chrono::milliseconds>(next - now).count()));
+        else
+            next = now;
     }
+    g_cpu_thread.request_stop();
+    g_cpu_thread.join();
 #endif
 
     // 4. Clean-up
+    if (g_audio) SDL_CloseAudioDevice(g_audio);
     SDL_DestroyTexture(tex);
     SDL_DestroyRenderer(ren);
     SDL_DestroyWindow(win);
     SDL_Quit();
     return 0;
-}
\ No newline at end of file
+}
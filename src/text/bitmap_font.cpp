@@ -5,7 +5,7 @@ namespace text {
 /*
 set of glyphs
 */
-static constexpr std::array<std::pair<char,Glyph>, 32> glyphTable{{
+static constexpr std::array<std::pair<char,Glyph>, 44> glyphTable{{
     // Space
     {' ', {8,8,{ 0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00 }}},
 
@@ -15,6 +15,20 @@ static constexpr std::array<std::pair<char,Glyph>, 32> glyphTable{{
     {',', {8,8,{ 0x00,0x00,0x00,0x00,0x00,0x18,0x18,0x30 }}},
     {'?', {8,8,{ 0x3C,0x66,0x0C,0x18,0x18,0x00,0x18,0x00 }}},
     {'!', {8,8,{ 0x18,0x18,0x18,0x18,0x18,0x00,0x18,0x00 }}},
+    {':', {8,8,{ 0x00,0x18,0x18,0x00,0x00,0x18,0x18,0x00 }}},
+    {'%', {8,8,{ 0x62,0x66,0x0C,0x18,0x30,0x66,0x46,0x00 }}},
+
+    // Digits 0-9
+    {'0',{8,8,{ 0x3C,0x66,0x6E,0x76,0x66,0x66,0x3C,0x00 }}},
+    {'1',{8,8,{ 0x18,0x38,0x18,0x18,0x18,0x18,0x7E,0x00 }}},
+    {'2',{8,8,{ 0x3C,0x66,0x06,0x0C,0x30,0x60,0x7E,0x00 }}},
+    {'3',{8,8,{ 0x3C,0x66,0x06,0x1C,0x06,0x66,0x3C,0x00 }}},
+    {'4',{8,8,{ 0x0C,0x1C,0x3C,0x6C,0x7E,0x0C,0x0C,0x00 }}},
+    {'5',{8,8,{ 0x7E,0x60,0x7C,0x06,0x06,0x66,0x3C,0x00 }}},
+    {'6',{8,8,{ 0x3C,0x66,0x60,0x7C,0x66,0x66,0x3C,0x00 }}},
+    {'7',{8,8,{ 0x7E,0x66,0x0C,0x18,0x18,0x18,0x18,0x00 }}},
+    {'8',{8,8,{ 0x3C,0x66,0x66,0x3C,0x66,0x66,0x3C,0x00 }}},
+    {'9',{8,8,{ 0x3C,0x66,0x66,0x3E,0x06,0x66,0x3C,0x00 }}},
 
     // Alphabet A-Z
     {'A',{8,8,{ 0x18,0x3C,0x66,0x66,0x7E,0x66,0x66,0x00 }}},